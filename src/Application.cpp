@@ -2,8 +2,12 @@
 
 #include "Application.h"
 #include "D3d12Context.h"
-#include <climits>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <mmsystem.h>
 #include <random>
+#include <string>
 
 namespace Vnm
 {
@@ -14,86 +18,48 @@ namespace Vnm
     constexpr uint32_t TiltUpBit      = 1 << 4;
     constexpr uint32_t TiltDownBit    = 1 << 5;
 
+    // Requests from the window thread, carried out by the simulation thread
+    constexpr uint32_t ToggleCameraRequest = 1 << 0;
+    constexpr uint32_t SaveSnapshotRequest = 1 << 1;
+    constexpr uint32_t LoadSnapshotRequest = 1 << 2;
+
     const DirectX::XMVECTOR GameCameraOffset = DirectX::XMVectorSet(5.0f, 0.0f, 0.0f, 0.0f);
 
-    const DirectX::XMVECTOR WallColorXmin = DirectX::XMVectorSet(1.0f, 0.4f, 0.4f, 1.0f);
-    const DirectX::XMVECTOR WallColorXmax = DirectX::XMVectorSet(1.0f, 0.4f, 1.0f, 1.0f);
-    const DirectX::XMVECTOR WallColorYmin = DirectX::XMVectorSet(0.4f, 0.4f, 1.0f, 1.0f);
-    const DirectX::XMVECTOR WallColorYmax = DirectX::XMVectorSet(0.4f, 1.0f, 1.0f, 1.0f);
-    const DirectX::XMVECTOR WallColorZmin = DirectX::XMVectorSet(0.4f, 1.0f, 0.4f, 1.0f);
-    const DirectX::XMVECTOR WallColorZmax = DirectX::XMVectorSet(1.0f, 1.0f, 0.4f, 1.0f);
+    // The simulation thread updates once per step, and never runs more than this many steps per update, so a long
+    // stall doesn't snowball into ever longer updates
+    constexpr std::chrono::steady_clock::duration StepTime =
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::seconds(1)) / Snake::Simulation::StepsPerSecond;
+    constexpr int MaxStepsPerUpdate = 8;
 
-    static void SetupWalls(Snake::GameBoard& gameBoard)
-    {
-        // Place pieces around the borders
-        for (int i = 0; i < Snake::NumPiecesX; i++)
-        {
-            for (int j = 0; j < Snake::NumPiecesY; j++)
-            {
-                for (int k = 0; k < Snake::NumPiecesZ; k++)
-                {
-                    if ((i == 0) || (i == Snake::NumPiecesX - 1) ||
-                        (j == 0) || (j == Snake::NumPiecesY - 1) ||
-                        (k == 0) || (k == Snake::NumPiecesZ - 1))
-                    {
-                        DirectX::XMVECTOR color;
-                        if (i == 0)
-                        {
-                            color = WallColorXmin;
-                        }
-                        else if (i == Snake::NumPiecesX - 1)
-                        {
-                            color = WallColorXmax;
-                        }
-                        else if (j == 0)
-                        {
-                            color = WallColorYmin;
-                        }
-                        else if (j == Snake::NumPiecesY - 1)
-                        {
-                            color = WallColorYmax;
-                        }
-                        else if (k == 0)
-                        {
-                            color = WallColorZmin;
-                        }
-                        else if (k == Snake::NumPiecesZ - 1)
-                        {
-                            color = WallColorZmax;
-                        }
-
-                        gameBoard.PlaceGamePiece(i, j, k, color, INT_MAX, Snake::GamePieceType::Wall);
-                    }
-                }
-            }
-        }
-    }
+    // Latest game, overwritten when the next one starts; snake3d_headless --verify checks it
+    constexpr const char* ReplayPath = "Snake3D.replay";
 
-    static void PlacePowerUp(Snake::GameBoard& gameBoard)
-    {
-        const DirectX::XMVECTOR color = DirectX::XMVectorSet(0.7f, 0.8f, 1.0f, 1.0f);
+    // Quick save slot, F5 to save and F9 to load
+    constexpr const char* SnapshotPath = "Snake3D.snapshot";
 
-        static std::random_device randomDevice;
-        static std::mt19937 randomGenerator(randomDevice());
-        using DistributionType = std::uniform_int_distribution <std::mt19937::result_type>;
-        static DistributionType distributionX(0, Snake::NumPiecesX - 1);
-        static DistributionType distributionY(0, Snake::NumPiecesY - 1);
-        static DistributionType distributionZ(0, Snake::NumPiecesZ - 1);
+    // Snapshot camera slots
+    constexpr int SnapshotFreeCamera = 0;
+    constexpr int SnapshotGameCamera = 1;
 
-        int x = distributionX(randomGenerator);
-        int y = distributionY(randomGenerator);
-        int z = distributionZ(randomGenerator);
+    // Path following --replay on the command line, optionally quoted; empty if absent
+    static std::string FindReplayArgument(const char* commandLine)
+    {
+        const char* argument = strstr(commandLine, "--replay ");
+        if (argument == nullptr)
+        {
+            return std::string();
+        }
 
-        // TODO: Will possibly endless loop at the very end of the game, check for win condition
-        while (gameBoard.GetGamePiece(x, y, z) != nullptr)
+        argument += strlen("--replay ");
+        while (*argument == ' ')
         {
-            // If random place is already occupied, find another
-            x = distributionX(randomGenerator);
-            y = distributionY(randomGenerator);
-            z = distributionZ(randomGenerator);
+            argument++;
         }
 
-        gameBoard.PlaceGamePiece(x, y, z, color, INT_MAX, Snake::GamePieceType::PowerUp);
+        const char terminator = *argument == '"' ? '"' : ' ';
+        argument += terminator == '"' ? 1 : 0;
+        const char* end = strchr(argument, terminator);
+        return end != nullptr ? std::string(argument, end) : std::string(argument);
     }
 
     void Application::Startup(HINSTANCE instance, int cmdShow)
@@ -105,23 +71,78 @@ namespace Vnm
         winDesc.mParentApplication = this;
         mWindow.Create(instance, cmdShow, winDesc);
 
-        Init(mWindow.GetHandle());
-        mSnake.SetPosition(DirectX::XMVectorSet(5.0f, 5.0f, 5.0f, 0.0f));
+        mRenderer.Init(mWindow.GetHandle());
         mFreeCamera.SetPosition(DirectX::XMVectorSet(5.0f, 5.0f, 5.0f, 0.0f));
 
-        mGameBoard.Init();
-        SetupWalls(mGameBoard);
-        PlacePowerUp(mGameBoard);
+        // "--replay <file>" watches a recorded game instead of playing one
+        std::string replayPath = FindReplayArgument(GetCommandLineA());
+        mIsPlayback = !replayPath.empty() && mPlayback.Open(replayPath.c_str()) &&
+            mPlayback.GetHeader().GetLayout() == mSimulation.GetBoard().GetLayout();
+        if (mIsPlayback)
+        {
+            mSimulation.Reset(mPlayback.GetHeader().mSeed);
+        }
+        else
+        {
+            StartGame();
+        }
+
+        // Sleeps on the simulation thread need millisecond precision to hold the step rate
+        timeBeginPeriod(1);
+        mLastUpdateTime = std::chrono::steady_clock::now();
+        mSimulationThread.Start(StepTime, [this](Snake::RenderFrame& frameOut) { UpdateSimulation(frameOut); });
     }
 
     void Application::Reset()
     {
-        mSnake.SetPosition(DirectX::XMVectorSet(5.0f, 5.0f, 5.0f, 0.0f));
-        mSnake.ResetBasis();
-        mGameBoard.Reset();
-        SetupWalls(mGameBoard);
-        PlacePowerUp(mGameBoard);
-        mPlayerState.mBodyLength = 1;
+        mReplay.Close(mSimulation);
+        StartGame();
+        mStepAccumulator = std::chrono::steady_clock::duration::zero();
+    }
+
+    void Application::StartGame()
+    {
+        // Interactive games get a fresh seed; everything after this is deterministic, so the seed and the inputs
+        // recorded each step are enough to replay the game
+        std::random_device randomDevice;
+        uint64_t seed = (static_cast<uint64_t>(randomDevice()) << 32) | randomDevice();
+        mSimulation.Reset(seed);
+        mReplay.Open(ReplayPath, seed, mSimulation.GetBoard().GetLayout());
+    }
+
+    static Snake::SnapshotCamera ToSnapshotCamera(const Camera& camera)
+    {
+        Snake::SnapshotCamera snapshotCamera;
+        DirectX::XMStoreFloat3(reinterpret_cast<DirectX::XMFLOAT3*>(snapshotCamera.mPosition), camera.GetPosition());
+        DirectX::XMStoreFloat3(reinterpret_cast<DirectX::XMFLOAT3*>(snapshotCamera.mForward), camera.GetForward());
+        DirectX::XMStoreFloat3(reinterpret_cast<DirectX::XMFLOAT3*>(snapshotCamera.mUp), camera.GetUp());
+        DirectX::XMStoreFloat3(reinterpret_cast<DirectX::XMFLOAT3*>(snapshotCamera.mRight), camera.GetRight());
+        return snapshotCamera;
+    }
+
+    static Camera ToCamera(const Snake::SnapshotCamera& snapshotCamera)
+    {
+        return Camera(
+            DirectX::XMLoadFloat3(reinterpret_cast<const DirectX::XMFLOAT3*>(snapshotCamera.mPosition)),
+            DirectX::XMLoadFloat3(reinterpret_cast<const DirectX::XMFLOAT3*>(snapshotCamera.mForward)),
+            DirectX::XMLoadFloat3(reinterpret_cast<const DirectX::XMFLOAT3*>(snapshotCamera.mUp)),
+            DirectX::XMLoadFloat3(reinterpret_cast<const DirectX::XMFLOAT3*>(snapshotCamera.mRight)));
+    }
+
+    static DirectX::XMVECTOR ToVector(const int v[3])
+    {
+        return DirectX::XMVectorSet(static_cast<float>(v[0]), static_cast<float>(v[1]), static_cast<float>(v[2]), 0.0f);
+    }
+
+    // Game keys map one to one onto simulation inputs
+    static uint32_t ToSimulationInputs(uint32_t key)
+    {
+        uint32_t inputs = 0;
+        inputs |= (key & TurnLeftBit) ? Snake::InputTurnLeft : 0;
+        inputs |= (key & TurnRightBit) ? Snake::InputTurnRight : 0;
+        inputs |= (key & TiltUpBit) ? Snake::InputTiltUp : 0;
+        inputs |= (key & TiltDownBit) ? Snake::InputTiltDown : 0;
+        return inputs;
     }
 
     static void HandleMovement(uint32_t key, Camera& camera)
@@ -155,115 +176,86 @@ namespace Vnm
         }
     }
 
-    static void HandleMovementGame(uint32_t key, Camera& camera)
+    // Runs on the simulation thread, once per step time
+    void Application::UpdateSimulation(Snake::RenderFrame& frameOut)
     {
-        const float rotationScale = 0.5f;
-        const float forwardScale = 0.025f;
+        std::chrono::steady_clock::time_point updateTime = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::duration elapsedTime = updateTime - mLastUpdateTime;
+        mLastUpdateTime = updateTime;
 
-        camera.MoveForward(forwardScale);
-
-        if (key & TurnLeftBit)
+        uint32_t requests = mRequests.exchange(0, std::memory_order_acquire);
+        if (requests != 0)
         {
-            camera.Yaw(-DirectX::XM_PI * rotationScale);
+            TakeInputTime();
         }
-        if (key & TurnRightBit)
+        if (requests & ToggleCameraRequest)
         {
-            camera.Yaw(DirectX::XM_PI * rotationScale);
+            ToggleGameState();
         }
-        if (key & TiltDownBit)
+        if (requests & SaveSnapshotRequest)
         {
-            camera.Pitch(DirectX::XM_PI * rotationScale);
+            SaveSnapshot();
         }
-        if (key & TiltUpBit)
+        if (requests & LoadSnapshotRequest)
         {
-            camera.Pitch(-DirectX::XM_PI * rotationScale);
+            LoadSnapshot();
         }
-    }
-
-    void Application::Mainloop()
-    {
-        static uint32_t lastTime = GetTickCount();
-        uint32_t elapsedTime = GetTickCount() - lastTime;
-        lastTime = GetTickCount();
-
-        const float timeScale = 0.001f;
-        float elapsedSeconds = static_cast<float>(elapsedTime) * timeScale;
 
         if (GameIsActive())
         {
-            HandleMovementGame(mMoveState, mSnake);
-            mMoveState = 0;
-
-            int xBlockCoord;
-            int yBlockCoord;
-            int zBlockCoord;
-            mGameBoard.GetBlockCoords(mSnake.GetPosition(), xBlockCoord, yBlockCoord, zBlockCoord);
-
-            // Check if snake head has moved into a new block
-            if (xBlockCoord != mPlayerState.mCurBlockCoord[0] ||
-                yBlockCoord != mPlayerState.mCurBlockCoord[1] ||
-                zBlockCoord != mPlayerState.mCurBlockCoord[2])
+            // Step the simulation at its fixed rate however the thread is scheduled
+            mStepAccumulator = std::min(mStepAccumulator + elapsedTime, StepTime * MaxStepsPerUpdate);
+
+            while (mStepAccumulator >= StepTime)
             {
-                // Test for intersection
-                const Snake::GamePiece* gamePiece = mGameBoard.GetGamePiece(xBlockCoord, yBlockCoord, zBlockCoord);
-                if (gamePiece == nullptr)
+                mStepAccumulator -= StepTime;
+
+                uint32_t inputs = 0;
+                if (mIsPlayback)
                 {
-                    mGameBoard.PlaceGamePiece(xBlockCoord, yBlockCoord, zBlockCoord, DirectX::XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f), mPlayerState.mBodyLength, Snake::GamePieceType::SnakeBody);
+                    // Playback holds the final frame once the recorded game is over
+                    if (mSimulation.IsOver() || !mPlayback.NextTick(inputs))
+                    {
+                        break;
+                    }
                 }
                 else
                 {
-                    // Hitting wall or snake piece ends game
-                    if (gamePiece->mGamePieceType == Snake::GamePieceType::SnakeBody ||
-                        gamePiece->mGamePieceType == Snake::GamePieceType::Wall)
+                    // Key presses are one-shot; the first step after a press consumes them
+                    uint32_t keys = mMoveState.exchange(0, std::memory_order_acquire);
+                    if (keys != 0)
                     {
-                        Reset();
-                        ToggleGameState();
+                        TakeInputTime();
                     }
-
-                    // Powerup increases length
-                    if (gamePiece->mGamePieceType == Snake::GamePieceType::PowerUp)
+                    inputs = ToSimulationInputs(keys);
+                    if (mReplay.IsOpen())
                     {
-                        // Replace power-up with snake body piece
-                        mGameBoard.RemoveGamePiece(xBlockCoord, yBlockCoord, zBlockCoord);
-
-                        // Place a new power-up
-                        PlacePowerUp(mGameBoard);
-
-                        // Increase body length
-                        mGameBoard.PlaceGamePiece(xBlockCoord, yBlockCoord, zBlockCoord, DirectX::XMVectorSet(1.0f, 1.0f, 1.0f, 0.0f), ++mPlayerState.mBodyLength, Snake::GamePieceType::SnakeBody);
-
-                        // TODO: Test win condition
+                        mReplay.RecordTick(mSimulation, inputs);
                     }
                 }
 
-                mPlayerState.mCurBlockCoord[0] = xBlockCoord;
-                mPlayerState.mCurBlockCoord[1] = yBlockCoord;
-                mPlayerState.mCurBlockCoord[2] = zBlockCoord;
+                Snake::StepResult result = mSimulation.Step(inputs);
 
-                // Update pieces on board (excluding walls)
-                for (int i = 1; i < Snake::NumPiecesX - 1; i++)
+                // Hitting a wall or the body ends the game, as does filling the board
+                if (!mIsPlayback && (result == Snake::StepResult::Died || result == Snake::StepResult::Won))
                 {
-                    for (int j = 1; j < Snake::NumPiecesY - 1; j++)
-                    {
-                        for (int k = 1; k < Snake::NumPiecesZ - 1; k++)
-                        {
-                            Snake::GamePiece* gamePiece = mGameBoard.GetGamePiece(i, j, k);
-                            if (gamePiece == nullptr)
-                            {
-                                continue;
-                            }
-                            else if (gamePiece->mGamePieceType == Snake::GamePieceType::SnakeBody)
-                            {
-                                if (gamePiece->mRemainingTicks-- == 0)
-                                {
-                                    mGameBoard.RemoveGamePiece(i, j, k);
-                                }
-                            }
-                        }
-                    }
+                    Reset();
+                    ToggleGameState();
+                    break;
                 }
             }
 
+            // One write per update at most, however many steps ran
+            mReplay.Flush();
+
+            float headPosition[3];
+            mSimulation.GetHeadPosition(headPosition);
+            mSnake = Camera(
+                DirectX::XMVectorSet(headPosition[0], headPosition[1], headPosition[2], 0.0f),
+                ToVector(mSimulation.GetForward()),
+                ToVector(mSimulation.GetUp()),
+                ToVector(mSimulation.GetRight()));
+
             // Look at snake head from behind and above
             const float positionOffsetScale = 3.0f;
             static DirectX::XMVECTOR prevPositionOffset = DirectX::XMVectorSet(positionOffsetScale, 0.0f, 0.0f, 0.0f);
@@ -291,45 +283,112 @@ namespace Vnm
         }
         else
         {
-            HandleMovement(mMoveState, *mCurCamera);
+            uint32_t keys = mMoveState.load(std::memory_order_acquire);
+            if (keys != 0)
+            {
+                TakeInputTime();
+            }
+            HandleMovement(keys, *mCurCamera);
+            mStepAccumulator = std::chrono::steady_clock::duration::zero();
         }
 
-        Update( mCurCamera->CalcLookAt(), elapsedSeconds );
-        size_t numGamePieces;
-        const Snake::GamePiece* const* gamePieces = mGameBoard.GetGamePieces( &numGamePieces );
-        Render( gamePieces, numGamePieces, mCurCamera->CalcLookAt(), elapsedSeconds );
+        Snake::BuildRenderInstances(mSimulation.GetBoard(), frameOut.mInstances);
+        DirectX::XMStoreFloat4x4(reinterpret_cast<DirectX::XMFLOAT4X4*>(frameOut.mView), mCurCamera->CalcLookAt());
+        frameOut.mStepCount = mSimulation.GetStepCount();
+        frameOut.mInputs = mInputTimes;
+    }
+
+    // Records when the input about to be consumed arrived, so the render thread can time it until it shows
+    void Application::TakeInputTime()
+    {
+        std::chrono::steady_clock::time_point inputTime;
+        if (mPendingInput.Take(inputTime))
+        {
+            mInputTimes.Add(inputTime);
+        }
+    }
+
+    // Runs on the window thread; draws the newest state the simulation thread has published, or the previous one again
+    // if there is nothing newer, so neither thread ever waits for the other
+    void Application::Mainloop()
+    {
+        mSimulationThread.AcquireFrame();
+        const Snake::RenderFrame& frame = mSimulationThread.GetFrame();
+        DrawFrame(mRenderer, frame);
+
+        // Present has waited for vsync and the GPU, so this is about when the frame reaches the screen
+        mInputLatency.OnPresent(frame, std::chrono::steady_clock::now());
     }
 
     void Application::Shutdown()
     {
+        mSimulationThread.Stop();
+        mRenderer.Destroy();
+        mReplay.Close(mSimulation);
+        timeEndPeriod(1);
+
+        char report[256];
+        snprintf(report, sizeof(report), "Input latency: %llu inputs, mean %.1f ms, p99 %.1f ms, max %.1f ms\n",
+            static_cast<unsigned long long>(mInputLatency.GetCount()),
+            mInputLatency.GetMeanMilliseconds(),
+            mInputLatency.GetPercentileMilliseconds(0.99),
+            mInputLatency.GetMaxMilliseconds());
+        OutputDebugStringA(report);
+
         mWindow.Destroy();
     }
 
+    void Application::SaveSnapshot()
+    {
+        Snake::SnapshotCamera cameras[2];
+        cameras[SnapshotFreeCamera] = ToSnapshotCamera(mFreeCamera);
+        cameras[SnapshotGameCamera] = ToSnapshotCamera(mGameCamera);
+        Snake::SaveSnapshot(SnapshotPath, mSimulation, cameras, 2);
+    }
+
+    void Application::LoadSnapshot()
+    {
+        Snake::Snapshot snapshot;
+        if (!snapshot.Open(SnapshotPath) || !(snapshot.GetBoard().GetLayout() == mSimulation.GetBoard().GetLayout()) ||
+            !snapshot.Restore(mSimulation))
+        {
+            return;
+        }
+
+        mFreeCamera = ToCamera(snapshot.GetHeader().mCameras[SnapshotFreeCamera]);
+        mGameCamera = ToCamera(snapshot.GetHeader().mCameras[SnapshotGameCamera]);
+
+        // The loaded game no longer follows from a seed, so it goes unrecorded; playback carries on as a live game
+        mReplay.Close(mSimulation);
+        mIsPlayback = false;
+        mStepAccumulator = std::chrono::steady_clock::duration::zero();
+    }
+
     void Application::OnKeyUp(UINT8 key)
     {
         switch (key)
         {
         case VK_SPACE:
-            mMoveState &= ~MoveForwardBit;
+            mMoveState.fetch_and(~MoveForwardBit, std::memory_order_relaxed);
             break;
         case VK_SHIFT:
-            mMoveState &= ~MoveBackBit;
+            mMoveState.fetch_and(~MoveBackBit, std::memory_order_relaxed);
             break;
         case VK_LEFT:
         case 'A':
-            mMoveState &= ~TurnLeftBit;
+            mMoveState.fetch_and(~TurnLeftBit, std::memory_order_relaxed);
             break;
         case VK_RIGHT:
         case 'D':
-            mMoveState &= ~TurnRightBit;
+            mMoveState.fetch_and(~TurnRightBit, std::memory_order_relaxed);
             break;
         case VK_UP:
         case 'W':
-            mMoveState &= ~TiltDownBit;
+            mMoveState.fetch_and(~TiltDownBit, std::memory_order_relaxed);
             break;
         case VK_DOWN:
         case 'S':
-            mMoveState &= ~TiltUpBit;
+            mMoveState.fetch_and(~TiltUpBit, std::memory_order_relaxed);
             break;
         default: break;
         }
@@ -341,34 +400,54 @@ namespace Vnm
         mCurCamera = mCurCamera == &mFreeCamera ? &mGameCamera : &mFreeCamera;
     }
 
+    // Key presses are timed from here until the first frame that shows them; the time goes first, so the simulation
+    // thread never sees a press without it
+    void Application::PressKey(uint32_t moveBit)
+    {
+        mPendingInput.Mark(std::chrono::steady_clock::now());
+        mMoveState.fetch_or(moveBit, std::memory_order_release);
+    }
+
+    void Application::Request(uint32_t request)
+    {
+        mPendingInput.Mark(std::chrono::steady_clock::now());
+        mRequests.fetch_or(request, std::memory_order_release);
+    }
+
     void Application::OnKeyDown(UINT8 key)
     {
         switch (key)
         {
         case VK_TAB:
-            ToggleGameState();
+            Request(ToggleCameraRequest);
+            break;
+        case VK_F5:
+            Request(SaveSnapshotRequest);
+            break;
+        case VK_F9:
+            Request(LoadSnapshotRequest);
             break;
         case VK_SPACE:
-            mMoveState |= MoveForwardBit;
+            PressKey(MoveForwardBit);
             break;
         case VK_SHIFT:
-            mMoveState |= MoveBackBit;
+            PressKey(MoveBackBit);
             break;
         case VK_LEFT:
         case 'A':
-            mMoveState |= TurnLeftBit;
+            PressKey(TurnLeftBit);
             break;
         case VK_RIGHT:
         case 'D':
-            mMoveState |= TurnRightBit;
+            PressKey(TurnRightBit);
             break;
         case VK_UP:
         case 'W':
-            mMoveState |= TiltDownBit;
+            PressKey(TiltDownBit);
             break;
         case VK_DOWN:
         case 'S':
-            mMoveState |= TiltUpBit;
+            PressKey(TiltUpBit);
             break;
         default: break;
         }
@@ -4,23 +4,18 @@
 
 #include "Window.h"
 #include "Camera.h"
-#include "Snake3D.h"
+#include "D3d12Context.h"
+#include "Replay.h"
+#include "Simulation.h"
+#include "SimulationThread.h"
+#include "Snapshot.h"
+#include <atomic>
+#include <chrono>
 
 namespace Vnm
 {
     class Device;
 
-    class PlayerState
-    {
-    public:
-        PlayerState() = default;
-        ~PlayerState() = default;
-
-        // TODO: Perform better initialization and get rid of sentinel
-        int mCurBlockCoord[3] = { ~0, ~0, ~0 };
-        int mBodyLength = 1;
-    };
-
     class Application
     {
     public:
@@ -38,16 +33,40 @@ namespace Vnm
         bool GameIsActive() const { return mCurCamera == &mGameCamera; }
 
     private:
+        void UpdateSimulation(Snake::RenderFrame& frameOut);
+        void TakeInputTime();
+        void PressKey(uint32_t moveBit);
+        void Request(uint32_t request);
         void ToggleGameState();
+        void StartGame();
+        void SaveSnapshot();
+        void LoadSnapshot();
 
-        Snake::GameBoard mGameBoard;
+        // Owned by the simulation thread once it runs
+        Snake::Simulation mSimulation{ 0 };
+        Snake::ReplayWriter mReplay;
+        Snake::ReplayReader mPlayback;
+        bool                mIsPlayback = false;
+        std::chrono::steady_clock::time_point mLastUpdateTime;
+        std::chrono::steady_clock::duration   mStepAccumulator{};   // Wall-clock time not yet consumed by simulation steps
+        Snake::InputTimes   mInputTimes;
 
-        Window      mWindow;
-        PlayerState mPlayerState;
         Camera      mSnake;
         Camera      mFreeCamera;
         Camera      mGameCamera;
         Camera*     mCurCamera = &mFreeCamera;
-        uint32_t    mMoveState = 0;
+
+        // Written by the window thread, read by the simulation thread
+        std::atomic<uint32_t>   mMoveState{ 0 };
+        std::atomic<uint32_t>   mRequests{ 0 };
+        Snake::PendingInputTime mPendingInput;
+
+        // Owned by the window thread, which also renders
+        Window                   mWindow;
+        D3d12Renderer            mRenderer;
+        Snake::InputLatencyMeter mInputLatency;
+
+        // Last, so it is destroyed, stopping the thread, before anything the thread uses
+        Snake::SimulationThread mSimulationThread{ Snake::CalcMaxRenderInstances(Snake::DefaultGameBoard::Layout) };
     };
 }
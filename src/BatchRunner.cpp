@@ -0,0 +1,103 @@
+// BatchRunner.cpp
+
+#include "BatchRunner.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <chrono>
+
+namespace Snake
+{
+    namespace
+    {
+        // Everything one worker touches while playing, padded so workers never share a cache line
+        class alignas(64) WorkerState
+        {
+        public:
+            std::unique_ptr<Simulation> mSimulation;
+            std::unique_ptr<Policy>     mPolicy;
+            std::vector<GameResult>     mResults;
+        };
+
+        GameEnd ToGameEnd(GameOverCause cause)
+        {
+            switch (cause)
+            {
+            case GameOverCause::HitWall:
+                return GameEnd::HitWall;
+            case GameOverCause::HitBody:
+                return GameEnd::HitBody;
+            case GameOverCause::BoardFull:
+                return GameEnd::BoardFull;
+            default:
+                return GameEnd::StepLimit;
+            }
+        }
+    }
+
+    GameResult RunGame(Simulation& simulation, Policy& policy, uint64_t seed, uint64_t maxSteps)
+    {
+        simulation.Reset(seed);
+        policy.Reset(seed);
+
+        StepResult result = StepResult::EnteredCell;
+        while (!simulation.IsOver() && simulation.GetStepCount() < maxSteps)
+        {
+            result = simulation.Step(policy.ChooseInputs(simulation, result));
+        }
+
+        GameResult gameResult;
+        gameResult.mSeed = seed;
+        gameResult.mNumSteps = simulation.GetStepCount();
+        gameResult.mLength = static_cast<uint32_t>(simulation.GetBodyLength());
+        gameResult.mScore = gameResult.mLength - 1;
+        gameResult.mEnd = ToGameEnd(simulation.GetGameOverCause());
+        return gameResult;
+    }
+
+    BatchResult RunBatch(Vnm::WorkStealingPool& pool, const BatchConfig& config)
+    {
+        size_t numWorkers = pool.GetNumThreads();
+        std::unique_ptr<WorkerState[]> workers(new WorkerState[numWorkers]);
+        for (size_t i = 0; i < numWorkers; i++)
+        {
+            workers[i].mSimulation = std::make_unique<Simulation>(config.mFirstSeed);
+            workers[i].mPolicy = CreatePolicy(config.mPolicy);
+            workers[i].mResults.reserve(static_cast<size_t>(config.mNumGames / numWorkers + config.mGamesPerTask));
+        }
+
+        uint64_t gamesPerTask = std::max<uint64_t>(config.mGamesPerTask, 1);
+        size_t numTasks = static_cast<size_t>((config.mNumGames + gamesPerTask - 1) / gamesPerTask);
+
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        pool.ParallelFor(numTasks, [&](size_t workerIndex, size_t taskIndex)
+        {
+            WorkerState& worker = workers[workerIndex];
+            uint64_t firstGame = taskIndex * gamesPerTask;
+            uint64_t lastGame = std::min(firstGame + gamesPerTask, config.mNumGames);
+            for (uint64_t game = firstGame; game < lastGame; game++)
+            {
+                worker.mResults.push_back(RunGame(*worker.mSimulation, *worker.mPolicy, config.mFirstSeed + game, config.mMaxStepsPerGame));
+            }
+        });
+
+        BatchResult batchResult;
+        batchResult.mElapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        // Merge per-worker buffers back into seed order
+        batchResult.mGames.reserve(static_cast<size_t>(config.mNumGames));
+        for (size_t i = 0; i < numWorkers; i++)
+        {
+            batchResult.mGames.insert(batchResult.mGames.end(), workers[i].mResults.begin(), workers[i].mResults.end());
+        }
+        std::sort(batchResult.mGames.begin(), batchResult.mGames.end(),
+            [](const GameResult& a, const GameResult& b) { return a.mSeed < b.mSeed; });
+
+        for (const GameResult& game : batchResult.mGames)
+        {
+            batchResult.mNumSteps += game.mNumSteps;
+        }
+
+        return batchResult;
+    }
+
+} // namespace Snake
@@ -0,0 +1,60 @@
+// BatchRunner.h
+
+#pragma once
+
+#include "Policy.h"
+#include "Simulation.h"
+#include <vector>
+
+namespace Vnm
+{
+    class WorkStealingPool;
+}
+
+namespace Snake
+{
+    enum class GameEnd : uint8_t
+    {
+        HitWall,
+        HitBody,
+        BoardFull,
+        StepLimit,      // Still alive after the step limit
+    };
+
+    class GameResult
+    {
+    public:
+        uint64_t mSeed;
+        uint64_t mNumSteps;
+        uint32_t mLength;
+        uint32_t mScore;        // Power-ups eaten
+        GameEnd  mEnd;
+    };
+
+    class BatchConfig
+    {
+    public:
+        PolicyType mPolicy = PolicyType::Greedy;
+        uint64_t   mFirstSeed = 1;
+        uint64_t   mNumGames = 100;             // Games use seeds [mFirstSeed, mFirstSeed + mNumGames)
+        uint64_t   mMaxStepsPerGame = 100000;
+        uint64_t   mGamesPerTask = 16;          // Granularity of work stealing
+    };
+
+    class BatchResult
+    {
+    public:
+        std::vector<GameResult> mGames;         // Ordered by seed, whatever order the games ran in
+        uint64_t mNumSteps = 0;
+        double   mElapsedSeconds = 0.0;
+    };
+
+    // Plays a single game with the given seed
+    GameResult RunGame(Simulation& simulation, Policy& policy, uint64_t seed, uint64_t maxSteps);
+
+    // Shards a seed range across every thread of the pool
+    // Each worker plays its games on its own Simulation and Policy and appends to its own result buffer; the buffers are
+    // merged once all games are done, so workers share nothing while games run
+    BatchResult RunBatch(Vnm::WorkStealingPool& pool, const BatchConfig& config);
+
+} // namespace Snake
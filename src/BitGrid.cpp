@@ -0,0 +1,162 @@
+// BitGrid.cpp
+
+#include "BitGrid.h"
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+
+namespace Snake
+{
+    namespace
+    {
+        // Word w of the bit string moved toward higher indices by shift bits
+        inline uint64_t ShiftUp(const uint64_t* words, ptrdiff_t w, size_t shift)
+        {
+            ptrdiff_t wordShift = static_cast<ptrdiff_t>(shift >> 6);
+            unsigned bitShift = static_cast<unsigned>(shift & 63);
+            const uint64_t* source = words + w - wordShift;
+            return bitShift == 0 ? source[0] : (source[0] << bitShift) | (source[-1] >> (64 - bitShift));
+        }
+
+        // Word w of the bit string moved toward lower indices by shift bits
+        inline uint64_t ShiftDown(const uint64_t* words, ptrdiff_t w, size_t shift)
+        {
+            ptrdiff_t wordShift = static_cast<ptrdiff_t>(shift >> 6);
+            unsigned bitShift = static_cast<unsigned>(shift & 63);
+            const uint64_t* source = words + w + wordShift;
+            return bitShift == 0 ? source[0] : (source[0] >> bitShift) | (source[1] << (64 - bitShift));
+        }
+    }
+
+    BitGrid::BitGrid(const BoardLayout& layout)
+        : mNumWords((layout.GetNumCells() + 63) / 64)
+    {
+        mStrides[0] = 1;
+        mStrides[1] = layout.GetNumPieces(0);
+        mStrides[2] = layout.GetNumPieces(0) * layout.GetNumPieces(1);
+        mNumGuardWords = mStrides[2] / 64 + 2;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            mNeighbourOffsets[2 * axis] = static_cast<ptrdiff_t>(mStrides[axis]);
+            mNeighbourOffsets[2 * axis + 1] = -static_cast<ptrdiff_t>(mStrides[axis]);
+        }
+
+        mStorage.assign(mNumWords + 2 * mNumGuardWords, 0);
+    }
+
+    void BitGrid::Clear()
+    {
+        if (mBeginWord < mEndWord)
+        {
+            memset(Words() + mBeginWord, 0, (mEndWord - mBeginWord) * sizeof(uint64_t));
+        }
+        mBeginWord = 0;
+        mEndWord = 0;
+    }
+
+    void BitGrid::Set(size_t cellIndex)
+    {
+        size_t w = cellIndex >> 6;
+        Words()[w] |= uint64_t(1) << (cellIndex & 63);
+
+        if (mBeginWord == mEndWord)
+        {
+            mBeginWord = w;
+            mEndWord = w + 1;
+        }
+        else
+        {
+            mBeginWord = std::min(mBeginWord, w);
+            mEndWord = std::max(mEndWord, w + 1);
+        }
+    }
+
+    size_t BitGrid::Count() const
+    {
+        size_t count = 0;
+        const uint64_t* words = Words();
+        for (size_t w = mBeginWord; w < mEndWord; w++)
+        {
+            count += std::bitset<64>(words[w]).count();
+        }
+        return count;
+    }
+
+    void BitGrid::SetFromTypes(const GameBoard& board, GamePieceType type)
+    {
+        const GamePieceType* types = board.GetGamePieceTypes();
+        size_t numCells = board.GetNumCells();
+        uint64_t* words = Words();
+
+        for (size_t w = 0; w < mNumWords; w++)
+        {
+            size_t first = w * 64;
+            size_t count = std::min<size_t>(numCells - first, 64);
+
+            uint64_t word = 0;
+            for (size_t bit = 0; bit < count; bit++)
+            {
+                word |= static_cast<uint64_t>(types[first + bit] == type) << bit;
+            }
+            words[w] |= word;
+        }
+
+        mBeginWord = 0;
+        mEndWord = mNumWords;
+    }
+
+    bool BitGrid::ExpandFrontier(const BitGrid& frontier, const BitGrid& passable, BitGrid& visited, BitGrid& next)
+    {
+        next.Clear();
+        if (frontier.mBeginWord == frontier.mEndWord)
+        {
+            return false;
+        }
+
+        const uint64_t* frontierWords = frontier.Words();
+        const uint64_t* passableWords = passable.Words();
+        uint64_t* visitedWords = visited.Words();
+        uint64_t* nextWords = next.Words();
+
+        size_t strideY = frontier.mStrides[1];
+        size_t strideZ = frontier.mStrides[2];
+
+        // Neighbours lie at most one z stride, plus a partial word, either side of the frontier
+        size_t reach = (strideZ >> 6) + 1;
+        ptrdiff_t begin = static_cast<ptrdiff_t>(frontier.mBeginWord > reach ? frontier.mBeginWord - reach : 0);
+        ptrdiff_t end = static_cast<ptrdiff_t>(std::min(frontier.mEndWord + reach, frontier.mNumWords));
+
+        // Most words of a search front are empty, so only non-empty results are stored
+        ptrdiff_t firstSet = end;
+        ptrdiff_t lastSet = begin - 1;
+        for (ptrdiff_t w = begin; w < end; w++)
+        {
+            uint64_t neighbours =
+                ShiftUp(frontierWords, w, 1) | ShiftDown(frontierWords, w, 1) |
+                ShiftUp(frontierWords, w, strideY) | ShiftDown(frontierWords, w, strideY) |
+                ShiftUp(frontierWords, w, strideZ) | ShiftDown(frontierWords, w, strideZ);
+
+            uint64_t word = neighbours & passableWords[w] & ~visitedWords[w];
+            if (word != 0)
+            {
+                nextWords[w] = word;
+                visitedWords[w] |= word;
+                firstSet = std::min(firstSet, w);
+                lastSet = w;
+            }
+        }
+
+        if (lastSet < firstSet)
+        {
+            return false;
+        }
+
+        next.mBeginWord = static_cast<size_t>(firstSet);
+        next.mEndWord = static_cast<size_t>(lastSet + 1);
+        visited.mBeginWord = visited.mBeginWord == visited.mEndWord ? next.mBeginWord : std::min(visited.mBeginWord, next.mBeginWord);
+        visited.mEndWord = std::max(visited.mEndWord, next.mEndWord);
+        return true;
+    }
+
+} // namespace Snake
@@ -0,0 +1,48 @@
+// BitGrid.h
+
+#pragma once
+
+#include "Snake3D.h"
+#include <vector>
+
+namespace Snake
+{
+    // One bit per board cell, stored in 64-bit words in board index order
+    // Cell indices are linear in the coordinates, so a step along an axis is a shift of the whole bit string by that
+    // axis' index stride. Steps off one edge of the board wrap onto the opposite edge, but every edge cell is wall and
+    // never passable, so masking with a passable grid is all the boundary handling searches need.
+    class BitGrid
+    {
+    public:
+        explicit BitGrid(const BoardLayout& layout);
+
+        void Clear();
+        void Set(size_t cellIndex);
+        void Reset(size_t cellIndex)        { Words()[cellIndex >> 6] &= ~(uint64_t(1) << (cellIndex & 63)); }
+        bool Test(size_t cellIndex) const   { return (Words()[cellIndex >> 6] >> (cellIndex & 63)) & 1; }
+        size_t Count() const;
+
+        // Sets the bit of every cell of the given type
+        void SetFromTypes(const GameBoard& board, GamePieceType type);
+
+        // Index offsets of the six face neighbours
+        const ptrdiff_t* GetNeighbourOffsets() const { return mNeighbourOffsets; }
+
+        // next = face neighbours of frontier that are passable and not yet visited; visited gains next
+        // Returns false if next is empty. All four grids must share a layout.
+        static bool ExpandFrontier(const BitGrid& frontier, const BitGrid& passable, BitGrid& visited, BitGrid& next);
+
+    private:
+        uint64_t* Words()               { return mStorage.data() + mNumGuardWords; }
+        const uint64_t* Words() const   { return mStorage.data() + mNumGuardWords; }
+
+        size_t                mNumWords;
+        size_t                mNumGuardWords;   // Zero words either side, so shifted reads never leave the storage
+        size_t                mBeginWord = 0;   // Every word outside [mBeginWord, mEndWord) is zero, so searches
+        size_t                mEndWord = 0;     // only touch the slabs their frontier has reached
+        size_t                mStrides[3];
+        ptrdiff_t             mNeighbourOffsets[6];
+        std::vector<uint64_t> mStorage;
+    };
+
+} // namespace Snake
@@ -0,0 +1,62 @@
+// BoardJournal.cpp
+
+#include "BoardJournal.h"
+#include <cassert>
+
+namespace Snake
+{
+    static_assert((BoardJournal::Capacity & (BoardJournal::Capacity - 1)) == 0, "Journal capacity must be a power of two");
+
+    BoardJournal::BoardJournal()
+        : mChanges(new BoardChange[Capacity])
+    {
+    }
+
+    void BoardJournal::Record(const BoardChange& change)
+    {
+        mChanges[mWritePosition & (Capacity - 1)] = change;
+        mWritePosition++;
+
+        for (size_t i = 0; i < mNumObservers; i++)
+        {
+            mObservers[i]->OnBoardChange(change);
+        }
+    }
+
+    void BoardJournal::Invalidate()
+    {
+        // Advance past the reset so even readers that were fully caught up resync
+        mWritePosition++;
+        mResyncPosition = mWritePosition;
+
+        for (size_t i = 0; i < mNumObservers; i++)
+        {
+            mObservers[i]->OnBoardResync();
+        }
+    }
+
+    bool BoardJournal::Subscribe(BoardObserver* observer)
+    {
+        assert(observer != nullptr);
+        if (mNumObservers == MaxObservers)
+        {
+            return false;
+        }
+
+        mObservers[mNumObservers++] = observer;
+        return true;
+    }
+
+    void BoardJournal::Unsubscribe(BoardObserver* observer)
+    {
+        for (size_t i = 0; i < mNumObservers; i++)
+        {
+            if (mObservers[i] == observer)
+            {
+                mObservers[i] = mObservers[--mNumObservers];
+                return;
+            }
+        }
+    }
+
+} // namespace Snake
@@ -0,0 +1,85 @@
+// BoardJournal.h
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Snake
+{
+    enum class GamePieceType : uint8_t;
+    enum class PieceColor : uint8_t;
+
+    // Compact record of a single cell changing
+    class BoardChange
+    {
+    public:
+        uint32_t      mCellIndex;
+        GamePieceType mOldType;
+        GamePieceType mNewType;
+        PieceColor    mColor;       // Color of the new piece, meaningless when the cell became empty
+    };
+
+    // Receives board changes synchronously as they are recorded
+    class BoardObserver
+    {
+    public:
+        virtual ~BoardObserver() = default;
+
+        virtual void OnBoardChange(const BoardChange& change) = 0;
+        virtual void OnBoardResync() = 0;   // Board was reset or overwritten wholesale; rebuild from it
+    };
+
+    // Fixed-capacity ring of board changes
+    // Readers drain it with their own cursor; a reader that falls more than Capacity changes behind, or that was
+    // behind when the board was reset, is told to resync from the full board instead. Never allocates after construction.
+    class BoardJournal
+    {
+    public:
+        static constexpr size_t Capacity = 4096;
+        static constexpr size_t MaxObservers = 4;
+
+        BoardJournal();
+        ~BoardJournal() = default;
+
+        BoardJournal(const BoardJournal&) = delete;
+        BoardJournal& operator=(const BoardJournal&) = delete;
+
+        void Record(const BoardChange& change);
+        void Invalidate();
+
+        bool Subscribe(BoardObserver* observer);
+        void Unsubscribe(BoardObserver* observer);
+
+        // Cursor for a reader that is up to date with the board as it is now
+        uint64_t GetWritePosition() const { return mWritePosition; }
+
+        // Visits changes recorded since cursor and advances it to the write position
+        // Returns false, without visiting anything, if the reader must resync from the full board
+        template<typename Visitor> bool Drain(uint64_t& cursor, Visitor&& visitor) const;
+
+    private:
+        std::unique_ptr<BoardChange[]> mChanges;
+        uint64_t       mWritePosition = 0;
+        uint64_t       mResyncPosition = 0;    // Readers with a cursor before this missed a reset
+        BoardObserver* mObservers[MaxObservers] = {};
+        size_t         mNumObservers = 0;
+    };
+
+    template<typename Visitor> bool BoardJournal::Drain(uint64_t& cursor, Visitor&& visitor) const
+    {
+        bool inSync = cursor >= mResyncPosition && mWritePosition - cursor <= Capacity;
+        if (inSync)
+        {
+            for (; cursor < mWritePosition; cursor++)
+            {
+                visitor(mChanges[cursor & (Capacity - 1)]);
+            }
+        }
+
+        cursor = mWritePosition;
+        return inSync;
+    }
+
+} // namespace Snake
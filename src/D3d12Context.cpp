@@ -8,15 +8,21 @@
 #include "d3dx12.h"
 #include <wrl.h>
 #include "Window.h"
+#include "SceneAssets.h"
 #include "Snake3D.h"
 #include <cassert>
-#include <bitset>
 
 constexpr size_t ALIGN_256(size_t in)
 {
     return (in + 0xff) & ~0xff;
 }
 
+static DirectX::XMVECTOR GetPaletteVector(Snake::PieceColor color)
+{
+    const float* rgba = Snake::GetPaletteColor(color);
+    return DirectX::XMVectorSet(rgba[0], rgba[1], rgba[2], rgba[3]);
+}
+
 class SceneConstantBuffer
 {
 public:
@@ -28,7 +34,8 @@ class D3dContext
 {
 public:
     static const UINT   kFrameCount      = 2;
-    static const size_t kConstBufferSize = Snake::NumGamePieces * ALIGN_256(sizeof(SceneConstantBuffer));
+    static const size_t kMaxInstances    = Snake::NumGamePieces;
+    static const size_t kConstBufferSize = kMaxInstances * ALIGN_256(sizeof(SceneConstantBuffer));
 
     Microsoft::WRL::ComPtr<IDXGISwapChain3>           mSwapChain;
     Microsoft::WRL::ComPtr<ID3D12Device>              mDevice;
@@ -65,33 +72,12 @@ public:
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>      mDsvHeap;
 };
 
-D3dContext gDevice;
 const int gX = 100;
 const int gY = 100;
 const int gWidth = 1024;
 const int gHeight = 1024;
 
-class Vertex
-{
-public:
-    float pos[3];
-    float color[4];
-    float texcoord[2];
-};
-
-const uint32_t gTexWidth = 64;
-const uint32_t gTexHeight = 64;
-const uint32_t gTexBpp = 4;
-char gTexData[gTexWidth][gTexHeight][gTexBpp];
-
-void InitDevice(HWND hwnd);
-
-void Init(HWND hwnd)
-{
-    InitTexture(&gTexData[0][0][0], gTexWidth, gTexHeight, gTexBpp);
-    InitDevice(hwnd);
-    InitAssets();
-}
+char gTexData[Vnm::CheckerTextureHeight][Vnm::CheckerTextureWidth][Vnm::CheckerTextureBpp];
 
 using Microsoft::WRL::ComPtr;
 
@@ -131,36 +117,36 @@ void GetHardwareAdapter(IDXGIFactory2* pFactory, IDXGIAdapter1** ppAdapter)
     *ppAdapter = adapter.Detach();
 }
 
-void WaitForPreviousFrame()
+void WaitForPreviousFrame(D3dContext& device)
 {
     // Signal and increment fence value
-    const UINT64 fence = gDevice.mFenceValue;
-    D3D_CHECK(gDevice.mCommandQueue->Signal(gDevice.mFence.Get(), fence));
-    gDevice.mFenceValue++;
+    const UINT64 fence = device.mFenceValue;
+    D3D_CHECK(device.mCommandQueue->Signal(device.mFence.Get(), fence));
+    device.mFenceValue++;
 
     // Wait until the previous frame is finished
-    if (gDevice.mFence->GetCompletedValue() < fence)
+    if (device.mFence->GetCompletedValue() < fence)
     {
-        D3D_CHECK(gDevice.mFence->SetEventOnCompletion(fence, gDevice.mFenceEvent));
-        WaitForSingleObject(gDevice.mFenceEvent, INFINITE);
+        D3D_CHECK(device.mFence->SetEventOnCompletion(fence, device.mFenceEvent));
+        WaitForSingleObject(device.mFenceEvent, INFINITE);
     }
 
-    gDevice.mFrameIndex = gDevice.mSwapChain->GetCurrentBackBufferIndex();
+    device.mFrameIndex = device.mSwapChain->GetCurrentBackBufferIndex();
 }
 
-void InitDevice(HWND hwnd)
+void InitDevice(D3dContext& device, HWND hwnd)
 {
-    gDevice.mViewport.Width = static_cast<float>(gWidth);
-    gDevice.mViewport.Height = static_cast<float>(gHeight);
-    gDevice.mViewport.MaxDepth = 1.0f;
-    gDevice.mViewport.MinDepth = 0.0f;
-    gDevice.mViewport.TopLeftX = 0.0f;
-    gDevice.mViewport.TopLeftY = 0.0f;
-
-    gDevice.mScissorRect.top = 0;
-    gDevice.mScissorRect.left = 0;
-    gDevice.mScissorRect.bottom = gHeight;
-    gDevice.mScissorRect.right = gWidth;
+    device.mViewport.Width = static_cast<float>(gWidth);
+    device.mViewport.Height = static_cast<float>(gHeight);
+    device.mViewport.MaxDepth = 1.0f;
+    device.mViewport.MinDepth = 0.0f;
+    device.mViewport.TopLeftX = 0.0f;
+    device.mViewport.TopLeftY = 0.0f;
+
+    device.mScissorRect.top = 0;
+    device.mScissorRect.left = 0;
+    device.mScissorRect.bottom = gHeight;
+    device.mScissorRect.right = gWidth;
 
     UINT dxgiFactoryFlags = 0;
 
@@ -184,26 +170,26 @@ void InitDevice(HWND hwnd)
     {
         ComPtr<IDXGIAdapter> warpAdapter;
         D3D_CHECK(factory->EnumWarpAdapter(IID_PPV_ARGS(&warpAdapter)));
-        D3D_CHECK(D3D12CreateDevice(warpAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&gDevice.mDevice)));
+        D3D_CHECK(D3D12CreateDevice(warpAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device.mDevice)));
     }
     else
     {
         ComPtr<IDXGIAdapter1> hardwareAdapter;
         GetHardwareAdapter(factory.Get(), &hardwareAdapter);
-        D3D_CHECK(D3D12CreateDevice(hardwareAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&gDevice.mDevice)));
+        D3D_CHECK(D3D12CreateDevice(hardwareAdapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device.mDevice)));
     }
 
     // Create command queue
     D3D12_COMMAND_QUEUE_DESC commandQueueDesc = {};
     commandQueueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
     commandQueueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
-    D3D_CHECK(gDevice.mDevice->CreateCommandQueue(
+    D3D_CHECK(device.mDevice->CreateCommandQueue(
         &commandQueueDesc,
-        IID_PPV_ARGS(&gDevice.mCommandQueue)));
+        IID_PPV_ARGS(&device.mCommandQueue)));
 
     // Create swap chain
     DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
-    swapChainDesc.BufferCount = gDevice.kFrameCount;
+    swapChainDesc.BufferCount = device.kFrameCount;
     swapChainDesc.Width = gWidth;
     swapChainDesc.Height = gHeight;
     swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
@@ -213,7 +199,7 @@ void InitDevice(HWND hwnd)
 
     ComPtr<IDXGISwapChain1> swapChain;
     D3D_CHECK(factory->CreateSwapChainForHwnd(
-        gDevice.mCommandQueue.Get(),
+        device.mCommandQueue.Get(),
         hwnd,
         &swapChainDesc,
         nullptr,
@@ -221,42 +207,42 @@ void InitDevice(HWND hwnd)
         &swapChain));
 
     D3D_CHECK(factory->MakeWindowAssociation(hwnd, DXGI_MWA_NO_ALT_ENTER));
-    D3D_CHECK(swapChain.As(&gDevice.mSwapChain));
-    gDevice.mFrameIndex = gDevice.mSwapChain->GetCurrentBackBufferIndex();
+    D3D_CHECK(swapChain.As(&device.mSwapChain));
+    device.mFrameIndex = device.mSwapChain->GetCurrentBackBufferIndex();
 
     // Create descriptor heaps
 
     // RTV descriptor heap
     D3D12_DESCRIPTOR_HEAP_DESC rtvHeapDesc = {};
-    rtvHeapDesc.NumDescriptors = gDevice.kFrameCount;
+    rtvHeapDesc.NumDescriptors = device.kFrameCount;
     rtvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
     rtvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-    D3D_CHECK(gDevice.mDevice->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&gDevice.mRtvHeap)));
-    gDevice.mRtvDescriptorSize = gDevice.mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+    D3D_CHECK(device.mDevice->CreateDescriptorHeap(&rtvHeapDesc, IID_PPV_ARGS(&device.mRtvHeap)));
+    device.mRtvDescriptorSize = device.mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 
     // DSV descriptor heap
     D3D12_DESCRIPTOR_HEAP_DESC dsvHeapDesc = {};
     dsvHeapDesc.NumDescriptors = 1;
     dsvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
     dsvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-    D3D_CHECK(gDevice.mDevice->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&gDevice.mDsvHeap)));
+    D3D_CHECK(device.mDevice->CreateDescriptorHeap(&dsvHeapDesc, IID_PPV_ARGS(&device.mDsvHeap)));
 
     // CBVSRV descriptor heap
     D3D12_DESCRIPTOR_HEAP_DESC cbvHeapDesc = {};
     cbvHeapDesc.NumDescriptors = 2; // TODO: Make this bigger
     cbvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
     cbvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-    D3D_CHECK(gDevice.mDevice->CreateDescriptorHeap(&cbvHeapDesc, IID_PPV_ARGS(&gDevice.mCbvSrvHeap)));
+    D3D_CHECK(device.mDevice->CreateDescriptorHeap(&cbvHeapDesc, IID_PPV_ARGS(&device.mCbvSrvHeap)));
 
     // Create frame resources
 
     // Render targets
-    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(gDevice.mRtvHeap->GetCPUDescriptorHandleForHeapStart());
-    for (int i = 0; i < gDevice.kFrameCount; ++i)
+    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(device.mRtvHeap->GetCPUDescriptorHandleForHeapStart());
+    for (int i = 0; i < device.kFrameCount; ++i)
     {
-        D3D_CHECK(gDevice.mSwapChain->GetBuffer(i, IID_PPV_ARGS(&gDevice.mRenderTargets[i])));
-        gDevice.mDevice->CreateRenderTargetView(gDevice.mRenderTargets[i].Get(), nullptr, rtvHandle);
-        rtvHandle.Offset(1, gDevice.mRtvDescriptorSize);
+        D3D_CHECK(device.mSwapChain->GetBuffer(i, IID_PPV_ARGS(&device.mRenderTargets[i])));
+        device.mDevice->CreateRenderTargetView(device.mRenderTargets[i].Get(), nullptr, rtvHandle);
+        rtvHandle.Offset(1, device.mRtvDescriptorSize);
     }
 
     // Depth stencil buffer
@@ -267,32 +253,32 @@ void InitDevice(HWND hwnd)
 
     CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
     CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_D32_FLOAT, gWidth, gHeight, 1, 0, 1, 0, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
-    D3D_CHECK(gDevice.mDevice->CreateCommittedResource(
+    D3D_CHECK(device.mDevice->CreateCommittedResource(
         &heapProperties,
         D3D12_HEAP_FLAG_NONE,
         &resourceDesc,
         D3D12_RESOURCE_STATE_DEPTH_WRITE,
         &depthOptClearValue,
-        IID_PPV_ARGS(&gDevice.mDepthStencil)));
+        IID_PPV_ARGS(&device.mDepthStencil)));
 
     D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
     dsvDesc.Format = DXGI_FORMAT_D32_FLOAT;
     dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
     dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
 
-    CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(gDevice.mDsvHeap->GetCPUDescriptorHandleForHeapStart());
+    CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(device.mDsvHeap->GetCPUDescriptorHandleForHeapStart());
 
-    gDevice.mDevice->CreateDepthStencilView(gDevice.mDepthStencil.Get(), &dsvDesc, dsvHandle);
+    device.mDevice->CreateDepthStencilView(device.mDepthStencil.Get(), &dsvDesc, dsvHandle);
 
-    D3D_CHECK(gDevice.mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&gDevice.mCommandAllocator)));
+    D3D_CHECK(device.mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&device.mCommandAllocator)));
 }
 
-void InitAssets()
+void InitAssets(D3dContext& device)
 {
     // Create root signature
     D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
     featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
-    if (FAILED(gDevice.mDevice->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData))))
+    if (FAILED(device.mDevice->CheckFeatureSupport(D3D12_FEATURE_ROOT_SIGNATURE, &featureData, sizeof(featureData))))
     {
         featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
     }
@@ -316,7 +302,7 @@ void InitAssets()
     ComPtr<ID3DBlob> signature;
     ComPtr<ID3DBlob> error;
     D3D_CHECK(D3DX12SerializeVersionedRootSignature(&rootSignatureDesc, featureData.HighestVersion, &signature, &error));
-    D3D_CHECK(gDevice.mDevice->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&gDevice.mRootSignature)));
+    D3D_CHECK(device.mDevice->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&device.mRootSignature)));
 
     // Create pipeline state
     ComPtr<ID3DBlob> vertexShader;
@@ -341,7 +327,7 @@ void InitAssets()
     // Create pipeline state object
     D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {};
     psoDesc.InputLayout = { inputElementDescs, _countof(inputElementDescs) };
-    psoDesc.pRootSignature = gDevice.mRootSignature.Get();
+    psoDesc.pRootSignature = device.mRootSignature.Get();
     psoDesc.VS = CD3DX12_SHADER_BYTECODE(vertexShader.Get());
     psoDesc.PS = CD3DX12_SHADER_BYTECODE(pixelShader.Get());
     psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
@@ -354,146 +340,101 @@ void InitAssets()
     psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
     psoDesc.DSVFormat = DXGI_FORMAT_D32_FLOAT;
     psoDesc.SampleDesc.Count = 1;
-    D3D_CHECK(gDevice.mDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&gDevice.mPipelineState)));
+    D3D_CHECK(device.mDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&device.mPipelineState)));
 
     // Create command list
-    D3D_CHECK(gDevice.mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, gDevice.mCommandAllocator.Get(), gDevice.mPipelineState.Get(), IID_PPV_ARGS(&gDevice.mCommandList)));
+    D3D_CHECK(device.mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, device.mCommandAllocator.Get(), device.mPipelineState.Get(), IID_PPV_ARGS(&device.mCommandList)));
 
     // Create the vertex buffer
-    const float cubeScale = 0.5f;
-    Vertex triangleVerts[] =
-    {
-        // Top
-        { { -1.0f * cubeScale,  1.0f * cubeScale,  1.0f * cubeScale }, { 1.0f, 0.25f, 0.25f, 1.0f }, { 0.0f, 1.0f } },
-        { {  1.0f * cubeScale,  1.0f * cubeScale,  1.0f * cubeScale }, { 0.25f, 1.0f, 0.25f, 1.0f }, { 1.0f, 1.0f } },
-        { {  1.0f * cubeScale,  1.0f * cubeScale, -1.0f * cubeScale }, { 0.25f, 0.25f, 1.0f, 1.0f }, { 1.0f, 0.0f } },
-        { { -1.0f * cubeScale,  1.0f * cubeScale, -1.0f * cubeScale }, { 1.0f, 0.25f, 1.0f,  1.0f }, { 0.0f, 0.0f } },
-        // Bottom
-        { { -1.0f * cubeScale, -1.0f * cubeScale, -1.0f * cubeScale }, { 1.0f, 0.25f, 0.25f, 1.0f }, { 0.0f, 0.0f } },
-        { { -1.0f * cubeScale, -1.0f * cubeScale,  1.0f * cubeScale }, { 0.25f, 1.0f, 0.25f, 1.0f }, { 0.0f, 1.0f } },
-        { {  1.0f * cubeScale, -1.0f * cubeScale,  1.0f * cubeScale }, { 0.25f, 0.25f, 1.0f, 1.0f }, { 1.0f, 1.0f } },
-        { {  1.0f * cubeScale, -1.0f * cubeScale, -1.0f * cubeScale }, { 1.0f, 0.25f, 1.0f,  1.0f }, { 1.0f, 0.0f } },
-        // Left                                                  
-        { { -1.0f * cubeScale,  1.0f * cubeScale, -1.0f * cubeScale }, { 1.0f, 0.25f, 0.25f, 1.0f }, { 0.0f, 1.0f } },
-        { { -1.0f * cubeScale,  1.0f * cubeScale,  1.0f * cubeScale }, { 0.25f, 1.0f, 0.25f, 1.0f }, { 1.0f, 1.0f } },
-        { { -1.0f * cubeScale, -1.0f * cubeScale,  1.0f * cubeScale }, { 0.25f, 0.25f, 1.0f, 1.0f }, { 1.0f, 0.0f } },
-        { { -1.0f * cubeScale, -1.0f * cubeScale, -1.0f * cubeScale }, { 1.0f, 0.25f, 1.0f,  1.0f }, { 0.0f, 0.0f } },
-        // Right                                                 
-        { {  1.0f * cubeScale,  1.0f * cubeScale, -1.0f * cubeScale }, { 1.0f, 0.25f, 0.25f, 1.0f }, { 0.0f, 1.0f } },
-        { {  1.0f * cubeScale,  1.0f * cubeScale,  1.0f * cubeScale }, { 0.25f, 1.0f, 0.25f, 1.0f }, { 1.0f, 1.0f } },
-        { {  1.0f * cubeScale, -1.0f * cubeScale,  1.0f * cubeScale }, { 0.25f, 0.25f, 1.0f, 1.0f }, { 1.0f, 0.0f } },
-        { {  1.0f * cubeScale, -1.0f * cubeScale, -1.0f * cubeScale }, { 1.0f, 0.25f, 1.0f,  1.0f }, { 0.0f, 0.0f } },
-        // Back                                                  
-        { { -1.0f * cubeScale,  1.0f * cubeScale,  1.0f * cubeScale }, { 1.0f, 0.25f, 0.25f, 1.0f }, { 0.0f, 1.0f } },
-        { {  1.0f * cubeScale,  1.0f * cubeScale,  1.0f * cubeScale }, { 0.25f, 1.0f, 0.25f, 1.0f }, { 1.0f, 1.0f } },
-        { {  1.0f * cubeScale, -1.0f * cubeScale,  1.0f * cubeScale }, { 0.25f, 0.25f, 1.0f, 1.0f }, { 1.0f, 0.0f } },
-        { { -1.0f * cubeScale, -1.0f * cubeScale,  1.0f * cubeScale }, { 1.0f, 0.25f, 1.0f,  1.0f }, { 0.0f, 0.0f } },
-        // Front                                                 
-        { { -1.0f * cubeScale,  1.0f * cubeScale, -1.0f * cubeScale }, { 1.0f, 0.25f, 0.25f, 1.0f }, { 0.0f, 1.0f } },
-        { {  1.0f * cubeScale,  1.0f * cubeScale, -1.0f * cubeScale }, { 0.25f, 1.0f, 0.25f, 1.0f }, { 1.0f, 1.0f } },
-        { {  1.0f * cubeScale, -1.0f * cubeScale, -1.0f * cubeScale }, { 0.25f, 0.25f, 1.0f, 1.0f }, { 1.0f, 0.0f } },
-        { { -1.0f * cubeScale, -1.0f * cubeScale, -1.0f * cubeScale }, { 1.0f, 0.25f, 1.0f,  1.0f }, { 0.0f, 0.0f } },
-    };
-
-    const UINT vertexBufferSize = sizeof(triangleVerts);
+    const UINT vertexBufferSize = sizeof(Vnm::CubeVertices);
 
     CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
     CD3DX12_RESOURCE_DESC buffer = CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize);
-    D3D_CHECK(gDevice.mDevice->CreateCommittedResource(
+    D3D_CHECK(device.mDevice->CreateCommittedResource(
         &heapProperties,
         D3D12_HEAP_FLAG_NONE,
         &buffer,
         D3D12_RESOURCE_STATE_GENERIC_READ,
         nullptr,
-        IID_PPV_ARGS(&gDevice.mVertexBuffer)));
+        IID_PPV_ARGS(&device.mVertexBuffer)));
 
     // Copy triangle data to vertex buffer
     UINT8* pVertexData;
     CD3DX12_RANGE readRangeVb(0, 0);
-    D3D_CHECK(gDevice.mVertexBuffer->Map(0, &readRangeVb, reinterpret_cast<void**>(&pVertexData)));
-    memcpy(pVertexData, triangleVerts, sizeof(triangleVerts));
-    gDevice.mVertexBuffer->Unmap(0, nullptr);
+    D3D_CHECK(device.mVertexBuffer->Map(0, &readRangeVb, reinterpret_cast<void**>(&pVertexData)));
+    memcpy(pVertexData, Vnm::CubeVertices, sizeof(Vnm::CubeVertices));
+    device.mVertexBuffer->Unmap(0, nullptr);
 
     // Initialize VB view
-    gDevice.mVertexBufferView.BufferLocation = gDevice.mVertexBuffer->GetGPUVirtualAddress();
-    gDevice.mVertexBufferView.StrideInBytes = sizeof(Vertex);
-    gDevice.mVertexBufferView.SizeInBytes = vertexBufferSize;
+    device.mVertexBufferView.BufferLocation = device.mVertexBuffer->GetGPUVirtualAddress();
+    device.mVertexBufferView.StrideInBytes = sizeof(Vnm::CubeVertex);
+    device.mVertexBufferView.SizeInBytes = vertexBufferSize;
 
     // Create index buffer
-    uint32_t indices[] =
-    {
-        0, 1, 3, 3, 1, 2,
-        4, 5, 7, 7, 5, 6,
-        8, 9, 11, 11, 9, 10,
-        12, 13, 15, 15, 13, 14,
-        16, 17, 19, 19, 17, 18,
-        20, 21, 23, 23, 21, 22
-    };
-
-    const UINT indexBufferSize = sizeof(indices);
+    const UINT indexBufferSize = sizeof(Vnm::CubeIndices);
 
     CD3DX12_HEAP_PROPERTIES ibHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
     CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(indexBufferSize);
-    D3D_CHECK(gDevice.mDevice->CreateCommittedResource(
+    D3D_CHECK(device.mDevice->CreateCommittedResource(
         &ibHeapProperties,
         D3D12_HEAP_FLAG_NONE,
         &resourceDesc,
         D3D12_RESOURCE_STATE_GENERIC_READ,
         nullptr,
-        IID_PPV_ARGS(&gDevice.mIndexBuffer)));
+        IID_PPV_ARGS(&device.mIndexBuffer)));
 
     // Copy data into index buffer
     UINT8* pIndexData;
     CD3DX12_RANGE readRangeIb(0, 0);
-    D3D_CHECK(gDevice.mIndexBuffer->Map(0, &readRangeIb, reinterpret_cast<void**>(&pIndexData)));
-    memcpy(pIndexData, indices, sizeof(indices));
-    gDevice.mIndexBuffer->Unmap(0, nullptr);
+    D3D_CHECK(device.mIndexBuffer->Map(0, &readRangeIb, reinterpret_cast<void**>(&pIndexData)));
+    memcpy(pIndexData, Vnm::CubeIndices, sizeof(Vnm::CubeIndices));
+    device.mIndexBuffer->Unmap(0, nullptr);
 
     // Initialize IB view
-    gDevice.mIndexBufferView.BufferLocation = gDevice.mIndexBuffer->GetGPUVirtualAddress();
-    gDevice.mIndexBufferView.SizeInBytes = indexBufferSize;
-    gDevice.mIndexBufferView.Format = DXGI_FORMAT_R32_UINT;
+    device.mIndexBufferView.BufferLocation = device.mIndexBuffer->GetGPUVirtualAddress();
+    device.mIndexBufferView.SizeInBytes = indexBufferSize;
+    device.mIndexBufferView.Format = DXGI_FORMAT_R32_UINT;
 
     // Create the constant buffer
     CD3DX12_HEAP_PROPERTIES cbHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
     CD3DX12_RESOURCE_DESC cbResourceDesc = CD3DX12_RESOURCE_DESC::Buffer(D3dContext::kConstBufferSize);
-    D3D_CHECK(gDevice.mDevice->CreateCommittedResource(
+    D3D_CHECK(device.mDevice->CreateCommittedResource(
         &cbHeapProperties,
         D3D12_HEAP_FLAG_NONE,
         &cbResourceDesc,
         D3D12_RESOURCE_STATE_GENERIC_READ,
         nullptr,
-        IID_PPV_ARGS(&gDevice.mConstantBuffer)));
+        IID_PPV_ARGS(&device.mConstantBuffer)));
 
     // Create constant buffer view
     D3D12_CONSTANT_BUFFER_VIEW_DESC cbvDesc = {};
-    cbvDesc.BufferLocation = gDevice.mConstantBuffer->GetGPUVirtualAddress();
+    cbvDesc.BufferLocation = device.mConstantBuffer->GetGPUVirtualAddress();
     cbvDesc.SizeInBytes = (UINT)ALIGN_256(sizeof(SceneConstantBuffer));
-    gDevice.mDevice->CreateConstantBufferView(&cbvDesc, gDevice.mCbvSrvHeap->GetCPUDescriptorHandleForHeapStart());
+    device.mDevice->CreateConstantBufferView(&cbvDesc, device.mCbvSrvHeap->GetCPUDescriptorHandleForHeapStart());
 
     // Map and initialize constant buffer
     CD3DX12_RANGE readRangeCb(0, 0);
-    D3D_CHECK(gDevice.mConstantBuffer->Map(0, &readRangeCb, reinterpret_cast<void**>(&gDevice.mpCbvDataBegin)));
-    memcpy(gDevice.mpCbvDataBegin, &gDevice.mConstantBufferData, sizeof(gDevice.mConstantBufferData));
+    D3D_CHECK(device.mConstantBuffer->Map(0, &readRangeCb, reinterpret_cast<void**>(&device.mpCbvDataBegin)));
+    memcpy(device.mpCbvDataBegin, &device.mConstantBufferData, sizeof(device.mConstantBufferData));
 
     // Create texture
     CD3DX12_HEAP_PROPERTIES texHeapProperties(D3D12_HEAP_TYPE_DEFAULT);
-    const auto texResourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, gTexWidth, gTexHeight, 1, 1);
-    D3D_CHECK(gDevice.mDevice->CreateCommittedResource(
+    const auto texResourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, Vnm::CheckerTextureWidth, Vnm::CheckerTextureHeight, 1, 1);
+    D3D_CHECK(device.mDevice->CreateCommittedResource(
         &texHeapProperties,
         D3D12_HEAP_FLAG_NONE,
         &texResourceDesc,
         D3D12_RESOURCE_STATE_COPY_DEST,
         nullptr,
-        IID_PPV_ARGS(&gDevice.mTexture)));
+        IID_PPV_ARGS(&device.mTexture)));
 
-    const UINT64 uploadBufferSize = GetRequiredIntermediateSize(gDevice.mTexture.Get(), 0, 1);
+    const UINT64 uploadBufferSize = GetRequiredIntermediateSize(device.mTexture.Get(), 0, 1);
 
     // Create GPU upload buffer
     CD3DX12_HEAP_PROPERTIES uploadHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
     CD3DX12_RESOURCE_DESC uploadResourceDesc = CD3DX12_RESOURCE_DESC::Buffer(uploadBufferSize);
     ComPtr<ID3D12Resource> textureUploadHeap;
-    D3D_CHECK(gDevice.mDevice->CreateCommittedResource(
+    D3D_CHECK(device.mDevice->CreateCommittedResource(
         &uploadHeapProperties,
         D3D12_HEAP_FLAG_NONE,
         &uploadResourceDesc,
@@ -504,16 +445,16 @@ void InitAssets()
     // Copy data to the upload heap and schedule a copy from the upload heap to the texture
     D3D12_SUBRESOURCE_DATA textureData = {};
     textureData.pData = &gTexData[0][0][0];
-    textureData.RowPitch = gTexWidth * gTexBpp;
-    textureData.SlicePitch = textureData.RowPitch * gTexHeight;
+    textureData.RowPitch = Vnm::CheckerTextureWidth * Vnm::CheckerTextureBpp;
+    textureData.SlicePitch = textureData.RowPitch * Vnm::CheckerTextureHeight;
 
-    UpdateSubresources(gDevice.mCommandList.Get(), gDevice.mTexture.Get(), textureUploadHeap.Get(), 0, 0, 1, &textureData);
+    UpdateSubresources(device.mCommandList.Get(), device.mTexture.Get(), textureUploadHeap.Get(), 0, 0, 1, &textureData);
 
     CD3DX12_RESOURCE_BARRIER resourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
-        gDevice.mTexture.Get(),
+        device.mTexture.Get(),
         D3D12_RESOURCE_STATE_COPY_DEST,
         D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-    gDevice.mCommandList->ResourceBarrier(1, &resourceBarrier);
+    device.mCommandList->ResourceBarrier(1, &resourceBarrier);
 
     // Create SRV for the texture
     D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
@@ -521,160 +462,156 @@ void InitAssets()
     srvDesc.Format = texResourceDesc.Format;
     srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
     srvDesc.Texture2D.MipLevels = 1;
-    gDevice.mDevice->CreateShaderResourceView(
-        gDevice.mTexture.Get(),
+    device.mDevice->CreateShaderResourceView(
+        device.mTexture.Get(),
         &srvDesc,
-        CD3DX12_CPU_DESCRIPTOR_HANDLE(gDevice.mCbvSrvHeap->GetCPUDescriptorHandleForHeapStart(), 1, gDevice.mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)));
+        CD3DX12_CPU_DESCRIPTOR_HANDLE(device.mCbvSrvHeap->GetCPUDescriptorHandleForHeapStart(), 1, device.mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)));
 
     // Close command list and execute to begin initial GPU setup
-    D3D_CHECK(gDevice.mCommandList->Close());
-    ID3D12CommandList* ppCommandLists[] = { gDevice.mCommandList.Get() };
-    gDevice.mCommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+    D3D_CHECK(device.mCommandList->Close());
+    ID3D12CommandList* ppCommandLists[] = { device.mCommandList.Get() };
+    device.mCommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
 
     // Create synchroniztion objects
-    D3D_CHECK(gDevice.mDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&gDevice.mFence)));
-    gDevice.mFenceValue = 1;
-    gDevice.mFenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-    if (gDevice.mFenceEvent == nullptr)
+    D3D_CHECK(device.mDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&device.mFence)));
+    device.mFenceValue = 1;
+    device.mFenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+    if (device.mFenceEvent == nullptr)
     {
         D3D_CHECK(HRESULT_FROM_WIN32(GetLastError()));
     }
 
-    WaitForPreviousFrame();
+    WaitForPreviousFrame(device);
 }
 
-void Update(const DirectX::XMMATRIX& lookAt, float elapsedSeconds)
-{
-    static float totalRotation = 0.0f;
-    totalRotation += elapsedSeconds * 0.5f;
-
-    DirectX::XMMATRIX matRotation = DirectX::XMMatrixRotationY(totalRotation);
-    DirectX::XMMATRIX matLookAt = lookAt; 
-    //DirectX::XMMATRIX matLookAt = DirectX::XMMatrixLookAtLH({ 0.0f, 1.0f, -4.0f, 0.0f }, { 0.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f });
-    DirectX::XMMATRIX matPerspective = DirectX::XMMatrixPerspectiveFovLH(1.0f, static_cast<float>(gWidth) / static_cast<float>(gHeight), 0.1f, 10.0f);
-
-    // Update CB
-    DirectX::XMMATRIX worldViewProj = matRotation * matLookAt * matPerspective;
-    memcpy(gDevice.mpCbvDataBegin, &worldViewProj, sizeof(worldViewProj));
-}
-
-void PopulateCommandList(size_t numGamePieces, const std::bitset<Snake::NumGamePieces>& drawMask)
+void PopulateCommandList(D3dContext& device, size_t numInstances)
 {
     // Command list allocators can only be reset when the associated command lists have finished execution on the GPU; use fences to determine GPU execution progress
-    D3D_CHECK(gDevice.mCommandAllocator->Reset());
+    D3D_CHECK(device.mCommandAllocator->Reset());
 
     // When ExecuteCommandList() is called on a particular command list, that command list can then be reset at any time and must be before re-recording
-    D3D_CHECK(gDevice.mCommandList->Reset(gDevice.mCommandAllocator.Get(), gDevice.mPipelineState.Get()));
+    D3D_CHECK(device.mCommandList->Reset(device.mCommandAllocator.Get(), device.mPipelineState.Get()));
 
     // Set necessary state
-    gDevice.mCommandList->SetGraphicsRootSignature(gDevice.mRootSignature.Get());
+    device.mCommandList->SetGraphicsRootSignature(device.mRootSignature.Get());
 
     // Set descriptor heaps
-    ID3D12DescriptorHeap* ppHeaps[] = { gDevice.mCbvSrvHeap.Get() };
-    gDevice.mCommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+    ID3D12DescriptorHeap* ppHeaps[] = { device.mCbvSrvHeap.Get() };
+    device.mCommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
 
     // Set root descriptor table
-    gDevice.mCommandList->SetGraphicsRootDescriptorTable(0, gDevice.mCbvSrvHeap->GetGPUDescriptorHandleForHeapStart());
+    device.mCommandList->SetGraphicsRootDescriptorTable(0, device.mCbvSrvHeap->GetGPUDescriptorHandleForHeapStart());
 
-    gDevice.mCommandList->RSSetViewports(1, &gDevice.mViewport);
-    gDevice.mCommandList->RSSetScissorRects(1, &gDevice.mScissorRect);
+    device.mCommandList->RSSetViewports(1, &device.mViewport);
+    device.mCommandList->RSSetScissorRects(1, &device.mScissorRect);
 
     // Indicate that the back buffer will be used as a render target
     CD3DX12_RESOURCE_BARRIER rtResourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(
-        gDevice.mRenderTargets[gDevice.mFrameIndex].Get(),
+        device.mRenderTargets[device.mFrameIndex].Get(),
         D3D12_RESOURCE_STATE_PRESENT,
         D3D12_RESOURCE_STATE_RENDER_TARGET);
-    gDevice.mCommandList->ResourceBarrier(1, &rtResourceBarrier);
+    device.mCommandList->ResourceBarrier(1, &rtResourceBarrier);
 
-    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(gDevice.mRtvHeap->GetCPUDescriptorHandleForHeapStart(), gDevice.mFrameIndex, gDevice.mRtvDescriptorSize);
-    CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(gDevice.mDsvHeap->GetCPUDescriptorHandleForHeapStart());
-    gDevice.mCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+    CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(device.mRtvHeap->GetCPUDescriptorHandleForHeapStart(), device.mFrameIndex, device.mRtvDescriptorSize);
+    CD3DX12_CPU_DESCRIPTOR_HANDLE dsvHandle(device.mDsvHeap->GetCPUDescriptorHandleForHeapStart());
+    device.mCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
 
     // Record commands
-    const float clearColor[] = { 0.65f, 0.65f, 0.85f, 1.0f };
-    gDevice.mCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-    gDevice.mCommandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
-    gDevice.mCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    gDevice.mCommandList->IASetVertexBuffers(0, 1, &gDevice.mVertexBufferView);
-    gDevice.mCommandList->IASetIndexBuffer(&gDevice.mIndexBufferView);
+    device.mCommandList->ClearRenderTargetView(rtvHandle, Vnm::ClearColor, 0, nullptr);
+    device.mCommandList->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+    device.mCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    device.mCommandList->IASetVertexBuffers(0, 1, &device.mVertexBufferView);
+    device.mCommandList->IASetIndexBuffer(&device.mIndexBufferView);
     
     // Set root constant buffer view for instance
-    for (int i = 0; i < numGamePieces; i++)
+    for (size_t i = 0; i < numInstances; i++)
     {
-        if (drawMask[i] == 0)
-        {
-            continue;
-        }
-
-        gDevice.mCommandList->SetGraphicsRootConstantBufferView(1, gDevice.mConstantBuffer->GetGPUVirtualAddress() + ALIGN_256(sizeof(SceneConstantBuffer)) * i);
-        gDevice.mCommandList->DrawIndexedInstanced(36, 1, 0, 0, 0);
+        device.mCommandList->SetGraphicsRootConstantBufferView(1, device.mConstantBuffer->GetGPUVirtualAddress() + ALIGN_256(sizeof(SceneConstantBuffer)) * i);
+        device.mCommandList->DrawIndexedInstanced(Vnm::NumCubeIndices, 1, 0, 0, 0);
     }
 
-    CD3DX12_RESOURCE_BARRIER presentResourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(gDevice.mRenderTargets[gDevice.mFrameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+    CD3DX12_RESOURCE_BARRIER presentResourceBarrier = CD3DX12_RESOURCE_BARRIER::Transition(device.mRenderTargets[device.mFrameIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
     // Indicate that the back buffer will now be used to present
-    gDevice.mCommandList->ResourceBarrier(1, &presentResourceBarrier);
+    device.mCommandList->ResourceBarrier(1, &presentResourceBarrier);
 
-    D3D_CHECK(gDevice.mCommandList->Close());
+    D3D_CHECK(device.mCommandList->Close());
 }
 
-void Render(const Snake::GamePiece* const* gamePieces, size_t numGamePieces, const DirectX::XMMATRIX& lookAt, float elapsedSeconds)
+namespace Vnm
 {
-    DirectX::XMMATRIX matLookAt = lookAt;
-    DirectX::XMMATRIX matPerspective = DirectX::XMMatrixPerspectiveFovLH(1.0f, static_cast<float>(gWidth) / static_cast<float>(gHeight), 0.1f, 100.0f);
+    D3d12Renderer::D3d12Renderer()
+        : mContext(std::make_unique<D3dContext>())
+    {
+    }
 
-    assert(numGamePieces <= Snake::NumGamePieces);
-    static std::bitset<Snake::NumGamePieces> drawMask(0);
+    D3d12Renderer::~D3d12Renderer() = default;
 
-    DirectX::XMMATRIX worldViewProj = matLookAt * matPerspective;
-    for (int i = 0; i < numGamePieces; i++)
+    void D3d12Renderer::Init(HWND hwnd)
     {
-        if (gamePieces[i] == nullptr)
-        {
-            drawMask[i] = 0;
-            continue;
-        }
-        else
-        {
-            drawMask[i] = 1;
-        }
+        InitCheckerTexture(&gTexData[0][0][0], CheckerTextureWidth, CheckerTextureHeight, CheckerTextureBpp);
+        InitDevice(*mContext, hwnd);
+        InitAssets(*mContext);
+    }
+
+    void D3d12Renderer::Destroy()
+    {
+        WaitForPreviousFrame(*mContext);
 
-        // Instance transformation
-        size_t offset = ALIGN_256(sizeof(SceneConstantBuffer)) * i;
-        worldViewProj = DirectX::XMMatrixTranslationFromVector(gamePieces[i]->mPosition) * matLookAt * matPerspective;
-        memcpy(gDevice.mpCbvDataBegin + offset, &worldViewProj, sizeof(worldViewProj));
-        
-        // Instance color
-        offset += sizeof(worldViewProj);
-        memcpy(gDevice.mpCbvDataBegin + offset, &gamePieces[i]->mColor, sizeof(gamePieces[i]->mColor));
+        CloseHandle(mContext->mFenceEvent);
     }
 
-    PopulateCommandList(numGamePieces, drawMask);
+    void D3d12Renderer::BeginFrame(const float view[16])
+    {
+        DirectX::XMMATRIX matLookAt = DirectX::XMLoadFloat4x4(reinterpret_cast<const DirectX::XMFLOAT4X4*>(view));
+        DirectX::XMMATRIX matPerspective = DirectX::XMMatrixPerspectiveFovLH(FieldOfViewY, static_cast<float>(gWidth) / static_cast<float>(gHeight), NearZ, FarZ);
+        DirectX::XMStoreFloat4x4(&mViewProj, matLookAt * matPerspective);
+        mNumInstances = 0;
+    }
 
-    ID3D12CommandList* ppCommandLists[] = { gDevice.mCommandList.Get() };
-    gDevice.mCommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+    void D3d12Renderer::SubmitInstances(const Snake::RenderInstance* instances, size_t numInstances)
+    {
+        // The constant buffer holds a 16x16x16 board's worth of instances; larger frames draw what fits rather than
+        // writing past the mapped buffer
+        size_t capacity = D3dContext::kMaxInstances - mNumInstances;
+        if (numInstances > capacity)
+        {
+            if (!mWarnedOverflow)
+            {
+                OutputDebugStringA("D3d12Renderer: frame exceeds the instance buffer, extra instances are not drawn\n");
+                mWarnedOverflow = true;
+            }
+            numInstances = capacity;
+        }
 
-    D3D_CHECK(gDevice.mSwapChain->Present(1, 0));
+        DirectX::XMMATRIX viewProj = DirectX::XMLoadFloat4x4(&mViewProj);
+        for (size_t i = 0; i < numInstances; i++)
+        {
+            const Snake::RenderInstance& instance = instances[i];
+            DirectX::XMVECTOR center = DirectX::XMVectorSet(instance.mCenter[0], instance.mCenter[1], instance.mCenter[2], 1.0f);
+            DirectX::XMVECTOR extent = DirectX::XMVectorSet(instance.mExtent[0], instance.mExtent[1], instance.mExtent[2], 0.0f);
+
+            // Instance transformation
+            size_t offset = ALIGN_256(sizeof(SceneConstantBuffer)) * (mNumInstances + i);
+            DirectX::XMMATRIX worldViewProj = DirectX::XMMatrixScalingFromVector(extent) * DirectX::XMMatrixTranslationFromVector(center) * viewProj;
+            memcpy(mContext->mpCbvDataBegin + offset, &worldViewProj, sizeof(worldViewProj));
+
+            // Instance color
+            offset += sizeof(worldViewProj);
+            DirectX::XMVECTOR color = GetPaletteVector(instance.mColor);
+            memcpy(mContext->mpCbvDataBegin + offset, &color, sizeof(color));
+        }
+        mNumInstances += numInstances;
+    }
 
-    WaitForPreviousFrame();
-}
+    void D3d12Renderer::EndFrame()
+    {
+        PopulateCommandList(*mContext, mNumInstances);
 
-void Destroy()
-{
-    WaitForPreviousFrame();
+        ID3D12CommandList* ppCommandLists[] = { mContext->mCommandList.Get() };
+        mContext->mCommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
 
-    CloseHandle(gDevice.mFenceEvent);
-}
+        D3D_CHECK(mContext->mSwapChain->Present(1, 0));
 
-void InitTexture(char* dst, uint32_t width, uint32_t height, uint32_t bpp)
-{
-    for (uint32_t j = 0; j < height; ++j)
-    {
-        for (uint32_t i = 0; i < width; ++i)
-        {
-            dst[j * (width * bpp) + (i * bpp) + 0] = !(i % 16 < 8) != !(j % 16 < 8) ? 0xff : 0;
-            dst[j * (width * bpp) + (i * bpp) + 1] = !(i % 16 < 8) != !(j % 16 < 8) ? 0xff : 0;
-            dst[j * (width * bpp) + (i * bpp) + 2] = !(i % 16 < 8) != !(j % 16 < 8) ? 0xff : 0;
-            dst[j * (width * bpp) + (i * bpp) + 3] = 0xffu;
-        }
+        WaitForPreviousFrame(*mContext);
     }
 }
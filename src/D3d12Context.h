@@ -6,11 +6,36 @@
 #include <Windows.h>
 #include <stdint.h>
 #include <DirectXMath.h>
-#include "Snake3D.h" // TODO: Delete this line once generic instances are used
-
-void Init(HWND hwnd);
-void InitAssets();
-void Update(const DirectX::XMMATRIX& lookAt, float elapsedSeconds);
-void Render(const Snake::GamePiece* const* gamePieces, size_t numGamePieces, const DirectX::XMMATRIX& lookAt, float elapsedSeconds); // TODO: Make generic instances with positions, colors, etc.
-void Destroy();
-void InitTexture(char* dst, uint32_t width, uint32_t height, uint32_t bpp);
+#include <memory>
+#include "Renderer.h"
+
+class D3dContext;
+
+namespace Vnm
+{
+    // Direct3D 12 backend; each frame's instances go into one constant buffer, drawn one cube per instance
+    class D3d12Renderer : public IRenderer
+    {
+    public:
+        D3d12Renderer();
+        ~D3d12Renderer() override;
+
+        D3d12Renderer(const D3d12Renderer&) = delete;
+        D3d12Renderer& operator=(const D3d12Renderer&) = delete;
+
+        void Init(HWND hwnd);
+        // Waits for the GPU to finish
+        void Destroy();
+
+        void BeginFrame(const float view[16]) override;
+        void SubmitInstances(const Snake::RenderInstance* instances, size_t numInstances) override;
+        // Presents with vsync and waits for the GPU
+        void EndFrame() override;
+
+    private:
+        std::unique_ptr<D3dContext> mContext;
+        DirectX::XMFLOAT4X4         mViewProj;
+        size_t                      mNumInstances = 0;
+        bool                        mWarnedOverflow = false;   // Frames past the instance buffer are reported once
+    };
+}
@@ -0,0 +1,2608 @@
+// Headless.cpp
+
+// Runs batches of games without a window or GPU and reports simulation throughput
+
+#include "BatchRunner.h"
+#include "MctsPlayer.h"
+#include "ObservationEncoder.h"
+#include "PathPlanner.h"
+#include "Pool.h"
+#include "RecordingRenderer.h"
+#include "Replay.h"
+#include "SceneAssets.h"
+#include "SimulationThread.h"
+#include "SnakeBody.h"
+#include "Snapshot.h"
+#include "SoftwareRenderer.h"
+#include "SparseGameBoard.h"
+#include "TranspositionTable.h"
+#include "VecEnvApi.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// Keeps a benchmark's inner loop out of line; GCC left such loops scalar once inlined into main, which it knows runs once
+#if defined(_MSC_VER)
+#define BENCHMARK_KERNEL __declspec(noinline)
+#else
+#define BENCHMARK_KERNEL __attribute__((noinline))
+#endif
+
+namespace
+{
+    class RunConfig
+    {
+    public:
+        Snake::BatchConfig mBatch;
+        size_t             mNumThreads = std::thread::hardware_concurrency();
+        bool               mMeasureScaling = false;
+        bool               mMeasurePlanner = false;
+        bool               mMeasureMcts = false;
+        bool               mMeasureHandoff = false;
+        bool               mMeasureRendering = false;
+        bool               mMeasureRasterizer = false;
+        bool               mMeasurePlacement = false;
+        bool               mMeasureBodySweep = false;
+        bool               mMeasureBoardSizes = false;
+        bool               mMeasureBoardScan = false;
+        bool               mMeasurePoolChurn = false;
+        bool               mMeasureSparseBoard = false;
+        bool               mMeasureReset = false;
+        bool               mMeasureEncoding = false;
+        bool               mCheckTable = false;
+        bool               mCheckUndo = false;
+        bool               mCheckJournal = false;
+        bool               mCheckVecEnv = false;
+        Snake::MctsConfig  mMcts;
+        const char*        mRecordPath = nullptr;
+        const char*        mVerifyPath = nullptr;
+        const char*        mSnapshotPath = nullptr;
+        const char*        mScreenshotPath = nullptr;
+        uint64_t           mSeekTick = 0;
+        bool               mSeek = false;
+        uint32_t           mKeyframeInterval = Snake::ReplayWriter::DefaultKeyframeInterval;
+    };
+
+    uint64_t MixChecksum(uint64_t value)
+    {
+        value ^= value >> 33;
+        value *= 0xff51afd7ed558ccdull;
+        value ^= value >> 33;
+        return value;
+    }
+
+    // Same games give the same checksum regardless of thread count
+    uint64_t CalcChecksum(const Snake::BatchResult& result)
+    {
+        uint64_t checksum = 0;
+        for (const Snake::GameResult& game : result.mGames)
+        {
+            checksum = MixChecksum(checksum ^ game.mSeed ^ (game.mNumSteps << 20) ^ (static_cast<uint64_t>(game.mLength) << 48));
+        }
+        return checksum;
+    }
+
+    double CalcStepsPerSecond(const Snake::BatchResult& result)
+    {
+        return result.mElapsedSeconds > 0.0 ? static_cast<double>(result.mNumSteps) / result.mElapsedSeconds : 0.0;
+    }
+
+    void PrintSummary(const RunConfig& config, const Snake::BatchResult& result)
+    {
+        uint64_t totalScore = 0;
+        uint64_t endCounts[4] = {};
+        for (const Snake::GameResult& game : result.mGames)
+        {
+            totalScore += game.mScore;
+            endCounts[static_cast<size_t>(game.mEnd)]++;
+        }
+
+        size_t numGames = result.mGames.size();
+        double meanScore = numGames > 0 ? static_cast<double>(totalScore) / static_cast<double>(numGames) : 0.0;
+        printf("policy %s, games %llu, threads %llu, steps %llu, mean score %.2f\n",
+            Snake::GetPolicyName(config.mBatch.mPolicy),
+            static_cast<unsigned long long>(numGames),
+            static_cast<unsigned long long>(config.mNumThreads),
+            static_cast<unsigned long long>(result.mNumSteps),
+            meanScore);
+        printf("ends: wall %llu, body %llu, board full %llu, step limit %llu\n",
+            static_cast<unsigned long long>(endCounts[static_cast<size_t>(Snake::GameEnd::HitWall)]),
+            static_cast<unsigned long long>(endCounts[static_cast<size_t>(Snake::GameEnd::HitBody)]),
+            static_cast<unsigned long long>(endCounts[static_cast<size_t>(Snake::GameEnd::BoardFull)]),
+            static_cast<unsigned long long>(endCounts[static_cast<size_t>(Snake::GameEnd::StepLimit)]));
+        printf("elapsed %.3f s, %.0f steps/s, checksum %016llx\n",
+            result.mElapsedSeconds,
+            CalcStepsPerSecond(result),
+            static_cast<unsigned long long>(CalcChecksum(result)));
+    }
+
+    // Runs the same batch on 1, 2, 4, ... threads up to the configured count
+    void MeasureScaling(const RunConfig& config)
+    {
+        double baseStepsPerSecond = 0.0;
+        for (size_t numThreads = 1; ; numThreads = numThreads * 2 < config.mNumThreads ? numThreads * 2 : config.mNumThreads)
+        {
+            Vnm::WorkStealingPool pool(numThreads);
+            Snake::BatchResult result = Snake::RunBatch(pool, config.mBatch);
+
+            double stepsPerSecond = CalcStepsPerSecond(result);
+            if (numThreads == 1)
+            {
+                baseStepsPerSecond = stepsPerSecond;
+            }
+
+            double speedup = baseStepsPerSecond > 0.0 ? stepsPerSecond / baseStepsPerSecond : 0.0;
+            printf("threads %3llu: %12.0f steps/s, speedup %5.2f, efficiency %5.1f%%, checksum %016llx\n",
+                static_cast<unsigned long long>(numThreads),
+                stepsPerSecond,
+                speedup,
+                100.0 * speedup / static_cast<double>(numThreads),
+                static_cast<unsigned long long>(CalcChecksum(result)));
+
+            if (numThreads >= config.mNumThreads)
+            {
+                break;
+            }
+        }
+    }
+
+    // Times the pathfinding policy's plans, one per cell entered, on the default board and a large one
+    void MeasurePlanner(const RunConfig& config)
+    {
+        const Snake::BoardLayout layouts[] = { Snake::DefaultGameBoard::Layout, Snake::BoardLayout(64, 64, 64) };
+        for (const Snake::BoardLayout& layout : layouts)
+        {
+            Snake::Simulation simulation(config.mBatch.mFirstSeed, layout);
+            std::unique_ptr<Snake::Policy> policy = Snake::CreatePolicy(Snake::PolicyType::Pathfinding);
+
+            uint64_t numPlans = 0;
+            uint64_t totalScore = 0;
+            double planSeconds = 0.0;
+            for (uint64_t game = 0; game < config.mBatch.mNumGames; game++)
+            {
+                uint64_t seed = config.mBatch.mFirstSeed + game;
+                simulation.Reset(seed);
+                policy->Reset(seed);
+
+                Snake::StepResult lastResult = Snake::StepResult::EnteredCell;
+                while (!simulation.IsOver() && simulation.GetStepCount() < config.mBatch.mMaxStepsPerGame)
+                {
+                    uint32_t inputs = 0;
+                    if (lastResult != Snake::StepResult::Moved)
+                    {
+                        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+                        inputs = policy->ChooseInputs(simulation, lastResult);
+                        planSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                        numPlans++;
+                    }
+                    lastResult = simulation.Step(inputs);
+                }
+
+                totalScore += simulation.GetBodyLength() - 1;
+            }
+
+            double numGames = static_cast<double>(config.mBatch.mNumGames);
+            printf("board %llux%llux%llu: plans %llu, %.0f plans/s, mean score %.2f\n",
+                static_cast<unsigned long long>(layout.GetNumPieces(0)),
+                static_cast<unsigned long long>(layout.GetNumPieces(1)),
+                static_cast<unsigned long long>(layout.GetNumPieces(2)),
+                static_cast<unsigned long long>(numPlans),
+                planSeconds > 0.0 ? static_cast<double>(numPlans) / planSeconds : 0.0,
+                numGames > 0.0 ? static_cast<double>(totalScore) / numGames : 0.0);
+        }
+    }
+
+    // Searches the same late-game position with MCTS on 1, 2, 4, ... threads
+    // With a rollout budget the moves, and so the checksum, are reproducible for each thread count
+    void MeasureMcts(const RunConfig& config)
+    {
+        constexpr size_t StartLength = 150;
+        constexpr int NumSearchedMoves = 32;
+        constexpr size_t TableEntries = size_t(1) << 20;
+
+        Snake::Simulation position(config.mBatch.mFirstSeed);
+        std::unique_ptr<Snake::Policy> policy = Snake::CreatePolicy(Snake::PolicyType::Pathfinding);
+        policy->Reset(config.mBatch.mFirstSeed);
+
+        Snake::StepResult lastResult = Snake::StepResult::EnteredCell;
+        while (!position.IsOver() && (position.GetBodyLength() < StartLength || lastResult == Snake::StepResult::Moved))
+        {
+            lastResult = position.Step(policy->ChooseInputs(position, lastResult));
+        }
+        if (position.IsOver())
+        {
+            printf("game ended before reaching length %llu\n", static_cast<unsigned long long>(StartLength));
+            return;
+        }
+
+        printf("position: seed %llu, step %llu, length %llu\n",
+            static_cast<unsigned long long>(config.mBatch.mFirstSeed),
+            static_cast<unsigned long long>(position.GetStepCount()),
+            static_cast<unsigned long long>(position.GetBodyLength()));
+
+        double baseRolloutsPerSecond = 0.0;
+        for (size_t numThreads = 1; ; numThreads = numThreads * 2 < config.mNumThreads ? numThreads * 2 : config.mNumThreads)
+        {
+            Vnm::WorkStealingPool pool(numThreads);
+            Snake::TranspositionTable table(TableEntries);
+            Snake::MctsPlayer player(pool, config.mMcts, &table);
+            Snake::Simulation simulation = position;
+
+            uint64_t numRollouts = 0;
+            uint64_t numTableHits = 0;
+            double searchSeconds = 0.0;
+            uint64_t checksum = 0;
+            for (int move = 0; move < NumSearchedMoves && !simulation.IsOver(); move++)
+            {
+                Snake::MctsStats stats;
+                uint32_t inputs = player.ChooseMove(simulation, &stats);
+                numRollouts += stats.mNumRollouts;
+                numTableHits += stats.mNumTableHits;
+                searchSeconds += stats.mElapsedSeconds;
+                checksum = MixChecksum(checksum ^ inputs ^ (static_cast<uint64_t>(move) << 32));
+
+                Snake::StepResult result = simulation.Step(inputs);
+                while (result == Snake::StepResult::Moved)
+                {
+                    result = simulation.Step(0);
+                }
+            }
+
+            double rolloutsPerSecond = searchSeconds > 0.0 ? static_cast<double>(numRollouts) / searchSeconds : 0.0;
+            if (numThreads == 1)
+            {
+                baseRolloutsPerSecond = rolloutsPerSecond;
+            }
+
+            double speedup = baseRolloutsPerSecond > 0.0 ? rolloutsPerSecond / baseRolloutsPerSecond : 0.0;
+            printf("threads %3llu: %10.0f rollouts/s, speedup %5.2f, efficiency %5.1f%%, table hits %7llu, length %llu%s, checksum %016llx\n",
+                static_cast<unsigned long long>(numThreads),
+                rolloutsPerSecond,
+                speedup,
+                100.0 * speedup / static_cast<double>(numThreads),
+                static_cast<unsigned long long>(numTableHits),
+                static_cast<unsigned long long>(simulation.GetBodyLength()),
+                simulation.IsOver() ? " (dead)" : "",
+                static_cast<unsigned long long>(checksum));
+
+            if (numThreads >= config.mNumThreads)
+            {
+                break;
+            }
+        }
+    }
+
+    // Plays the first game of the batch and records it
+    bool RecordGame(const RunConfig& config)
+    {
+        Snake::ReplayWriter writer;
+        if (!writer.Open(config.mRecordPath, config.mBatch.mFirstSeed, Snake::DefaultGameBoard::Layout, config.mKeyframeInterval))
+        {
+            printf("cannot write %s\n", config.mRecordPath);
+            return false;
+        }
+
+        Snake::Simulation simulation(config.mBatch.mFirstSeed);
+        std::unique_ptr<Snake::Policy> policy = Snake::CreatePolicy(config.mBatch.mPolicy);
+        policy->Reset(config.mBatch.mFirstSeed);
+
+        Snake::StepResult lastResult = Snake::StepResult::EnteredCell;
+        while (!simulation.IsOver() && simulation.GetStepCount() < config.mBatch.mMaxStepsPerGame)
+        {
+            uint32_t inputs = policy->ChooseInputs(simulation, lastResult);
+            writer.RecordTick(simulation, inputs);
+            lastResult = simulation.Step(inputs);
+        }
+
+        uint64_t numTicks = writer.GetNumTicks();
+        if (!writer.Close(simulation))
+        {
+            printf("cannot write %s\n", config.mRecordPath);
+            return false;
+        }
+
+        printf("recorded %llu ticks, length %llu, hash %016llx\n",
+            static_cast<unsigned long long>(numTicks),
+            static_cast<unsigned long long>(simulation.GetBodyLength()),
+            static_cast<unsigned long long>(simulation.GetHash()));
+        return true;
+    }
+
+    // Seeks through the keyframe index and checks the result against replaying from the first tick
+    bool SeekGame(const RunConfig& config)
+    {
+        Snake::ReplayReader reader;
+        if (!reader.Open(config.mVerifyPath))
+        {
+            return false;
+        }
+        Snake::Simulation sought(reader.GetHeader().mSeed, reader.GetHeader().GetLayout());
+        Snake::Simulation replayed = sought;
+
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        bool reached = reader.Seek(config.mSeekTick, sought);
+        double seekSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        startTime = std::chrono::steady_clock::now();
+        uint32_t inputs;
+        Snake::ReplayReader fromStart;
+        fromStart.Open(config.mVerifyPath);
+        while (fromStart.GetTick() < config.mSeekTick && !replayed.IsOver() && fromStart.NextTick(inputs))
+        {
+            replayed.Step(inputs);
+        }
+        double replaySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        if (!reached)
+        {
+            printf("replay ends before tick %llu\n", static_cast<unsigned long long>(config.mSeekTick));
+            return false;
+        }
+
+        bool matches = sought.GetHash() == replayed.GetHash() && sought.GetStepCount() == replayed.GetStepCount();
+        printf("seek to tick %llu through %llu keyframes: %.3f ms, from the first tick %.3f ms, %s\n",
+            static_cast<unsigned long long>(config.mSeekTick),
+            static_cast<unsigned long long>(reader.GetKeyframes().size()),
+            seekSeconds * 1000.0,
+            replaySeconds * 1000.0,
+            matches ? "match" : "MISMATCH");
+        return matches;
+    }
+
+    bool VerifyGame(const RunConfig& config)
+    {
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        Snake::ReplayVerification verification;
+        if (!Snake::VerifyReplay(config.mVerifyPath, verification))
+        {
+            printf("cannot read %s\n", config.mVerifyPath);
+            return false;
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        long fileSize = 0;
+        if (FILE* file = fopen(config.mVerifyPath, "rb"))
+        {
+            fseek(file, 0, SEEK_END);
+            fileSize = ftell(file);
+            fclose(file);
+        }
+
+        double numTicks = static_cast<double>(verification.mNumTicks);
+        printf("replayed %llu ticks, %ld bytes, %.3f bytes/tick, %.0f ticks/s, %s\n",
+            static_cast<unsigned long long>(verification.mNumTicks),
+            fileSize,
+            numTicks > 0.0 ? static_cast<double>(fileSize) / numTicks : 0.0,
+            seconds > 0.0 ? numTicks / seconds : 0.0,
+            !verification.mHasTrailer ? "incomplete (no trailer)" : verification.mMatches ? "match" : "MISMATCH");
+        return verification.mMatches && (!config.mSeek || SeekGame(config));
+    }
+
+    // Saves a game on the default board and a large one, maps it back and restores it, checking the restored game plays
+    // on identically; times are the best of several rounds, so they reflect warm page cache rather than the disk
+    bool MeasureSnapshot(const RunConfig& config)
+    {
+        constexpr int NumRounds = 10;
+        constexpr uint64_t NumPlayedSteps = 20000;
+        constexpr int NumCheckedSteps = 5000;
+
+        bool allMatch = true;
+        const Snake::BoardLayout layouts[] = { Snake::DefaultGameBoard::Layout, Snake::BoardLayout(128, 128, 128) };
+        for (const Snake::BoardLayout& layout : layouts)
+        {
+            Snake::Simulation simulation(config.mBatch.mFirstSeed, layout);
+            std::unique_ptr<Snake::Policy> policy = Snake::CreatePolicy(config.mBatch.mPolicy);
+            policy->Reset(config.mBatch.mFirstSeed);
+
+            Snake::StepResult lastResult = Snake::StepResult::EnteredCell;
+            while (!simulation.IsOver() && simulation.GetStepCount() < std::min(config.mBatch.mMaxStepsPerGame, NumPlayedSteps))
+            {
+                lastResult = simulation.Step(policy->ChooseInputs(simulation, lastResult));
+            }
+
+            Snake::Simulation restored(0, layout);
+            double saveSeconds = 1e30;
+            double openSeconds = 1e30;
+            double restoreSeconds = 1e30;
+            bool saved = true;
+            bool loaded = true;
+            for (int round = 0; round < NumRounds && saved && loaded; round++)
+            {
+                std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+                saved = Snake::SaveSnapshot(config.mSnapshotPath, simulation);
+                std::chrono::steady_clock::time_point savedTime = std::chrono::steady_clock::now();
+
+                Snake::Snapshot snapshot;
+                loaded = snapshot.Open(config.mSnapshotPath);
+                std::chrono::steady_clock::time_point openedTime = std::chrono::steady_clock::now();
+                loaded = loaded && snapshot.Restore(restored);
+                std::chrono::steady_clock::time_point restoredTime = std::chrono::steady_clock::now();
+
+                saveSeconds = std::min(saveSeconds, std::chrono::duration<double>(savedTime - startTime).count());
+                openSeconds = std::min(openSeconds, std::chrono::duration<double>(openedTime - savedTime).count());
+                restoreSeconds = std::min(restoreSeconds, std::chrono::duration<double>(restoredTime - openedTime).count());
+            }
+
+            if (!saved || !loaded)
+            {
+                printf("cannot %s %s\n", saved ? "load" : "save", config.mSnapshotPath);
+                return false;
+            }
+
+            bool matches = restored.GetHash() == simulation.GetHash();
+            for (int step = 0; step < NumCheckedSteps && matches && !simulation.IsOver(); step++)
+            {
+                uint32_t inputs = policy->ChooseInputs(simulation, lastResult);
+                lastResult = simulation.Step(inputs);
+                matches = restored.Step(inputs) == lastResult && restored.GetHash() == simulation.GetHash();
+            }
+            allMatch &= matches;
+
+            double megabytes = static_cast<double>(simulation.GetBoard().GetStorageSize()) / (1024.0 * 1024.0);
+            printf("board %llux%llux%llu: %.2f MB, save %.3f ms (%.2f GB/s), open %.3f ms, restore %.3f ms (%.2f GB/s), %s\n",
+                static_cast<unsigned long long>(layout.GetNumPieces(0)),
+                static_cast<unsigned long long>(layout.GetNumPieces(1)),
+                static_cast<unsigned long long>(layout.GetNumPieces(2)),
+                megabytes,
+                saveSeconds * 1000.0,
+                megabytes / 1024.0 / saveSeconds,
+                openSeconds * 1000.0,
+                restoreSeconds * 1000.0,
+                megabytes / 1024.0 / restoreSeconds,
+                matches ? "match" : "MISMATCH");
+        }
+        return allMatch;
+    }
+
+    // Checks a frame is whole, with the walls, at most one power-up and every cell inside the board
+    bool IsConsistentFrame(const Snake::RenderFrame& frame, const Snake::BoardLayout& layout)
+    {
+        if (frame.mInstances.size() < Snake::NumWallFaces)
+        {
+            return false;
+        }
+
+        size_t numPowerUps = 0;
+        for (size_t i = Snake::NumWallFaces; i < frame.mInstances.size(); i++)
+        {
+            const Snake::RenderInstance& instance = frame.mInstances[i];
+            numPowerUps += instance.mColor == Snake::PieceColor::PowerUp ? 1 : 0;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                if (instance.mCenter[axis] < 1.0f || instance.mCenter[axis] > static_cast<float>(layout.GetNumPieces(axis) - 2))
+                {
+                    return false;
+                }
+            }
+        }
+        return numPowerUps <= 1;
+    }
+
+    class HandoffScenario
+    {
+    public:
+        const char*               mName;
+        std::chrono::microseconds mStepInterval;    // Zero runs updates back to back
+        std::chrono::microseconds mRenderTime;      // Time the null renderer spends on each frame
+        std::chrono::microseconds mVsyncInterval;   // Zero presents without waiting
+        std::chrono::microseconds mInputInterval;
+    };
+
+    // Plays a game on a simulation thread while this thread renders with a null renderer, as the game does with D3D12:
+    // at vsync, with a renderer stalling for several updates at a time, and with both sides running flat out. Inputs
+    // arrive on a third thread and are timed until the first presented frame that has consumed them.
+    bool MeasureHandoff(const RunConfig& config)
+    {
+        using std::chrono::microseconds;
+        constexpr std::chrono::seconds Duration(2);
+        const microseconds stepInterval(1000000 / Snake::Simulation::StepsPerSecond);
+        const HandoffScenario scenarios[] =
+        {
+            { "vsync 60 Hz",     stepInterval,    microseconds(2000),  microseconds(16667), microseconds(23000) },
+            { "renderer stalls", stepInterval,    microseconds(50000), microseconds(16667), microseconds(23000) },
+            { "unthrottled",     microseconds(0), microseconds(0),     microseconds(0),     microseconds(100) },
+        };
+
+        bool allConsistent = true;
+        for (const HandoffScenario& scenario : scenarios)
+        {
+            const Snake::BoardLayout& layout = Snake::DefaultGameBoard::Layout;
+            Snake::Simulation simulation(config.mBatch.mFirstSeed, layout);
+            std::unique_ptr<Snake::Policy> policy = Snake::CreatePolicy(config.mBatch.mPolicy);
+            policy->Reset(config.mBatch.mFirstSeed);
+
+            // Inputs stand in for key presses; they are timed but leave steering to the policy
+            Snake::PendingInputTime pendingInput;
+            Snake::InputTimes inputTimes;
+            Snake::StepResult lastResult = Snake::StepResult::EnteredCell;
+            Snake::SimulationThread simulationThread(Snake::CalcMaxRenderInstances(layout));
+            simulationThread.Start(scenario.mStepInterval, [&](Snake::RenderFrame& frame)
+            {
+                std::chrono::steady_clock::time_point inputTime;
+                if (pendingInput.Take(inputTime))
+                {
+                    inputTimes.Add(inputTime);
+                }
+
+                if (simulation.IsOver())
+                {
+                    simulation.Reset();
+                    lastResult = Snake::StepResult::EnteredCell;
+                }
+                lastResult = simulation.Step(policy->ChooseInputs(simulation, lastResult));
+
+                Snake::BuildRenderInstances(simulation.GetBoard(), frame.mInstances);
+                frame.mStepCount = simulation.GetStepCount();
+                frame.mInputs = inputTimes;
+            });
+
+            std::atomic<bool> done{ false };
+            std::thread inputThread([&]()
+            {
+                while (!done.load(std::memory_order_relaxed))
+                {
+                    pendingInput.Mark(std::chrono::steady_clock::now());
+                    std::this_thread::sleep_for(scenario.mInputInterval);
+                }
+            });
+
+            Vnm::NullRenderer renderer;
+            Snake::InputLatencyMeter latency;
+            uint64_t numPresented = 0;
+            uint64_t numRepeated = 0;
+            uint64_t numSkipped = 0;
+            uint64_t lastFrameNumber = 0;
+            bool consistent = true;
+            std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            std::chrono::steady_clock::time_point vsyncTime = startTime;
+            while (std::chrono::steady_clock::now() - startTime < Duration)
+            {
+                if (simulationThread.AcquireFrame())
+                {
+                    const Snake::RenderFrame& frame = simulationThread.GetFrame();
+                    consistent &= frame.mFrameNumber > lastFrameNumber && IsConsistentFrame(frame, layout);
+                    numSkipped += frame.mFrameNumber - lastFrameNumber - 1;
+                    lastFrameNumber = frame.mFrameNumber;
+                }
+                else
+                {
+                    numRepeated++;
+                }
+
+                // The null renderer takes no time itself, so GPU work is a sleep
+                Vnm::DrawFrame(renderer, simulationThread.GetFrame());
+                if (scenario.mRenderTime.count() > 0)
+                {
+                    std::this_thread::sleep_for(scenario.mRenderTime);
+                }
+
+                // Present waits for the next vblank, however long the frame took
+                if (scenario.mVsyncInterval.count() > 0)
+                {
+                    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+                    while (vsyncTime <= now)
+                    {
+                        vsyncTime += scenario.mVsyncInterval;
+                    }
+                    std::this_thread::sleep_until(vsyncTime);
+                }
+
+                latency.OnPresent(simulationThread.GetFrame(), std::chrono::steady_clock::now());
+                numPresented++;
+            }
+
+            done.store(true, std::memory_order_relaxed);
+            inputThread.join();
+            simulationThread.Stop();
+            allConsistent &= consistent;
+
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            printf("%-16s updates %8llu (%7.0f/s, %llu late, worst %.2f ms behind), presents %8llu, repeats %8llu, skipped %8llu, %s\n",
+                scenario.mName,
+                static_cast<unsigned long long>(simulationThread.GetNumUpdates()),
+                static_cast<double>(simulationThread.GetNumUpdates()) / seconds,
+                static_cast<unsigned long long>(simulationThread.GetNumLateUpdates()),
+                std::chrono::duration<double, std::milli>(simulationThread.GetMaxLateness()).count(),
+                static_cast<unsigned long long>(numPresented),
+                static_cast<unsigned long long>(numRepeated),
+                static_cast<unsigned long long>(numSkipped),
+                consistent ? "frames whole" : "TORN FRAMES");
+            printf("%-16s input latency: %llu inputs, mean %.2f ms, p50 %.1f ms, p99 %.1f ms, max %.2f ms, %llu untimed\n",
+                "",
+                static_cast<unsigned long long>(latency.GetCount()),
+                latency.GetMeanMilliseconds(),
+                latency.GetPercentileMilliseconds(0.5),
+                latency.GetPercentileMilliseconds(0.99),
+                latency.GetMaxMilliseconds(),
+                static_cast<unsigned long long>(latency.GetNumMissed()));
+        }
+        return allConsistent;
+    }
+
+    // Plays a game, then replays its inputs three times: simulating only, then also building and drawing a frame after
+    // every step with the null renderer, then with the recording renderer. Policy time stays out of all three, so the
+    // differences are what frame preparation and capture cost, and the recording's hash changes only if the frames do.
+    void MeasureRendering(const RunConfig& config)
+    {
+        constexpr uint64_t NumSteps = 20000;
+        enum class Pass { SimulationOnly, NullRenderer, RecordingRenderer, Count };
+        const char* const passNames[] = { "simulation only", "null renderer", "recording renderer" };
+
+        const Snake::BoardLayout layouts[] = { Snake::DefaultGameBoard::Layout, Snake::BoardLayout(64, 64, 64) };
+        for (const Snake::BoardLayout& layout : layouts)
+        {
+            // Games that end carry on with a new one, as in the game
+            std::vector<uint32_t> inputs;
+            {
+                Snake::Simulation simulation(config.mBatch.mFirstSeed, layout);
+                std::unique_ptr<Snake::Policy> policy = Snake::CreatePolicy(config.mBatch.mPolicy);
+                policy->Reset(config.mBatch.mFirstSeed);
+                Snake::StepResult lastResult = Snake::StepResult::EnteredCell;
+                while (inputs.size() < std::min(config.mBatch.mMaxStepsPerGame, NumSteps))
+                {
+                    if (simulation.IsOver())
+                    {
+                        simulation.Reset();
+                        lastResult = Snake::StepResult::EnteredCell;
+                    }
+                    inputs.push_back(policy->ChooseInputs(simulation, lastResult));
+                    lastResult = simulation.Step(inputs.back());
+                }
+            }
+
+            printf("board %llux%llux%llu, %llu steps:\n",
+                static_cast<unsigned long long>(layout.GetNumPieces(0)),
+                static_cast<unsigned long long>(layout.GetNumPieces(1)),
+                static_cast<unsigned long long>(layout.GetNumPieces(2)),
+                static_cast<unsigned long long>(inputs.size()));
+
+            double baseSeconds = 0.0;
+            for (int pass = 0; pass < static_cast<int>(Pass::Count); pass++)
+            {
+                Snake::Simulation simulation(config.mBatch.mFirstSeed, layout);
+                Snake::RenderFrame frame(Snake::CalcMaxRenderInstances(layout));
+                Vnm::NullRenderer nullRenderer;
+                Vnm::RecordingRenderer recordingRenderer;
+                Vnm::IRenderer* renderer = pass == static_cast<int>(Pass::RecordingRenderer) ?
+                    static_cast<Vnm::IRenderer*>(&recordingRenderer) : &nullRenderer;
+
+                uint64_t numInstances = 0;
+                std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+                for (uint32_t stepInputs : inputs)
+                {
+                    if (simulation.IsOver())
+                    {
+                        simulation.Reset();
+                    }
+                    simulation.Step(stepInputs);
+
+                    if (pass != static_cast<int>(Pass::SimulationOnly))
+                    {
+                        Snake::BuildRenderInstances(simulation.GetBoard(), frame.mInstances);
+                        frame.mStepCount = simulation.GetStepCount();
+                        Vnm::DrawFrame(*renderer, frame);
+                        numInstances += frame.mInstances.size();
+                    }
+                }
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                baseSeconds = pass == static_cast<int>(Pass::SimulationOnly) ? seconds : baseSeconds;
+
+                double nanosecondsPerStep = inputs.empty() ? 0.0 : 1e9 / static_cast<double>(inputs.size());
+                printf("  %-18s %8.0f ns/step", passNames[pass], seconds * nanosecondsPerStep);
+                if (pass != static_cast<int>(Pass::SimulationOnly))
+                {
+                    printf(", frame %8.0f ns, %6.0f instances/frame",
+                        (seconds - baseSeconds) * nanosecondsPerStep,
+                        inputs.empty() ? 0.0 : static_cast<double>(numInstances) / static_cast<double>(inputs.size()));
+                }
+                if (pass == static_cast<int>(Pass::RecordingRenderer))
+                {
+                    printf(", hash %016llx", static_cast<unsigned long long>(recordingRenderer.GetHash()));
+                }
+                printf("\n");
+            }
+        }
+    }
+
+    // Draws a full board and a quarter-filled one from inside, at 1024x1024, with the software rasterizer on 1, 2, 4 ...
+    // threads. Each thread count must produce the same image.
+    void MeasureRasterizer(const RunConfig& config)
+    {
+        constexpr int ImageSize = 1024;
+        constexpr int NumFrames = 20;
+
+        const char* const boardNames[] = { "full", "quarter" };
+        for (int fill = 0; fill < 2; fill++)
+        {
+            // Every cell but the camera's, in the pattern of the game's colors
+            Snake::GameBoard board(Snake::DefaultGameBoard::Layout);
+            const Snake::BoardLayout& layout = board.GetLayout();
+            for (int z = 1; z < static_cast<int>(layout.GetNumPieces(2)) - 1; z++)
+            {
+                for (int y = 1; y < static_cast<int>(layout.GetNumPieces(1)) - 1; y++)
+                {
+                    for (int x = 1; x < static_cast<int>(layout.GetNumPieces(0)) - 1; x++)
+                    {
+                        bool isCamera = x == 1 && y == 1 && z == 1;
+                        if (isCamera || (fill == 1 && (x * 7 + y * 13 + z * 5) % 4 != 0))
+                        {
+                            continue;
+                        }
+                        bool isPowerUp = (x + y + z) % 9 == 0;
+                        board.PlaceGamePiece(x, y, z, isPowerUp ? Snake::PieceColor::PowerUp : Snake::PieceColor::SnakeBody,
+                            isPowerUp ? Snake::GamePieceType::PowerUp : Snake::GamePieceType::SnakeBody);
+                    }
+                }
+            }
+
+            Snake::RenderFrame frame(Snake::CalcMaxRenderInstances(layout));
+            Snake::BuildRenderInstances(board, frame.mInstances);
+            float position[3];
+            const float forward[3] = { 1.0f, 0.8f, 1.2f };
+            const float up[3] = { 0.0f, 1.0f, 0.0f };
+            board.GetPosition(1, 1, 1, position);
+            Vnm::CalcLookTo(position, forward, up, frame.mView);
+
+            printf("%s board, %llu instances, %dx%d:\n", boardNames[fill],
+                static_cast<unsigned long long>(frame.mInstances.size()), ImageSize, ImageSize);
+
+            double baseMilliseconds = 0.0;
+            for (size_t numThreads = 1; ; numThreads = numThreads * 2 < config.mNumThreads ? numThreads * 2 : config.mNumThreads)
+            {
+                Vnm::WorkStealingPool pool(numThreads);
+                Vnm::SoftwareRenderer renderer(pool, ImageSize, ImageSize);
+                Vnm::DrawFrame(renderer, frame);     // Warm up
+
+                std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+                for (int i = 0; i < NumFrames; i++)
+                {
+                    Vnm::DrawFrame(renderer, frame);
+                }
+                double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count() / NumFrames;
+                baseMilliseconds = numThreads == 1 ? milliseconds : baseMilliseconds;
+
+                uint64_t hash = 0;
+                const uint32_t* pixels = renderer.GetPixels();
+                for (size_t i = 0; i < static_cast<size_t>(ImageSize) * ImageSize; i++)
+                {
+                    hash = MixChecksum(hash ^ pixels[i] ^ (static_cast<uint64_t>(i) << 32));
+                }
+
+                double speedup = milliseconds > 0.0 ? baseMilliseconds / milliseconds : 0.0;
+                printf("  threads %3llu: %7.2f ms/frame, speedup %5.2f, %llu triangles, %llu binned, hash %016llx\n",
+                    static_cast<unsigned long long>(numThreads),
+                    milliseconds,
+                    speedup,
+                    static_cast<unsigned long long>(renderer.GetNumTriangles()),
+                    static_cast<unsigned long long>(renderer.GetNumBinnedTriangles()),
+                    static_cast<unsigned long long>(hash));
+
+                if (numThreads >= config.mNumThreads)
+                {
+                    if (fill == 0 && config.mScreenshotPath != nullptr && !renderer.SaveImage(config.mScreenshotPath))
+                    {
+                        printf("  failed to write %s\n", config.mScreenshotPath);
+                    }
+                    break;
+                }
+            }
+        }
+    }
+
+    // Uniform block coordinate on an axis, by multiply-shift as SampleEmptyCell draws
+    int DrawBlock(Snake::Random& random, size_t numPieces)
+    {
+        return static_cast<int>((static_cast<uint64_t>(random()) * numPieces) >> 32);
+    }
+
+    // Times power-up placement on boards filled to 1%, 50%, 99% and 100% of their interior, sampling the indexed set of
+    // empty cells against drawing random cells until one is empty, as placement used to. Each placement is removed again
+    // so the fill level holds. On a full board sampling sees no empty cell, the win, while rejection gives up after
+    // MaxDraws instead of spinning forever.
+    void MeasurePlacement(const RunConfig& config)
+    {
+        constexpr int NumPlacements = 200000;
+        constexpr uint64_t MaxDraws = 1 << 26;
+        const double occupancies[] = { 0.01, 0.5, 0.99, 1.0 };
+
+        const Snake::BoardLayout layouts[] = { Snake::DefaultGameBoard::Layout, Snake::BoardLayout(64, 64, 64) };
+        for (const Snake::BoardLayout& layout : layouts)
+        {
+            printf("board %llux%llux%llu:\n",
+                static_cast<unsigned long long>(layout.GetNumPieces(0)),
+                static_cast<unsigned long long>(layout.GetNumPieces(1)),
+                static_cast<unsigned long long>(layout.GetNumPieces(2)));
+
+            for (double occupancy : occupancies)
+            {
+                Snake::GameBoard board(layout);
+                Snake::Random random(config.mBatch.mFirstSeed);
+                size_t numInteriorCells = layout.GetNumInteriorCells();
+                size_t numFilled = static_cast<size_t>(occupancy * static_cast<double>(numInteriorCells) + 0.5);
+                while (numInteriorCells - board.EmptyCellCount() < numFilled)
+                {
+                    int x;
+                    int y;
+                    int z;
+                    board.GetCellCoords(board.SampleEmptyCell(random), x, y, z);
+                    board.PlaceGamePiece(x, y, z, Snake::PieceColor::SnakeBody, Snake::GamePieceType::SnakeBody);
+                }
+
+                uint64_t numSampled = 0;
+                std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+                for (int i = 0; i < NumPlacements && board.EmptyCellCount() > 0; i++)
+                {
+                    int x;
+                    int y;
+                    int z;
+                    board.GetCellCoords(board.SampleEmptyCell(random), x, y, z);
+                    board.PlaceGamePiece(x, y, z, Snake::PieceColor::PowerUp, Snake::GamePieceType::PowerUp);
+                    board.RemoveGamePiece(x, y, z);
+                    numSampled++;
+                }
+                double sampleSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+                uint64_t numRejected = 0;
+                uint64_t numDraws = 0;
+                startTime = std::chrono::steady_clock::now();
+                while (numRejected < NumPlacements && numDraws < MaxDraws)
+                {
+                    numDraws++;
+                    int x = DrawBlock(random, layout.GetNumPieces(0));
+                    int y = DrawBlock(random, layout.GetNumPieces(1));
+                    int z = DrawBlock(random, layout.GetNumPieces(2));
+                    if (board.GetGamePieceType(x, y, z) == Snake::GamePieceType::Empty)
+                    {
+                        board.PlaceGamePiece(x, y, z, Snake::PieceColor::PowerUp, Snake::GamePieceType::PowerUp);
+                        board.RemoveGamePiece(x, y, z);
+                        numRejected++;
+                    }
+                }
+                double rejectSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+                printf("  occupancy %5.1f%%: ", 100.0 * static_cast<double>(numFilled) / static_cast<double>(numInteriorCells));
+                if (numSampled > 0)
+                {
+                    printf("indexed %7.1f ns/placement, ", sampleSeconds * 1e9 / static_cast<double>(numSampled));
+                }
+                else
+                {
+                    printf("indexed finds the board full, ");
+                }
+                if (numRejected > 0)
+                {
+                    printf("rejection %10.1f ns/placement, %.1f draws each\n",
+                        rejectSeconds * 1e9 / static_cast<double>(numRejected),
+                        static_cast<double>(numDraws) / static_cast<double>(numRejected));
+                }
+                else
+                {
+                    printf("rejection gave up after %llu draws, %.0f ms\n", static_cast<unsigned long long>(numDraws), rejectSeconds * 1000.0);
+                }
+            }
+        }
+    }
+
+    // Advances a snake of fixed length through the interior of 16^3, 64^3 and 256^3 boards, once by sweeping every cell
+    // to age and drop body pieces by their remaining ticks, as each cell entered used to, and once with the body's ring
+    // buffer. Both leave the same cells occupied, so their board hashes must agree.
+    bool MeasureBodySweep(const RunConfig&)
+    {
+        constexpr size_t BodyLength = 64;
+        constexpr size_t CellsSweptPerSize = size_t(1) << 28;
+        constexpr size_t NumRingSteps = 1 << 22;
+
+        bool allMatch = true;
+        const size_t sizes[] = { 16, 64, 256 };
+        for (size_t size : sizes)
+        {
+            Snake::BoardLayout layout(size, size, size);
+            size_t interior = size - 2;
+            size_t numInteriorCells = layout.GetNumInteriorCells();
+
+            // The head walks the interior cells in index order, wrapping around
+            auto headCell = [&](uint64_t step)
+            {
+                size_t i = static_cast<size_t>(step % numInteriorCells);
+                return layout.CalcIndex(static_cast<int>(i % interior) + 1, static_cast<int>(i / interior % interior) + 1,
+                    static_cast<int>(i / (interior * interior)) + 1);
+            };
+            auto hashCells = [&](const std::vector<uint8_t>& types)
+            {
+                uint64_t hash = 0;
+                for (size_t i = 0; i < types.size(); i++)
+                {
+                    hash = types[i] != 0 ? MixChecksum(hash ^ i) : hash;
+                }
+                return hash;
+            };
+
+            std::vector<uint8_t> types(layout.GetNumCells(), 0);
+            std::vector<uint16_t> remainingTicks(layout.GetNumCells(), 0);
+            uint64_t numSweepSteps = std::max<uint64_t>(BodyLength * 2, CellsSweptPerSize / numInteriorCells);
+            std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            for (uint64_t step = 0; step < numSweepSteps; step++)
+            {
+                for (int z = 1; z <= static_cast<int>(interior); z++)
+                {
+                    for (int y = 1; y <= static_cast<int>(interior); y++)
+                    {
+                        for (int x = 1; x <= static_cast<int>(interior); x++)
+                        {
+                            size_t cell = layout.CalcIndex(x, y, z);
+                            if (types[cell] != 0 && --remainingTicks[cell] == 0)
+                            {
+                                types[cell] = 0;
+                            }
+                        }
+                    }
+                }
+
+                size_t head = headCell(step);
+                types[head] = 1;
+                remainingTicks[head] = static_cast<uint16_t>(BodyLength);
+            }
+            double sweepSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            uint64_t sweepHash = hashCells(types);
+
+            std::fill(types.begin(), types.end(), 0);
+            Snake::SnakeBody body;
+            body.Init(BodyLength + 1);
+            startTime = std::chrono::steady_clock::now();
+            for (uint64_t step = 0; step < NumRingSteps; step++)
+            {
+                size_t head = headCell(step);
+                body.PushHead(head);
+                types[head] = 1;
+                if (body.GetLength() > BodyLength)
+                {
+                    types[body.PopTail()] = 0;
+                }
+            }
+            double ringSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+            // Same end state needs the same number of steps
+            std::fill(types.begin(), types.end(), 0);
+            body.Reset();
+            for (uint64_t step = 0; step < numSweepSteps; step++)
+            {
+                size_t head = headCell(step);
+                body.PushHead(head);
+                types[head] = 1;
+                if (body.GetLength() > BodyLength)
+                {
+                    types[body.PopTail()] = 0;
+                }
+            }
+
+            bool matches = hashCells(types) == sweepHash;
+            allMatch &= matches;
+            printf("board %llu^3, body %llu: sweep %12.1f ns/step, ring buffer %6.1f ns/step, %s\n",
+                static_cast<unsigned long long>(size),
+                static_cast<unsigned long long>(BodyLength),
+                sweepSeconds * 1e9 / static_cast<double>(numSweepSteps),
+                ringSeconds * 1e9 / static_cast<double>(NumRingSteps),
+                matches ? "match" : "MISMATCH");
+        }
+        return allMatch;
+    }
+
+    // Reports board storage and per-step cost on cubic boards from 16^3 to 512^3. Inputs come from a first play through,
+    // so the timed replay of them measures the simulation alone; games stop where they end rather than restart.
+    bool MeasureBoardSizes(const RunConfig& config)
+    {
+        constexpr uint64_t NumSteps = 200000;
+
+        bool allMatch = true;
+        for (size_t size = 16; size <= 512; size *= 2)
+        {
+            Snake::BoardLayout layout(size, size, size);
+            std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            Snake::Simulation simulation(config.mBatch.mFirstSeed, layout);
+            double constructSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+            std::vector<uint32_t> inputs;
+            std::unique_ptr<Snake::Policy> policy = Snake::CreatePolicy(config.mBatch.mPolicy);
+            policy->Reset(config.mBatch.mFirstSeed);
+            Snake::StepResult lastResult = Snake::StepResult::EnteredCell;
+            while (!simulation.IsOver() && inputs.size() < std::min(config.mBatch.mMaxStepsPerGame, NumSteps))
+            {
+                inputs.push_back(policy->ChooseInputs(simulation, lastResult));
+                lastResult = simulation.Step(inputs.back());
+            }
+            uint64_t hash = simulation.GetHash();
+
+            simulation.Reset(config.mBatch.mFirstSeed);
+            startTime = std::chrono::steady_clock::now();
+            for (uint32_t stepInputs : inputs)
+            {
+                simulation.Step(stepInputs);
+            }
+            double stepSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+            bool matches = simulation.GetHash() == hash;
+            allMatch &= matches;
+
+            // Storage is one block per board; the body ring buffer is sized to fill the board
+            double boardBytes = static_cast<double>(simulation.GetBoard().GetStorageSize());
+            double bodyBytes = static_cast<double>(layout.GetNumCells()) * sizeof(uint32_t);
+            double numCells = static_cast<double>(layout.GetNumCells());
+            printf("board %3llu^3: board %9.2f MB (%.1f bytes/cell), body %8.2f MB, construct %8.2f ms, %6.1f ns/step over %llu steps, %s\n",
+                static_cast<unsigned long long>(size),
+                boardBytes / (1024.0 * 1024.0),
+                boardBytes / numCells,
+                bodyBytes / (1024.0 * 1024.0),
+                constructSeconds * 1000.0,
+                inputs.empty() ? 0.0 : stepSeconds * 1e9 / static_cast<double>(inputs.size()),
+                static_cast<unsigned long long>(inputs.size()),
+                matches ? "match" : "MISMATCH");
+        }
+        return allMatch;
+    }
+
+    // Board cell as stored before the structure of arrays layout: a pooled piece per occupied cell, reached through a
+    // per-cell pointer, with its color and position held as vectors
+    class alignas(16) LegacyGamePiece
+    {
+    public:
+        float               mColor[4];
+        float               mPosition[4];
+        LegacyGamePiece*    mNext;
+        int                 mRemainingTicks;
+        Snake::GamePieceType mGamePieceType;
+    };
+
+    // Body pieces in the low half, power-ups in the high half
+    BENCHMARK_KERNEL uint64_t CountPieces(const Snake::GamePieceType* types, size_t numCells)
+    {
+        // Comparisons summed in 32 bits rather than branches let the loop vectorize
+        uint32_t numBodies = 0;
+        uint32_t numPowerUps = 0;
+        for (size_t i = 0; i < numCells; i++)
+        {
+            numBodies += types[i] == Snake::GamePieceType::SnakeBody ? 1 : 0;
+            numPowerUps += types[i] == Snake::GamePieceType::PowerUp ? 1 : 0;
+        }
+        return numBodies + (static_cast<uint64_t>(numPowerUps) << 32);
+    }
+
+    BENCHMARK_KERNEL uint64_t CountLegacyPieces(const LegacyGamePiece* const* cells, size_t numCells)
+    {
+        uint64_t count = 0;
+        for (size_t i = 0; i < numCells; i++)
+        {
+            const LegacyGamePiece* piece = cells[i];
+            if (piece != nullptr)
+            {
+                count += piece->mGamePieceType == Snake::GamePieceType::SnakeBody ? 1 : uint64_t(1) << 32;
+            }
+        }
+        return count;
+    }
+
+    // Scans every cell of half-full boards counting body pieces and power-ups, through the per-cell piece pointers and
+    // pool of the old layout and through the type array now. Pieces are placed in random order, so the old scan chases
+    // pointers across a pool of 64 byte pieces while the new one streams a byte per cell.
+    bool MeasureBoardScan(const RunConfig& config)
+    {
+        constexpr size_t CellsScannedPerSize = size_t(1) << 28;
+
+        bool allMatch = true;
+        const size_t sizes[] = { 16, 64, 256 };
+        for (size_t size : sizes)
+        {
+            Snake::BoardLayout layout(size, size, size);
+            Snake::GameBoard board(layout);
+            std::vector<LegacyGamePiece> legacyPool(layout.GetNumCells());
+            std::vector<LegacyGamePiece*> legacyCells(layout.GetNumCells(), nullptr);
+
+            // Pieces came off the old pool's free list in order, so the nth piece placed is the nth in the pool
+            Snake::Random random(config.mBatch.mFirstSeed);
+            size_t numPlaced = 0;
+            while (numPlaced < layout.GetNumInteriorCells() / 2)
+            {
+                size_t cell = board.SampleEmptyCell(random);
+                bool isPowerUp = random() % 16 == 0;
+                Snake::GamePieceType type = isPowerUp ? Snake::GamePieceType::PowerUp : Snake::GamePieceType::SnakeBody;
+                int x;
+                int y;
+                int z;
+                board.GetCellCoords(cell, x, y, z);
+                board.PlaceGamePiece(x, y, z, isPowerUp ? Snake::PieceColor::PowerUp : Snake::PieceColor::SnakeBody, type);
+
+                LegacyGamePiece& piece = legacyPool[numPlaced++];
+                memcpy(piece.mColor, Snake::GetPaletteColor(board.GetGamePieceColor(cell)), sizeof(piece.mColor));
+                board.GetPosition(x, y, z, piece.mPosition);
+                piece.mPosition[3] = 1.0f;
+                piece.mNext = nullptr;
+                piece.mRemainingTicks = 0;
+                piece.mGamePieceType = type;
+                legacyCells[cell] = &piece;
+            }
+
+            size_t numCells = layout.GetNumCells();
+            int numScans = static_cast<int>(std::max<size_t>(1, CellsScannedPerSize / numCells));
+            // Read back through volatile pointers each time, so scans of unchanged cells cannot be hoisted out of the loop
+            LegacyGamePiece* const* volatile legacyCellData = legacyCells.data();
+            uint64_t legacyCount = 0;
+            std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            for (int scan = 0; scan < numScans; scan++)
+            {
+                legacyCount += CountLegacyPieces(legacyCellData, numCells);
+            }
+            double legacySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+            const Snake::GamePieceType* volatile types = board.GetGamePieceTypes();
+            uint64_t count = 0;
+            startTime = std::chrono::steady_clock::now();
+            for (int scan = 0; scan < numScans; scan++)
+            {
+                count += CountPieces(types, numCells);
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+            bool matches = count == legacyCount;
+            allMatch &= matches;
+            double cellsScanned = static_cast<double>(numCells) * numScans;
+            printf("board %3llu^3: pointers and pool %10.0f KB, %6.2f ns/cell; type array %8.0f KB, %6.2f ns/cell; %5.1fx, %s\n",
+                static_cast<unsigned long long>(size),
+                static_cast<double>(numCells * (sizeof(LegacyGamePiece) + sizeof(LegacyGamePiece*))) / 1024.0,
+                legacySeconds * 1e9 / cellsScanned,
+                static_cast<double>(numCells * sizeof(Snake::GamePieceType)) / 1024.0,
+                seconds * 1e9 / cellsScanned,
+                seconds > 0.0 ? legacySeconds / seconds : 0.0,
+                matches ? "match" : "MISMATCH");
+        }
+        return allMatch;
+    }
+
+    // Cache line sized object, about what a pooled game piece or node weighs
+    class ChurnObject
+    {
+    public:
+        explicit ChurnObject(uint64_t value) { for (uint64_t& v : mValues) { v = value; } }
+
+        uint64_t mValues[8];
+    };
+
+    // The intrusive free list pools used before Vnm::Pool: stable slots, a next pointer, and a scan of every slot to iterate
+    class LegacyChurnPool
+    {
+    public:
+        class Entry
+        {
+        public:
+            alignas(ChurnObject) unsigned char mStorage[sizeof(ChurnObject)];
+            Entry* mNext;
+            bool   mLive;
+        };
+
+        explicit LegacyChurnPool(size_t capacity)
+            : mEntries(capacity)
+        {
+            for (size_t i = 0; i < capacity; i++)
+            {
+                mEntries[i].mNext = i + 1 < capacity ? &mEntries[i + 1] : nullptr;
+                mEntries[i].mLive = false;
+            }
+            mFree = mEntries.data();
+        }
+
+        ChurnObject* Alloc(uint64_t value)
+        {
+            Entry* entry = mFree;
+            mFree = entry->mNext;
+            entry->mLive = true;
+            return new (entry->mStorage) ChurnObject(value);
+        }
+
+        void Free(ChurnObject* object)
+        {
+            Entry* entry = reinterpret_cast<Entry*>(object);
+            object->~ChurnObject();
+            entry->mLive = false;
+            entry->mNext = mFree;
+            mFree = entry;
+        }
+
+        uint64_t Sum() const
+        {
+            uint64_t sum = 0;
+            for (const Entry& entry : mEntries)
+            {
+                if (entry.mLive)
+                {
+                    sum += reinterpret_cast<const ChurnObject*>(entry.mStorage)->mValues[0];
+                }
+            }
+            return sum;
+        }
+
+    private:
+        std::vector<Entry> mEntries;
+        Entry*             mFree;
+    };
+
+    // Replaces a random live object with a new one numOps times, summing every live object every SumInterval ops
+    template<typename AllocFunc, typename FreeFunc, typename SumFunc, typename Handle> uint64_t RunChurn(uint64_t seed, size_t numLive,
+        uint64_t numOps, std::vector<Handle>& live, const AllocFunc& alloc, const FreeFunc& free, const SumFunc& sum)
+    {
+        constexpr uint64_t SumInterval = 1024;
+
+        Snake::Random random(seed);
+        live.clear();
+        for (size_t i = 0; i < numLive; i++)
+        {
+            live.push_back(alloc(random()));
+        }
+
+        uint64_t checksum = 0;
+        for (uint64_t op = 0; op < numOps; op++)
+        {
+            size_t index = random() % live.size();
+            free(live[index]);
+            live[index] = alloc(random());
+            if (op % SumInterval == 0)
+            {
+                checksum = MixChecksum(checksum ^ sum());
+            }
+        }
+
+        for (Handle& handle : live)
+        {
+            free(handle);
+        }
+        return checksum;
+    }
+
+    bool MeasurePoolChurn(const RunConfig& config)
+    {
+        constexpr size_t Capacity = 4096;
+        constexpr size_t NumLive = Capacity / 2;
+        constexpr uint64_t NumOps = uint64_t(1) << 23;
+        constexpr uint32_t IndexBits = Vnm::CalcPoolIndexBits(Capacity);
+        using ChurnPool = Vnm::Pool<ChurnObject, Capacity>;
+
+        // Stale handles and handles that were never handed out must both resolve to null
+        std::unique_ptr<ChurnPool> pool = std::make_unique<ChurnPool>();
+        Vnm::PoolHandle stale = pool->Alloc(1);
+        pool->Free(stale);
+        Vnm::PoolHandle forged((1u << IndexBits) | 5);
+        bool liveness = pool->Get(stale) == nullptr && pool->Get(forged) == nullptr;
+
+        std::vector<Vnm::PoolHandle> handles;
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        uint64_t poolChecksum = RunChurn(config.mBatch.mFirstSeed, NumLive, NumOps, handles,
+            [&](uint64_t value) { return pool->Alloc(value); },
+            [&](Vnm::PoolHandle handle) { pool->Free(handle); },
+            [&]()
+            {
+                uint64_t sum = 0;
+                for (const ChurnObject& object : *pool)
+                {
+                    sum += object.mValues[0];
+                }
+                return sum;
+            });
+        double poolSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        liveness &= pool->GetSize() == 0 && pool->Get(handles[0]) == nullptr;
+
+        LegacyChurnPool legacyPool(Capacity);
+        std::vector<ChurnObject*> pointers;
+        startTime = std::chrono::steady_clock::now();
+        uint64_t legacyChecksum = RunChurn(config.mBatch.mFirstSeed, NumLive, NumOps, pointers,
+            [&](uint64_t value) { return legacyPool.Alloc(value); },
+            [&](ChurnObject* object) { legacyPool.Free(object); },
+            [&]() { return legacyPool.Sum(); });
+        double legacySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        startTime = std::chrono::steady_clock::now();
+        uint64_t heapChecksum = RunChurn(config.mBatch.mFirstSeed, NumLive, NumOps, pointers,
+            [&](uint64_t value) { return new ChurnObject(value); },
+            [&](ChurnObject* object) { delete object; },
+            [&]()
+            {
+                uint64_t sum = 0;
+                for (const ChurnObject* object : pointers)
+                {
+                    sum += object->mValues[0];
+                }
+                return sum;
+            });
+        double heapSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        bool matches = poolChecksum == legacyChecksum && poolChecksum == heapChecksum;
+        printf("churn, %llu of %llu live: pool %.1f ns/op, intrusive free list %.1f ns/op, new/delete %.1f ns/op; %s, %s\n",
+            static_cast<unsigned long long>(NumLive), static_cast<unsigned long long>(Capacity),
+            poolSeconds * 1e9 / NumOps, legacySeconds * 1e9 / NumOps, heapSeconds * 1e9 / NumOps,
+            matches ? "match" : "MISMATCH", liveness ? "stale and forged handles rejected" : "LIVENESS FAILED");
+
+        // Every thread churns its own live set out of one shared pool, going through its worker's cache
+        constexpr size_t SharedCapacity = size_t(1) << 16;
+        constexpr size_t NumLivePerTask = 256;
+        constexpr uint64_t NumOpsPerTask = uint64_t(1) << 20;
+        constexpr uint32_t SharedIndexBits = Vnm::CalcPoolIndexBits(SharedCapacity);
+        using SharedChurnPool = Vnm::SharedPool<ChurnObject, SharedCapacity>;
+
+        for (size_t numThreads = 1; ; numThreads = numThreads * 2 < config.mNumThreads ? numThreads * 2 : config.mNumThreads)
+        {
+            Vnm::WorkStealingPool threadPool(numThreads);
+            std::unique_ptr<SharedChurnPool> sharedPool = std::make_unique<SharedChurnPool>();
+            std::vector<SharedChurnPool::Cache> caches(numThreads);
+            std::vector<std::vector<Vnm::PoolHandle>> sharedHandles(numThreads);
+            std::vector<std::vector<ChurnObject*>> heapPointers(numThreads);
+            std::vector<uint64_t> sharedChecksums(numThreads);
+            std::vector<uint64_t> heapChecksums(numThreads);
+            std::atomic<bool> sharedLiveness(true);
+
+            startTime = std::chrono::steady_clock::now();
+            threadPool.ParallelFor(numThreads, [&](size_t workerIndex, size_t task)
+            {
+                SharedChurnPool::Cache& cache = caches[workerIndex];
+                std::vector<Vnm::PoolHandle>& live = sharedHandles[task];
+                sharedChecksums[task] = RunChurn(config.mBatch.mFirstSeed + task, NumLivePerTask, NumOpsPerTask, live,
+                    [&](uint64_t value) { return sharedPool->Alloc(cache, value); },
+                    [&](Vnm::PoolHandle handle) { sharedPool->Free(cache, handle); },
+                    [&]()
+                    {
+                        uint64_t sum = 0;
+                        for (Vnm::PoolHandle handle : live)
+                        {
+                            sum += sharedPool->Get(handle)->mValues[0];
+                        }
+                        return sum;
+                    });
+                if (sharedPool->Get(live[0]) != nullptr)
+                {
+                    sharedLiveness = false;
+                }
+            });
+            double sharedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            for (SharedChurnPool::Cache& cache : caches)
+            {
+                sharedPool->Flush(cache);
+            }
+            Vnm::PoolHandle sharedForged((1u << SharedIndexBits) | 7);
+            if (sharedPool->Get(sharedForged) != nullptr)
+            {
+                sharedLiveness = false;
+            }
+
+            startTime = std::chrono::steady_clock::now();
+            threadPool.ParallelFor(numThreads, [&](size_t, size_t task)
+            {
+                std::vector<ChurnObject*>& live = heapPointers[task];
+                heapChecksums[task] = RunChurn(config.mBatch.mFirstSeed + task, NumLivePerTask, NumOpsPerTask, live,
+                    [&](uint64_t value) { return new ChurnObject(value); },
+                    [&](ChurnObject* object) { delete object; },
+                    [&]()
+                    {
+                        uint64_t sum = 0;
+                        for (const ChurnObject* object : live)
+                        {
+                            sum += object->mValues[0];
+                        }
+                        return sum;
+                    });
+            });
+            double heapThreadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+            // Untimed, a thread of its own keeps checking each worker's most recently freed handle while they churn
+            std::unique_ptr<std::atomic<uint32_t>[]> retired(new std::atomic<uint32_t>[numThreads]);
+            for (size_t task = 0; task < numThreads; task++)
+            {
+                retired[task].store(0, std::memory_order_relaxed);
+            }
+            std::atomic<bool> churning(true);
+            uint64_t numStaleChecks = 0;
+            uint64_t numStaleFound = 0;
+            std::thread reader([&]()
+            {
+                while (churning.load(std::memory_order_relaxed))
+                {
+                    for (size_t task = 0; task < numThreads; task++)
+                    {
+                        uint32_t value = retired[task].load(std::memory_order_acquire);
+                        if (value != 0)
+                        {
+                            numStaleChecks++;
+                            numStaleFound += sharedPool->IsValid(Vnm::PoolHandle(value)) ? 1 : 0;
+                        }
+                    }
+                }
+            });
+            threadPool.ParallelFor(numThreads, [&](size_t workerIndex, size_t task)
+            {
+                SharedChurnPool::Cache& cache = caches[workerIndex];
+                std::vector<Vnm::PoolHandle>& live = sharedHandles[task];
+                RunChurn(config.mBatch.mFirstSeed + task, NumLivePerTask, NumOpsPerTask / 4, live,
+                    [&](uint64_t value) { return sharedPool->Alloc(cache, value); },
+                    [&](Vnm::PoolHandle handle)
+                    {
+                        sharedPool->Free(cache, handle);
+                        retired[task].store(handle.GetValue(), std::memory_order_release);
+                    },
+                    [&]() { return uint64_t(0); });
+            });
+            churning = false;
+            reader.join();
+            for (SharedChurnPool::Cache& cache : caches)
+            {
+                sharedPool->Flush(cache);
+            }
+            sharedLiveness = sharedLiveness && numStaleFound == 0;
+
+            bool threadMatches = sharedChecksums == heapChecksums;
+            matches &= threadMatches;
+            liveness &= sharedLiveness;
+            double numThreadOps = static_cast<double>(NumOpsPerTask * numThreads);
+            printf("%2llu threads: shared pool with caches %6.1f Mops/s, new/delete %6.1f Mops/s; %llu stale handles checked from another thread; %s\n",
+                static_cast<unsigned long long>(numThreads),
+                numThreadOps / sharedSeconds * 1e-6, numThreadOps / heapThreadSeconds * 1e-6,
+                static_cast<unsigned long long>(numStaleChecks),
+                threadMatches && sharedLiveness ? "match" : "MISMATCH");
+
+            if (numThreads >= config.mNumThreads)
+            {
+                break;
+            }
+        }
+
+        return matches && liveness;
+    }
+
+    // Sums the types found at a list of cells, so lookups cannot be skipped
+    template<typename Board> BENCHMARK_KERNEL uint64_t LookUpCells(const Board& board, const std::vector<int>& coords)
+    {
+        uint64_t sum = 0;
+        for (size_t i = 0; i < coords.size(); i += 3)
+        {
+            sum += static_cast<uint64_t>(board.GetGamePieceType(coords[i], coords[i + 1], coords[i + 2]));
+        }
+        return sum;
+    }
+
+    bool MeasureSparseBoard(const RunConfig& config)
+    {
+        constexpr size_t NumPieces = 1 << 16;
+        constexpr size_t NumLookups = 1 << 22;
+        constexpr size_t MaxDenseBytes = size_t(1) << 30;
+
+        bool allMatch = true;
+        const size_t sizes[] = { 64, 256, 1024 };
+        for (size_t size : sizes)
+        {
+            // A snake-like random walk from the centre, the clustered occupancy sparse boards are built for
+            Snake::BoardLayout layout(size, size, size);
+            Snake::SparseGameBoard sparseBoard(layout);
+            bool buildDense = Snake::GameBoard::CalcStorageSize(layout) <= MaxDenseBytes;
+            std::unique_ptr<Snake::GameBoard> denseBoard = buildDense ? std::make_unique<Snake::GameBoard>(layout) : nullptr;
+
+            Snake::Random random(config.mBatch.mFirstSeed);
+            int cell[3] = { static_cast<int>(size / 2), static_cast<int>(size / 2), static_cast<int>(size / 2) };
+            std::vector<int> occupied;
+            while (sparseBoard.GetNumOccupiedCells() < std::min(NumPieces, layout.GetNumInteriorCells() / 4))
+            {
+                int axis = static_cast<int>(random() % 3);
+                int next = cell[axis] + ((random() & 1) ? 1 : -1);
+                if (next <= 0 || next >= static_cast<int>(size) - 1)
+                {
+                    continue;
+                }
+                cell[axis] = next;
+                if (sparseBoard.GetGamePieceType(cell[0], cell[1], cell[2]) != Snake::GamePieceType::Empty)
+                {
+                    continue;
+                }
+
+                sparseBoard.PlaceGamePiece(cell[0], cell[1], cell[2], Snake::PieceColor::SnakeBody, Snake::GamePieceType::SnakeBody);
+                if (denseBoard != nullptr)
+                {
+                    denseBoard->PlaceGamePiece(cell[0], cell[1], cell[2], Snake::PieceColor::SnakeBody, Snake::GamePieceType::SnakeBody);
+                }
+                occupied.insert(occupied.end(), cell, cell + 3);
+            }
+
+            // The visitor has to find exactly the cells that were placed
+            uint64_t placedSum = 0;
+            for (size_t i = 0; i < occupied.size(); i += 3)
+            {
+                placedSum += layout.CalcIndex(occupied[i], occupied[i + 1], occupied[i + 2]);
+            }
+            uint64_t visitedSum = 0;
+            size_t numVisited = 0;
+            sparseBoard.ForEachOccupiedCell([&](int x, int y, int z, Snake::GamePieceType type, Snake::PieceColor)
+            {
+                visitedSum += layout.CalcIndex(x, y, z);
+                numVisited += type == Snake::GamePieceType::SnakeBody ? 1 : 0;
+            });
+            bool matches = visitedSum == placedSum && numVisited == sparseBoard.GetNumOccupiedCells();
+
+            // Half the lookups hit placed cells and half land anywhere on the board
+            std::vector<int> lookups;
+            lookups.reserve(NumLookups * 3);
+            for (size_t i = 0; i < NumLookups; i++)
+            {
+                if (i & 1)
+                {
+                    size_t piece = random() % (occupied.size() / 3);
+                    lookups.insert(lookups.end(), occupied.begin() + piece * 3, occupied.begin() + piece * 3 + 3);
+                }
+                else
+                {
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        lookups.push_back(static_cast<int>(random() % size));
+                    }
+                }
+            }
+
+            std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            uint64_t sparseSum = LookUpCells(sparseBoard, lookups);
+            double sparseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+            double numOccupied = static_cast<double>(sparseBoard.GetNumOccupiedCells());
+            printf("board %4llu^3, %llu pieces: sparse %8.1f bytes/piece, %5.1f ns/lookup; ",
+                static_cast<unsigned long long>(size), static_cast<unsigned long long>(sparseBoard.GetNumOccupiedCells()),
+                static_cast<double>(sparseBoard.GetMemoryUsage()) / numOccupied, sparseSeconds * 1e9 / NumLookups);
+            if (denseBoard != nullptr)
+            {
+                startTime = std::chrono::steady_clock::now();
+                uint64_t denseSum = LookUpCells(*denseBoard, lookups);
+                double denseSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                matches &= denseSum == sparseSum;
+                printf("dense %10.1f bytes/piece, %5.1f ns/lookup; %s\n",
+                    static_cast<double>(denseBoard->GetStorageSize()) / numOccupied, denseSeconds * 1e9 / NumLookups,
+                    matches ? "match" : "MISMATCH");
+            }
+            else
+            {
+                printf("dense would need %.0f MB; %s\n", static_cast<double>(Snake::GameBoard::CalcStorageSize(layout)) / (1024.0 * 1024.0),
+                    matches ? "match" : "MISMATCH");
+            }
+            allMatch &= matches;
+        }
+        return allMatch;
+    }
+
+    // The reset before the initial board was baked: classify every cell and rebuild the empty list and slots in a loop
+    BENCHMARK_KERNEL void RebuildBoard(const Snake::BoardLayout& layout, Snake::GamePieceType* types, uint32_t* emptyCells, uint32_t* cellSlots)
+    {
+        uint32_t numEmptyCells = 0;
+        for (size_t i = 0; i < layout.GetNumCells(); i++)
+        {
+            int xBlock;
+            int yBlock;
+            int zBlock;
+            layout.CalcCoords(i, xBlock, yBlock, zBlock);
+
+            if (layout.IsWall(xBlock, yBlock, zBlock))
+            {
+                types[i] = Snake::GamePieceType::Wall;
+                cellSlots[i] = 0;
+            }
+            else
+            {
+                types[i] = Snake::GamePieceType::Empty;
+                emptyCells[numEmptyCells] = static_cast<uint32_t>(i);
+                cellSlots[i] = numEmptyCells++;
+            }
+        }
+    }
+
+    bool MeasureReset(const RunConfig& config)
+    {
+        constexpr size_t CellsResetPerSize = size_t(1) << 28;
+
+        bool allMatch = true;
+        const size_t sizes[] = { 16, 64, 128 };
+        for (size_t size : sizes)
+        {
+            Snake::BoardLayout layout(size, size, size);
+            Snake::Simulation simulation(config.mBatch.mFirstSeed, layout);
+            size_t numCells = layout.GetNumCells();
+            int numResets = static_cast<int>(std::max<size_t>(1, CellsResetPerSize / numCells));
+
+            std::vector<Snake::GamePieceType> types(numCells);
+            std::vector<uint32_t> emptyCells(layout.GetNumInteriorCells());
+            std::vector<uint32_t> cellSlots(numCells);
+            std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            for (int reset = 0; reset < numResets; reset++)
+            {
+                RebuildBoard(layout, types.data(), emptyCells.data(), cellSlots.data());
+            }
+            double rebuildSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+            Snake::GameBoard board(layout);
+            startTime = std::chrono::steady_clock::now();
+            for (int reset = 0; reset < numResets; reset++)
+            {
+                board.Reset();
+            }
+            double copySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+            // Whole games: board copy, snake and power-up placement, cameras
+            startTime = std::chrono::steady_clock::now();
+            for (int reset = 0; reset < numResets; reset++)
+            {
+                simulation.Reset(config.mBatch.mFirstSeed + reset);
+            }
+            double gameSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+            bool matches = memcmp(types.data(), board.GetGamePieceTypes(), numCells * sizeof(Snake::GamePieceType)) == 0 &&
+                memcmp(emptyCells.data(), board.GetEmptyCells(), emptyCells.size() * sizeof(uint32_t)) == 0;
+            for (size_t i = 0; i < numCells && matches; i++)
+            {
+                matches = cellSlots[i] == board.GetCellSlot(i);
+            }
+            allMatch &= matches;
+
+            printf("board %3llu^3: rebuild %12.0f resets/s, baked copy %12.0f resets/s, %5.1fx; game reset %12.0f resets/s; %s\n",
+                static_cast<unsigned long long>(size),
+                numResets / rebuildSeconds, numResets / copySeconds, copySeconds > 0.0 ? rebuildSeconds / copySeconds : 0.0,
+                numResets / gameSeconds, matches ? "match" : "MISMATCH");
+        }
+        return allMatch;
+    }
+
+    // Times every observation encoding on a game in progress, on the default board and a large one
+    void MeasureEncoding(const RunConfig& config)
+    {
+        constexpr size_t CellsEncodedPerCase = size_t(1) << 30;
+        constexpr int Radius = 4;
+
+        const Snake::BoardLayout layouts[] = { Snake::DefaultGameBoard::Layout, Snake::BoardLayout(64, 64, 64) };
+        for (const Snake::BoardLayout& layout : layouts)
+        {
+            // Play a while so the body age and power-up channels have something in them
+            Snake::Simulation simulation(config.mBatch.mFirstSeed, layout);
+            std::unique_ptr<Snake::Policy> policy = Snake::CreatePolicy(config.mBatch.mPolicy);
+            policy->Reset(config.mBatch.mFirstSeed);
+            Snake::StepResult lastResult = Snake::StepResult::EnteredCell;
+            while (!simulation.IsOver() && simulation.GetStepCount() < config.mBatch.mMaxStepsPerGame &&
+                simulation.GetBodyLength() < layout.GetNumInteriorCells() / 8)
+            {
+                lastResult = simulation.Step(lastResult != Snake::StepResult::Moved ? policy->ChooseInputs(simulation, lastResult) : 0);
+            }
+
+            const Snake::ObservationFormat formats[] = { Snake::ObservationFormat::UInt8, Snake::ObservationFormat::Float16 };
+            for (Snake::ObservationFormat format : formats)
+            {
+                const char* formatName = format == Snake::ObservationFormat::UInt8 ? "uint8" : "float16";
+                for (int egocentric = 0; egocentric < 2; egocentric++)
+                {
+                    size_t size = egocentric ? Snake::GetEgocentricObservationSize(Radius, format) : Snake::GetGridObservationSize(layout, format);
+                    std::vector<uint8_t> observation(size);
+                    int numEncodes = static_cast<int>(std::max<size_t>(16, CellsEncodedPerCase / size));
+
+                    std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+                    for (int encode = 0; encode < numEncodes; encode++)
+                    {
+                        if (egocentric)
+                        {
+                            Snake::EncodeEgocentricObservation(simulation, Radius, format, observation.data());
+                        }
+                        else
+                        {
+                            Snake::EncodeGridObservation(simulation, format, observation.data());
+                        }
+                    }
+                    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+                    printf("board %llux%llux%llu, body %llu: %-16s %-7s %9llu bytes, %10.1f ns/observation, %6.2f GB/s\n",
+                        static_cast<unsigned long long>(layout.GetNumPieces(0)),
+                        static_cast<unsigned long long>(layout.GetNumPieces(1)),
+                        static_cast<unsigned long long>(layout.GetNumPieces(2)),
+                        static_cast<unsigned long long>(simulation.GetBodyLength()),
+                        egocentric ? "egocentric r4" : "grid", formatName,
+                        static_cast<unsigned long long>(size),
+                        seconds * 1e9 / numEncodes,
+                        static_cast<double>(size) * numEncodes / seconds * 1e-9);
+                }
+            }
+        }
+    }
+
+    // Value stored for a key: the high half follows from the key, the low half is free to change between stores
+    uint64_t MakeTableValue(uint64_t hash, uint64_t version)
+    {
+        return (MixChecksum(hash) & 0xffffffff00000000ull) | (version & 0xffffffffu);
+    }
+
+    // Threads store and probe a small key set in a smaller table, so stores keep evicting and overwriting entries that
+    // other threads are probing; a probe must either miss or return a value that was stored for its key
+    bool CheckTranspositionTable(const RunConfig& config)
+    {
+        constexpr size_t NumKeys = 4096;
+        constexpr size_t TableEntries = 1024;
+        constexpr uint64_t OpsPerThread = uint64_t(1) << 22;
+
+        // Without contention a store is found with its latest value until evicted, keys never stored are not found,
+        // and hash zero is never stored
+        Snake::TranspositionTable singleTable(TableEntries);
+        bool valid = true;
+        uint64_t value;
+        for (uint64_t key = 1; key <= NumKeys; key++)
+        {
+            singleTable.Store(MixChecksum(key), MakeTableValue(key, 0));
+            singleTable.Store(MixChecksum(key), MakeTableValue(key, 1));
+            valid &= singleTable.Probe(MixChecksum(key), value) && value == MakeTableValue(key, 1);
+            valid &= !singleTable.Probe(MixChecksum(key + NumKeys), value);
+        }
+        singleTable.Store(0, 1);
+        valid &= !singleTable.Probe(0, value);
+        printf("single thread: %s\n", valid ? "stores found with their latest value, no false hits" : "MISSING, STALE OR FALSE HITS");
+
+        for (size_t numThreads = 1; ; numThreads = numThreads * 2 < config.mNumThreads ? numThreads * 2 : config.mNumThreads)
+        {
+            Vnm::WorkStealingPool pool(numThreads);
+            Snake::TranspositionTable table(TableEntries);
+            std::atomic<uint64_t> numHits(0);
+            std::atomic<uint64_t> numTorn(0);
+
+            std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            pool.ParallelFor(numThreads, [&](size_t, size_t task)
+            {
+                Snake::Random random(config.mBatch.mFirstSeed + task);
+                uint64_t hits = 0;
+                uint64_t torn = 0;
+                uint64_t probed;
+                for (uint64_t op = 0; op < OpsPerThread; op++)
+                {
+                    uint64_t key = random() % NumKeys + 1;
+                    uint64_t hash = MixChecksum(key);
+                    if (op & 1)
+                    {
+                        table.Store(hash, MakeTableValue(key, random()));
+                    }
+                    else if (table.Probe(hash, probed))
+                    {
+                        hits++;
+                        torn += (probed & 0xffffffff00000000ull) != (MakeTableValue(key, 0) & 0xffffffff00000000ull) ? 1 : 0;
+                    }
+                }
+                numHits += hits;
+                numTorn += torn;
+            });
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+            valid &= numTorn == 0;
+            double numOps = static_cast<double>(OpsPerThread * numThreads);
+            printf("%2llu threads: %7.1f Mops/s, %5.1f%% of probes hit, %llu torn\n",
+                static_cast<unsigned long long>(numThreads),
+                numOps / seconds * 1e-6,
+                100.0 * static_cast<double>(numHits.load()) / (numOps / 2),
+                static_cast<unsigned long long>(numTorn.load()));
+
+            if (numThreads >= config.mNumThreads)
+            {
+                break;
+            }
+        }
+        return valid;
+    }
+
+    // Compares everything a step can touch, down to the order of the board's lists and the random sequence
+    bool IsSameGame(const Snake::Simulation& a, const Snake::Simulation& b)
+    {
+        Snake::SimulationState stateA;
+        Snake::SimulationState stateB;
+        a.GetState(stateA);
+        b.GetState(stateB);
+        if (a.GetHash() != b.GetHash() || memcmp(&stateA, &stateB, sizeof(stateA)) != 0)
+        {
+            return false;
+        }
+
+        const Snake::GameBoard& boardA = a.GetBoard();
+        const Snake::GameBoard& boardB = b.GetBoard();
+        size_t numCells = boardA.GetNumCells();
+        if (boardA.EmptyCellCount() != boardB.EmptyCellCount() ||
+            memcmp(boardA.GetEmptyCells(), boardB.GetEmptyCells(), boardA.EmptyCellCount() * sizeof(uint32_t)) != 0 ||
+            memcmp(boardA.GetGamePieceTypes(), boardB.GetGamePieceTypes(), numCells * sizeof(Snake::GamePieceType)) != 0)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < numCells; i++)
+        {
+            if (boardA.GetCellSlot(i) != boardB.GetCellSlot(i))
+            {
+                return false;
+            }
+        }
+
+        size_t numOccupiedA;
+        size_t numOccupiedB;
+        const Snake::OccupiedCell* occupiedA = boardA.GetOccupiedCells(&numOccupiedA);
+        const Snake::OccupiedCell* occupiedB = boardB.GetOccupiedCells(&numOccupiedB);
+        if (numOccupiedA != numOccupiedB)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < numOccupiedA; i++)
+        {
+            if (occupiedA[i].mCellIndex != occupiedB[i].mCellIndex || occupiedA[i].mGamePieceType != occupiedB[i].mGamePieceType ||
+                occupiedA[i].mColor != occupiedB[i].mColor)
+            {
+                return false;
+            }
+        }
+
+        const Snake::SnakeBody& bodyA = a.GetBody();
+        const Snake::SnakeBody& bodyB = b.GetBody();
+        if (bodyA.GetLength() != bodyB.GetLength())
+        {
+            return false;
+        }
+        for (size_t i = 0; i < bodyA.GetLength(); i++)
+        {
+            if (bodyA.GetCell(i) != bodyB.GetCell(i))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // From positions along a game, applies random steps, checks they match plain steps, then undoes them all and checks
+    // the game is exactly as it was
+    bool CheckUndo(const RunConfig& config)
+    {
+        constexpr int NumPositions = 64;
+        constexpr uint64_t MaxStepsPerCheck = 4096;
+
+        Snake::Simulation simulation(config.mBatch.mFirstSeed);
+        std::unique_ptr<Snake::Policy> policy = Snake::CreatePolicy(config.mBatch.mPolicy);
+        policy->Reset(config.mBatch.mFirstSeed);
+        Snake::Random random(config.mBatch.mFirstSeed);
+
+        std::vector<Snake::StepUndo> undos(MaxStepsPerCheck);
+        std::vector<uint32_t> inputs(MaxStepsPerCheck);
+        uint64_t numChecked = 0;
+        uint64_t numFailed = 0;
+        uint64_t numSteps = 0;
+        double seconds = 0.0;
+        Snake::StepResult lastResult = Snake::StepResult::EnteredCell;
+        for (int position = 0; position < NumPositions; position++)
+        {
+            // Move the game on a little between checks, restarting it once it ends
+            for (uint64_t step = random() % 512; step > 0; step--)
+            {
+                if (simulation.IsOver())
+                {
+                    simulation.Reset();
+                    policy->Reset(random());
+                }
+                lastResult = simulation.Step(policy->ChooseInputs(simulation, lastResult));
+            }
+            if (simulation.IsOver())
+            {
+                continue;
+            }
+
+            Snake::Simulation before = simulation;
+            Snake::Simulation stepped = simulation;
+            uint64_t numApplied = 0;
+            uint64_t length = random() % MaxStepsPerCheck + 1;
+            std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            while (numApplied < length && !simulation.IsOver())
+            {
+                inputs[numApplied] = random() % 8 == 0 ? static_cast<uint32_t>(random() & 15) : 0;
+                simulation.ApplyStep(inputs[numApplied], undos[numApplied]);
+                numApplied++;
+            }
+            double applySeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+            for (uint64_t step = 0; step < numApplied; step++)
+            {
+                stepped.Step(inputs[step]);
+            }
+            bool matches = IsSameGame(simulation, stepped);
+
+            startTime = std::chrono::steady_clock::now();
+            for (uint64_t step = numApplied; step > 0; step--)
+            {
+                simulation.UndoStep(undos[step - 1]);
+            }
+            seconds += applySeconds + std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+            matches &= IsSameGame(simulation, before);
+            numFailed += matches ? 0 : 1;
+            numChecked++;
+            numSteps += numApplied;
+        }
+
+        printf("%llu positions, %llu steps applied and undone, %.1f ns per step and undo, %llu mismatches\n",
+            static_cast<unsigned long long>(numChecked),
+            static_cast<unsigned long long>(numSteps),
+            numSteps > 0 ? seconds * 1e9 / static_cast<double>(numSteps) : 0.0,
+            static_cast<unsigned long long>(numFailed));
+        return numFailed == 0;
+    }
+
+    // Counts changes, standing in for a consumer that updates itself as the board changes
+    class CountingObserver : public Snake::BoardObserver
+    {
+    public:
+        void OnBoardChange(const Snake::BoardChange&) override { mNumChanges++; }
+        void OnBoardResync() override                       { mNumResyncs++; }
+
+        uint64_t mNumChanges = 0;
+        uint64_t mNumResyncs = 0;
+    };
+
+    // Places and then removes numPieces pieces at random empty cells
+    BENCHMARK_KERNEL void ChurnPieces(Snake::GameBoard& board, Snake::Random& random, size_t numPieces, std::vector<size_t>& cells)
+    {
+        cells.clear();
+        for (size_t i = 0; i < numPieces; i++)
+        {
+            size_t cell = board.SampleEmptyCell(random);
+            int x;
+            int y;
+            int z;
+            board.GetCellCoords(cell, x, y, z);
+            board.PlaceGamePiece(x, y, z, Snake::PieceColor::SnakeBody, Snake::GamePieceType::SnakeBody);
+            cells.push_back(cell);
+        }
+        for (size_t cell : cells)
+        {
+            int x;
+            int y;
+            int z;
+            board.GetCellCoords(cell, x, y, z);
+            board.RemoveGamePiece(x, y, z);
+        }
+    }
+
+    // The journal's resync cases, the path planner's journal-fed grid against one rebuilt from the board, and the cost
+    // the journal and an observer add to every change
+    bool CheckJournal(const RunConfig& config)
+    {
+        constexpr size_t Capacity = Snake::BoardJournal::Capacity;
+        constexpr int NumGames = 64;
+        constexpr size_t NumTimedPieces = 1 << 14;
+        constexpr int NumTimedRounds = 64;
+
+        Snake::Random random(config.mBatch.mFirstSeed);
+        Snake::GameBoard board(Snake::BoardLayout(32, 32, 32));
+        std::vector<size_t> cells;
+        size_t numVisited = 0;
+        auto countVisits = [&](const Snake::BoardChange&) { numVisited++; };
+
+        // A reader exactly Capacity changes behind still drains; one change more and it must resync without visiting anything
+        uint64_t cursor = board.GetJournal().GetWritePosition();
+        ChurnPieces(board, random, Capacity / 2, cells);
+        bool fullRingDrains = board.GetJournal().Drain(cursor, countVisits) && numVisited == Capacity;
+        uint64_t lateCursor = board.GetJournal().GetWritePosition();
+        ChurnPieces(board, random, Capacity / 2, cells);
+        board.PlaceGamePiece(1, 1, 1, Snake::PieceColor::SnakeBody, Snake::GamePieceType::SnakeBody);
+        numVisited = 0;
+        bool overrunResyncs = !board.GetJournal().Drain(lateCursor, countVisits) && numVisited == 0 &&
+            lateCursor == board.GetJournal().GetWritePosition();
+
+        // Resets and copies replace the board wholesale, so even an up-to-date reader must resync across them
+        cursor = board.GetJournal().GetWritePosition();
+        board.Reset();
+        bool resetResyncs = !board.GetJournal().Drain(cursor, countVisits);
+        Snake::GameBoard copy(board.GetLayout());
+        cursor = copy.GetJournal().GetWritePosition();
+        copy = board;
+        bool copyResyncs = !copy.GetJournal().Drain(cursor, countVisits);
+
+        printf("journal: full ring %s, overrun %s, reset %s, copy %s\n",
+            fullRingDrains ? "drains" : "FAILS TO DRAIN", overrunResyncs ? "resyncs" : "DOES NOT RESYNC",
+            resetResyncs ? "resyncs" : "DOES NOT RESYNC", copyResyncs ? "resyncs" : "DOES NOT RESYNC");
+        bool valid = fullRingDrains && overrunResyncs && resetResyncs && copyResyncs;
+
+        // Random play, sometimes jumping back to an earlier copy of the game, with a plan at every cell
+        Snake::Simulation simulation(config.mBatch.mFirstSeed);
+        Snake::Simulation saved = simulation;
+        Snake::PathPlanner planner;
+        uint64_t numPlans = 0;
+        uint64_t numMismatches = 0;
+        for (int game = 0; game < NumGames; game++)
+        {
+            simulation.Reset(config.mBatch.mFirstSeed + game);
+            saved = simulation;
+            Snake::StepResult result = Snake::StepResult::EnteredCell;
+            while (!simulation.IsOver())
+            {
+                if (result == Snake::StepResult::EnteredCell)
+                {
+                    planner.Plan(simulation);
+                    numPlans++;
+
+                    Snake::BitGrid rebuilt(simulation.GetBoard().GetLayout());
+                    rebuilt.SetFromTypes(simulation.GetBoard(), Snake::GamePieceType::Empty);
+                    rebuilt.SetFromTypes(simulation.GetBoard(), Snake::GamePieceType::PowerUp);
+                    const Snake::BitGrid* passable = planner.GetPassable();
+                    bool matches = true;
+                    for (size_t cell = 0; cell < simulation.GetBoard().GetNumCells() && matches; cell++)
+                    {
+                        matches = passable->Test(cell) == rebuilt.Test(cell);
+                    }
+                    numMismatches += matches ? 0 : 1;
+
+                    uint64_t choice = random() % 64;
+                    if (choice == 0)
+                    {
+                        saved = simulation;
+                    }
+                    else if (choice == 1)
+                    {
+                        simulation = saved;
+                    }
+                }
+                result = simulation.Step(random() % 4 == 0 ? static_cast<uint32_t>(random() & 15) : 0);
+            }
+        }
+        printf("planner: %llu plans, %llu with a passable grid different from a rebuild\n",
+            static_cast<unsigned long long>(numPlans), static_cast<unsigned long long>(numMismatches));
+        valid &= numMismatches == 0;
+
+        // Every change is recorded either way; an observer adds a virtual call per change
+        CountingObserver observer;
+        double seconds[2];
+        for (int subscribed = 0; subscribed < 2; subscribed++)
+        {
+            if (subscribed)
+            {
+                board.GetJournal().Subscribe(&observer);
+            }
+            std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            for (int round = 0; round < NumTimedRounds; round++)
+            {
+                ChurnPieces(board, random, NumTimedPieces, cells);
+            }
+            seconds[subscribed] = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        }
+        board.GetJournal().Unsubscribe(&observer);
+
+        double numChanges = 2.0 * NumTimedPieces * NumTimedRounds;
+        valid &= observer.mNumChanges == static_cast<uint64_t>(numChanges);
+        printf("place and remove: %.1f ns/change journaled, %.1f ns/change with an observer subscribed\n",
+            seconds[0] * 1e9 / numChanges, seconds[1] * 1e9 / numChanges);
+        return valid;
+    }
+
+    // Resets a new C interface environment set and checks every environment's observation against one encoded from a
+    // game with the same seed, and that neither reset nor a step writes past the observations
+    bool CheckObservationConfig(uint32_t numEnvs, uint64_t seed, uint32_t type, uint32_t format, int radius)
+    {
+        constexpr size_t GuardBytes = 64;
+        constexpr uint8_t GuardValue = 0xcd;
+
+        const Snake::BoardLayout& layout = Snake::DefaultGameBoard::Layout;
+        Snake::ObservationFormat observationFormat = static_cast<Snake::ObservationFormat>(format);
+        size_t expectedSize = type == SNAKE3D_OBSERVATION_GRID ? Snake::GetGridObservationSize(layout, observationFormat) :
+            type == SNAKE3D_OBSERVATION_EGOCENTRIC ? Snake::GetEgocentricObservationSize(radius, observationFormat) :
+            layout.GetNumCells();
+        Snake3D_VecEnv* vecEnv = Snake3D_CreateVecEnv(numEnvs, seed, 1, 0);
+        if (Snake3D_SetObservation(vecEnv, type, format, radius) == 0 || Snake3D_GetObservationSize(vecEnv) != expectedSize)
+        {
+            Snake3D_DestroyVecEnv(vecEnv);
+            return false;
+        }
+
+        std::vector<uint8_t> observations(numEnvs * expectedSize + GuardBytes, GuardValue);
+        Snake3D_ResetVecEnv(vecEnv, observations.data());
+
+        bool matches = true;
+        std::vector<uint8_t> expected(expectedSize);
+        for (size_t env = 0; env < numEnvs; env++)
+        {
+            Snake::Simulation simulation(seed + env);
+            simulation.Reset();
+            if (type == SNAKE3D_OBSERVATION_GRID)
+            {
+                Snake::EncodeGridObservation(simulation, observationFormat, expected.data());
+            }
+            else if (type == SNAKE3D_OBSERVATION_EGOCENTRIC)
+            {
+                Snake::EncodeEgocentricObservation(simulation, radius, observationFormat, expected.data());
+            }
+            else
+            {
+                memcpy(expected.data(), simulation.GetBoard().GetGamePieceTypes(), expectedSize);
+            }
+            matches &= memcmp(observations.data() + env * expectedSize, expected.data(), expectedSize) == 0;
+        }
+
+        std::vector<uint8_t> actions(numEnvs, 0);
+        std::vector<float> rewards(numEnvs);
+        std::vector<uint8_t> dones(numEnvs);
+        Snake3D_StepVecEnv(vecEnv, actions.data(), rewards.data(), dones.data(), observations.data());
+        for (size_t i = numEnvs * expectedSize; i < observations.size(); i++)
+        {
+            matches &= observations[i] == GuardValue;
+        }
+        Snake3D_DestroyVecEnv(vecEnv);
+        return matches;
+    }
+
+    // Drives the C interface trainers load: observation sizes and contents for every type and format, rejected
+    // arguments, then environments stepped with random actions on 1, 2, 4 ... pool threads against games stepped
+    // alongside them, which give the rewards, done flags and reset observations every step should report
+    bool CheckVecEnv(const RunConfig& config)
+    {
+        constexpr uint32_t NumEnvs = 256;
+        constexpr uint32_t NumConfigEnvs = 16;
+        constexpr uint64_t NumSteps = 2048;
+        constexpr uint64_t MaxEpisodeActions = 128;
+
+        const uint64_t seed = config.mBatch.mFirstSeed;
+        const Snake::BoardLayout& layout = Snake::DefaultGameBoard::Layout;
+        const int maxRadius = Snake::GetMaxEgocentricRadius(layout);
+
+        uint64_t numConfigs = 0;
+        uint64_t numBadConfigs = 0;
+        for (uint32_t type = SNAKE3D_OBSERVATION_CELL_TYPES; type <= SNAKE3D_OBSERVATION_EGOCENTRIC; type++)
+        {
+            for (uint32_t format = SNAKE3D_FORMAT_UINT8; format <= SNAKE3D_FORMAT_FLOAT16; format++)
+            {
+                const int radii[] = { 0, 4, maxRadius };
+                for (int radius : radii)
+                {
+                    numBadConfigs += CheckObservationConfig(NumConfigEnvs, seed, type, format, radius) ? 0 : 1;
+                    numConfigs++;
+                }
+            }
+        }
+
+        // Rejected arguments leave the observation as it was
+        Snake3D_VecEnv* vecEnv = Snake3D_CreateVecEnv(NumEnvs, seed, 1, MaxEpisodeActions);
+        if (vecEnv == nullptr || Snake3D_GetNumEnvs(vecEnv) != NumEnvs || Snake3D_CreateVecEnv(0, seed, 1, 0) != nullptr)
+        {
+            printf("vecenv: creation failed\n");
+            Snake3D_DestroyVecEnv(vecEnv);
+            return false;
+        }
+        size_t size = Snake3D_GetObservationSize(vecEnv);
+        uint64_t numBadRejections = 0;
+        numBadRejections += Snake3D_SetObservation(vecEnv, SNAKE3D_OBSERVATION_EGOCENTRIC, SNAKE3D_FORMAT_UINT8, maxRadius + 1) != 0;
+        numBadRejections += Snake3D_SetObservation(vecEnv, SNAKE3D_OBSERVATION_EGOCENTRIC, SNAKE3D_FORMAT_UINT8, -1) != 0;
+        numBadRejections += Snake3D_SetObservation(vecEnv, SNAKE3D_OBSERVATION_EGOCENTRIC + 1, SNAKE3D_FORMAT_UINT8, 4) != 0;
+        numBadRejections += Snake3D_SetObservation(vecEnv, SNAKE3D_OBSERVATION_GRID, SNAKE3D_FORMAT_FLOAT16 + 1, 4) != 0;
+        numBadRejections += Snake3D_GetObservationSize(vecEnv) != size;
+        Snake3D_DestroyVecEnv(vecEnv);
+
+        printf("observations: %llu type, format and radius combinations (max radius %d), %llu mismatches, %llu wrongly accepted arguments\n",
+            static_cast<unsigned long long>(numConfigs),
+            maxRadius,
+            static_cast<unsigned long long>(numBadConfigs),
+            static_cast<unsigned long long>(numBadRejections));
+        bool passed = numBadConfigs == 0 && numBadRejections == 0;
+
+        size_t cellsSize = layout.GetNumCells();
+        std::vector<uint8_t> actions(NumEnvs);
+        std::vector<float> rewards(NumEnvs);
+        std::vector<uint8_t> dones(NumEnvs);
+        std::vector<uint8_t> observations(NumEnvs * cellsSize);
+        uint64_t firstChecksum = 0;
+        for (size_t numThreads = 1; ; numThreads = numThreads * 2 < config.mNumThreads ? numThreads * 2 : config.mNumThreads)
+        {
+            vecEnv = Snake3D_CreateVecEnv(NumEnvs, seed, static_cast<uint32_t>(numThreads), MaxEpisodeActions);
+            Snake3D_ResetVecEnv(vecEnv, observations.data());
+
+            std::vector<Snake::Simulation> games;
+            std::vector<std::unique_ptr<Snake::Policy>> policies;
+            games.reserve(NumEnvs);
+            for (uint32_t env = 0; env < NumEnvs; env++)
+            {
+                games.emplace_back(seed + env);
+                games.back().Reset();
+                policies.push_back(Snake::CreatePolicy(config.mBatch.mPolicy));
+                policies.back()->Reset(seed + env);
+            }
+            std::vector<uint64_t> episodeActions(NumEnvs, 0);
+            std::vector<Snake::StepResult> lastResults(NumEnvs, Snake::StepResult::EnteredCell);
+
+            // The policy's choices with random ones mixed in so games both eat and die, the same for every thread count
+            Snake::Random random(seed);
+            uint64_t numPowerUps = 0;
+            uint64_t numDeaths = 0;
+            uint64_t numResets = 0;
+            uint64_t numMismatches = 0;
+            uint64_t checksum = 0;
+            double totalReward = 0.0;
+            double seconds = 0.0;
+            for (uint64_t step = 0; step < NumSteps; step++)
+            {
+                for (uint32_t env = 0; env < NumEnvs; env++)
+                {
+                    actions[env] = static_cast<uint8_t>(random() % 8 == 0 ? random() & 15 : policies[env]->ChooseInputs(games[env], lastResults[env]));
+                }
+
+                std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+                Snake3D_StepVecEnv(vecEnv, actions.data(), rewards.data(), dones.data(), observations.data());
+                seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+                for (uint32_t env = 0; env < NumEnvs; env++)
+                {
+                    Snake::Simulation& game = games[env];
+                    Snake::StepResult result = game.Step(actions[env]);
+                    while (result == Snake::StepResult::Moved)
+                    {
+                        result = game.Step(0);
+                    }
+                    lastResults[env] = result;
+                    bool atePowerUp = result == Snake::StepResult::AtePowerUp || result == Snake::StepResult::Won;
+                    bool died = result == Snake::StepResult::Died;
+                    numPowerUps += atePowerUp ? 1 : 0;
+                    numDeaths += died ? 1 : 0;
+
+                    // A finished game's observation is already the first one of the next game
+                    bool done = game.IsOver() || ++episodeActions[env] >= MaxEpisodeActions;
+                    if (done)
+                    {
+                        game.Reset();
+                        policies[env]->Reset(random());
+                        lastResults[env] = Snake::StepResult::EnteredCell;
+                        episodeActions[env] = 0;
+                        numResets++;
+                    }
+
+                    float expectedReward = (atePowerUp ? 1.0f : 0.0f) - (died ? 1.0f : 0.0f);
+                    bool matches = rewards[env] == expectedReward && dones[env] == (done ? 1 : 0) &&
+                        memcmp(observations.data() + env * cellsSize, game.GetBoard().GetGamePieceTypes(), cellsSize) == 0;
+                    numMismatches += matches ? 0 : 1;
+                    totalReward += rewards[env];
+                    checksum = MixChecksum(checksum ^ (static_cast<uint64_t>(rewards[env] + 2.0f) << 8) ^ dones[env] ^
+                        (MixChecksum(observations[env * cellsSize + (step % cellsSize)]) << 16));
+                }
+            }
+            Snake3D_DestroyVecEnv(vecEnv);
+
+            firstChecksum = numThreads == 1 ? checksum : firstChecksum;
+            bool rewardsAddUp = totalReward == static_cast<double>(numPowerUps) - static_cast<double>(numDeaths);
+            passed &= numMismatches == 0 && rewardsAddUp && checksum == firstChecksum && numResets > 0;
+
+            printf("threads %llu: %.0f env-steps/s, %llu power-ups, %llu deaths, total reward %.0f, %llu resets, %llu mismatches, checksum %016llx%s\n",
+                static_cast<unsigned long long>(numThreads),
+                seconds > 0.0 ? static_cast<double>(NumEnvs * NumSteps) / seconds : 0.0,
+                static_cast<unsigned long long>(numPowerUps),
+                static_cast<unsigned long long>(numDeaths),
+                totalReward,
+                static_cast<unsigned long long>(numResets),
+                static_cast<unsigned long long>(numMismatches),
+                static_cast<unsigned long long>(checksum),
+                checksum == firstChecksum ? "" : " MISMATCH");
+
+            if (numThreads >= config.mNumThreads)
+            {
+                break;
+            }
+        }
+        return passed;
+    }
+
+    void PrintUsage()
+    {
+        printf("Usage: snake3d_headless [--games N] [--policy greedy|random|path] [--seed S] [--max-steps N] [--threads N] [--scaling] [--planner]\n"
+            "       snake3d_headless --mcts [--seed S] [--threads N] [--rollouts N] [--move-ms N]\n"
+            "       snake3d_headless --record FILE [--policy greedy|random|path] [--seed S] [--max-steps N] [--keyframe-interval N]\n"
+            "       snake3d_headless --verify FILE [--seek TICK]\n"
+            "       snake3d_headless --snapshot FILE [--policy greedy|random|path] [--seed S] [--max-steps N]\n"
+            "       snake3d_headless --handoff [--policy greedy|random|path] [--seed S]\n"
+            "       snake3d_headless --render [--policy greedy|random|path] [--seed S] [--max-steps N]\n"
+            "       snake3d_headless --raster [--threads N] [--screenshot FILE]\n"
+            "       snake3d_headless --placement [--seed S]\n"
+            "       snake3d_headless --body-sweep\n"
+            "       snake3d_headless --board-sizes [--policy greedy|random|path] [--seed S] [--max-steps N]\n"
+            "       snake3d_headless --scan [--seed S]\n"
+            "       snake3d_headless --pool-churn [--threads N] [--seed S]\n"
+            "       snake3d_headless --sparse [--seed S]\n"
+            "       snake3d_headless --reset [--seed S]\n"
+            "       snake3d_headless --encode [--policy greedy|random|path] [--seed S] [--max-steps N]\n"
+            "       snake3d_headless --table-check [--threads N] [--seed S]\n"
+            "       snake3d_headless --undo-check [--policy greedy|random|path] [--seed S]\n"
+            "       snake3d_headless --journal-check [--seed S]\n"
+            "       snake3d_headless --vecenv [--threads N] [--seed S]\n");
+    }
+
+    bool ParseArgs(int argc, char** argv, RunConfig& config)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const char* arg = argv[i];
+            if (strcmp(arg, "--scaling") == 0)
+            {
+                config.mMeasureScaling = true;
+                continue;
+            }
+            if (strcmp(arg, "--planner") == 0)
+            {
+                config.mMeasurePlanner = true;
+                continue;
+            }
+            if (strcmp(arg, "--mcts") == 0)
+            {
+                config.mMeasureMcts = true;
+                continue;
+            }
+            if (strcmp(arg, "--handoff") == 0)
+            {
+                config.mMeasureHandoff = true;
+                continue;
+            }
+            if (strcmp(arg, "--render") == 0)
+            {
+                config.mMeasureRendering = true;
+                continue;
+            }
+            if (strcmp(arg, "--raster") == 0)
+            {
+                config.mMeasureRasterizer = true;
+                continue;
+            }
+
+            if (strcmp(arg, "--placement") == 0)
+            {
+                config.mMeasurePlacement = true;
+                continue;
+            }
+            if (strcmp(arg, "--body-sweep") == 0)
+            {
+                config.mMeasureBodySweep = true;
+                continue;
+            }
+            if (strcmp(arg, "--board-sizes") == 0)
+            {
+                config.mMeasureBoardSizes = true;
+                continue;
+            }
+            if (strcmp(arg, "--scan") == 0)
+            {
+                config.mMeasureBoardScan = true;
+                continue;
+            }
+            if (strcmp(arg, "--pool-churn") == 0)
+            {
+                config.mMeasurePoolChurn = true;
+                continue;
+            }
+            if (strcmp(arg, "--sparse") == 0)
+            {
+                config.mMeasureSparseBoard = true;
+                continue;
+            }
+            if (strcmp(arg, "--reset") == 0)
+            {
+                config.mMeasureReset = true;
+                continue;
+            }
+            if (strcmp(arg, "--encode") == 0)
+            {
+                config.mMeasureEncoding = true;
+                continue;
+            }
+            if (strcmp(arg, "--table-check") == 0)
+            {
+                config.mCheckTable = true;
+                continue;
+            }
+            if (strcmp(arg, "--undo-check") == 0)
+            {
+                config.mCheckUndo = true;
+                continue;
+            }
+            if (strcmp(arg, "--journal-check") == 0)
+            {
+                config.mCheckJournal = true;
+                continue;
+            }
+            if (strcmp(arg, "--vecenv") == 0)
+            {
+                config.mCheckVecEnv = true;
+                continue;
+            }
+            const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+            if (value == nullptr)
+            {
+                return false;
+            }
+
+            if (strcmp(arg, "--games") == 0)
+            {
+                config.mBatch.mNumGames = strtoull(value, nullptr, 10);
+            }
+            else if (strcmp(arg, "--seed") == 0)
+            {
+                config.mBatch.mFirstSeed = strtoull(value, nullptr, 10);
+            }
+            else if (strcmp(arg, "--max-steps") == 0)
+            {
+                config.mBatch.mMaxStepsPerGame = strtoull(value, nullptr, 10);
+            }
+            else if (strcmp(arg, "--threads") == 0)
+            {
+                config.mNumThreads = static_cast<size_t>(strtoull(value, nullptr, 10));
+            }
+            else if (strcmp(arg, "--rollouts") == 0)
+            {
+                config.mMcts.mRolloutsPerMove = strtoull(value, nullptr, 10);
+            }
+            else if (strcmp(arg, "--move-ms") == 0)
+            {
+                config.mMcts.mTimeBudgetSeconds = strtod(value, nullptr) / 1000.0;
+            }
+            else if (strcmp(arg, "--record") == 0)
+            {
+                config.mRecordPath = value;
+            }
+            else if (strcmp(arg, "--verify") == 0)
+            {
+                config.mVerifyPath = value;
+            }
+            else if (strcmp(arg, "--snapshot") == 0)
+            {
+                config.mSnapshotPath = value;
+            }
+            else if (strcmp(arg, "--screenshot") == 0)
+            {
+                config.mScreenshotPath = value;
+            }
+            else if (strcmp(arg, "--seek") == 0)
+            {
+                config.mSeekTick = strtoull(value, nullptr, 10);
+                config.mSeek = true;
+            }
+            else if (strcmp(arg, "--keyframe-interval") == 0)
+            {
+                config.mKeyframeInterval = static_cast<uint32_t>(strtoull(value, nullptr, 10));
+            }
+            else if (strcmp(arg, "--policy") == 0)
+            {
+                if (!Snake::FindPolicy(value, config.mBatch.mPolicy))
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                return false;
+            }
+
+            i++;
+        }
+
+        config.mNumThreads = config.mNumThreads > 0 ? config.mNumThreads : 1;
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    RunConfig config;
+    if (!ParseArgs(argc, argv, config))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    if (config.mRecordPath != nullptr)
+    {
+        return RecordGame(config) ? 0 : 1;
+    }
+
+    if (config.mSnapshotPath != nullptr)
+    {
+        return MeasureSnapshot(config) ? 0 : 1;
+    }
+
+    if (config.mVerifyPath != nullptr)
+    {
+        return VerifyGame(config) ? 0 : 1;
+    }
+
+    if (config.mMeasureHandoff)
+    {
+        return MeasureHandoff(config) ? 0 : 1;
+    }
+
+    if (config.mMeasureRendering)
+    {
+        MeasureRendering(config);
+        return 0;
+    }
+
+    if (config.mMeasureRasterizer)
+    {
+        MeasureRasterizer(config);
+        return 0;
+    }
+
+    if (config.mMeasurePlacement)
+    {
+        MeasurePlacement(config);
+        return 0;
+    }
+
+    if (config.mMeasureBodySweep)
+    {
+        return MeasureBodySweep(config) ? 0 : 1;
+    }
+
+    if (config.mMeasureBoardSizes)
+    {
+        return MeasureBoardSizes(config) ? 0 : 1;
+    }
+
+    if (config.mMeasureBoardScan)
+    {
+        return MeasureBoardScan(config) ? 0 : 1;
+    }
+
+    if (config.mMeasurePoolChurn)
+    {
+        return MeasurePoolChurn(config) ? 0 : 1;
+    }
+
+    if (config.mMeasureSparseBoard)
+    {
+        return MeasureSparseBoard(config) ? 0 : 1;
+    }
+
+    if (config.mMeasureReset)
+    {
+        return MeasureReset(config) ? 0 : 1;
+    }
+
+    if (config.mMeasureEncoding)
+    {
+        MeasureEncoding(config);
+        return 0;
+    }
+
+    if (config.mCheckTable)
+    {
+        return CheckTranspositionTable(config) ? 0 : 1;
+    }
+
+    if (config.mCheckUndo)
+    {
+        return CheckUndo(config) ? 0 : 1;
+    }
+
+    if (config.mCheckJournal)
+    {
+        return CheckJournal(config) ? 0 : 1;
+    }
+
+    if (config.mCheckVecEnv)
+    {
+        return CheckVecEnv(config) ? 0 : 1;
+    }
+
+    if (config.mMeasureMcts)
+    {
+        config.mMcts.mSeed = config.mBatch.mFirstSeed;
+        MeasureMcts(config);
+        return 0;
+    }
+
+    if (config.mMeasurePlanner)
+    {
+        MeasurePlanner(config);
+        return 0;
+    }
+
+    if (config.mMeasureScaling)
+    {
+        MeasureScaling(config);
+        return 0;
+    }
+
+    Vnm::WorkStealingPool pool(config.mNumThreads);
+    Snake::BatchResult result = Snake::RunBatch(pool, config.mBatch);
+    PrintSummary(config, result);
+
+    return 0;
+}
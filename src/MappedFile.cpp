@@ -0,0 +1,111 @@
+// MappedFile.cpp
+
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Vnm
+{
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+#if defined(_WIN32)
+
+    bool MappedFile::Open(const char* path)
+    {
+        Close();
+
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+        {
+            // The mapping keeps the file open, so the file handle can go straight away
+            mMapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mMapping != nullptr)
+            {
+                mData = static_cast<const uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+                mSize = static_cast<size_t>(size.QuadPart);
+            }
+        }
+        CloseHandle(file);
+
+        if (mData == nullptr)
+        {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (mData != nullptr)
+        {
+            UnmapViewOfFile(mData);
+        }
+        if (mMapping != nullptr)
+        {
+            CloseHandle(mMapping);
+        }
+
+        mData = nullptr;
+        mSize = 0;
+        mMapping = nullptr;
+    }
+
+#else
+
+    bool MappedFile::Open(const char* path)
+    {
+        Close();
+
+        int file = open(path, O_RDONLY);
+        if (file < 0)
+        {
+            return false;
+        }
+
+        // The mapping keeps the file open, so the descriptor can go straight away
+        struct stat status;
+        if (fstat(file, &status) == 0 && status.st_size > 0)
+        {
+            void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+            if (data != MAP_FAILED)
+            {
+                mData = static_cast<const uint8_t*>(data);
+                mSize = static_cast<size_t>(status.st_size);
+            }
+        }
+        close(file);
+
+        return mData != nullptr;
+    }
+
+    void MappedFile::Close()
+    {
+        if (mData != nullptr)
+        {
+            munmap(const_cast<uint8_t*>(mData), mSize);
+        }
+
+        mData = nullptr;
+        mSize = 0;
+    }
+
+#endif
+
+} // namespace Vnm
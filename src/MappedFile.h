@@ -0,0 +1,36 @@
+// MappedFile.h
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Vnm
+{
+    // Read-only memory mapping of a whole file; pages load on first touch, so opening is cheap however large the file
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        // Unmaps any previous file; fails on files that cannot be opened and on empty ones
+        bool Open(const char* path);
+        void Close();
+
+        bool IsOpen() const             { return mData != nullptr; }
+        const uint8_t* GetData() const  { return mData; }
+        size_t GetSize() const          { return mSize; }
+
+    private:
+        const uint8_t* mData = nullptr;
+        size_t         mSize = 0;
+#if defined(_WIN32)
+        void*          mMapping = nullptr;
+#endif
+    };
+
+} // namespace Vnm
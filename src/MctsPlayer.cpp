@@ -0,0 +1,417 @@
+// MctsPlayer.cpp
+
+#include "MctsPlayer.h"
+#include "Policy.h"
+#include "Random.h"
+#include "TranspositionTable.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+
+namespace Snake
+{
+    class MctsPlayer::Node
+    {
+    public:
+        static constexpr uint8_t Unexpanded = 0;
+        static constexpr uint8_t Expanding = 1;
+        static constexpr uint8_t Expanded = 2;
+
+        void Clear()
+        {
+            mVisits.store(0, std::memory_order_relaxed);
+            mValueSum.store(0, std::memory_order_relaxed);
+            mVirtualLoss.store(0, std::memory_order_relaxed);
+            mState.store(Unexpanded, std::memory_order_relaxed);
+            mHash.store(0, std::memory_order_relaxed);
+            mNumChildren = 0;
+            mInputs = 0;
+            mFirstChild = 0;
+        }
+
+        std::atomic<uint64_t> mVisits;
+        std::atomic<int64_t>  mValueSum;
+        std::atomic<uint32_t> mVirtualLoss;     // Selections in flight through this node
+        std::atomic<uint8_t>  mState;
+        std::atomic<uint64_t> mHash;            // Position hash, set by the first thread to reach the node; zero until then
+        uint8_t               mNumChildren;     // Written by the expanding thread before it publishes Expanded
+        uint32_t              mInputs;          // Move from the parent
+        uint32_t              mFirstChild;      // Children are reserved during serial selection; zero if none
+    };
+
+    // Scratch state of one pool thread, padded so threads never share a cache line
+    class alignas(64) MctsPlayer::Worker
+    {
+    public:
+        Simulation& Load(const Simulation& root)
+        {
+            if (mSimulation == nullptr)
+            {
+                mSimulation = std::make_unique<Simulation>(root);
+            }
+            else
+            {
+                *mSimulation = root;
+            }
+            return *mSimulation;
+        }
+
+        std::unique_ptr<Simulation> mSimulation;
+    };
+
+    namespace
+    {
+        uint64_t MixSeed(uint64_t value)
+        {
+            value += 0x9e3779b97f4a7c15ull;
+            value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+            value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+            return value ^ (value >> 31);
+        }
+
+        // Transposition table values hold a visit count in the low half and a value sum in the high half. Sums are kept
+        // relative to an empty snake rather than the root, so they carry over to later roots, and are halved along with
+        // the count until they fit.
+        constexpr uint64_t MaxStoredVisits = 1 << 16;
+
+        uint64_t PackStatistics(uint64_t visits, int64_t valueSum, size_t rootLength)
+        {
+            int64_t absoluteSum = valueSum + static_cast<int64_t>(visits * rootLength);
+            while (visits > MaxStoredVisits || absoluteSum > INT32_MAX || absoluteSum < INT32_MIN)
+            {
+                visits /= 2;
+                absoluteSum /= 2;
+            }
+            return (static_cast<uint64_t>(static_cast<uint32_t>(static_cast<int32_t>(absoluteSum))) << 32) | visits;
+        }
+
+        void UnpackStatistics(uint64_t packed, size_t rootLength, uint64_t& visitsOut, int64_t& valueSumOut)
+        {
+            visitsOut = packed & 0xffffffffu;
+            valueSumOut = static_cast<int32_t>(static_cast<uint32_t>(packed >> 32)) - static_cast<int64_t>(visitsOut * rootLength);
+        }
+
+        // Moves that do not run straight into a wall or the body
+        int GetSafeMoves(const Simulation& simulation, Move movesOut[NumMoves])
+        {
+            const GameBoard& board = simulation.GetBoard();
+            const int* head = simulation.GetHeadCell();
+
+            Move moves[NumMoves];
+            GetMoves(simulation, moves);
+
+            int numSafe = 0;
+            for (const Move& move : moves)
+            {
+                int next[3] = { head[0] + move.mDirection[0], head[1] + move.mDirection[1], head[2] + move.mDirection[2] };
+                if (!board.IsWall(next[0], next[1], next[2]) &&
+                    board.GetGamePieceType(next[0], next[1], next[2]) != GamePieceType::SnakeBody)
+                {
+                    movesOut[numSafe++] = move;
+                }
+            }
+            return numSafe;
+        }
+
+        // Steps until the head reaches the next cell or the game ends
+        void AdvanceCell(Simulation& simulation, uint32_t inputs)
+        {
+            StepResult result = simulation.Step(inputs);
+            while (result == StepResult::Moved)
+            {
+                result = simulation.Step(0);
+            }
+        }
+
+        // Mostly heads for the power-up, sometimes wanders, so rollouts score positions better than pure chance
+        uint32_t ChooseRolloutMove(const Simulation& simulation, Random& random)
+        {
+            Move moves[NumMoves];
+            int numSafe = GetSafeMoves(simulation, moves);
+            if (numSafe == 0)
+            {
+                return 0;
+            }
+            if (random() % 4 == 0)
+            {
+                return moves[random() % numSafe].mInputs;
+            }
+
+            int target[3];
+            simulation.GetBoard().GetCellCoords(simulation.GetPowerUpCell(), target[0], target[1], target[2]);
+            const int* head = simulation.GetHeadCell();
+
+            int best = 0;
+            int bestDistance = INT32_MAX;
+            for (int i = 0; i < numSafe; i++)
+            {
+                int distance = 0;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    distance += std::abs(target[axis] - head[axis] - moves[i].mDirection[axis]);
+                }
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = i;
+                }
+            }
+            return moves[best].mInputs;
+        }
+    }
+
+    MctsPlayer::MctsPlayer(Vnm::WorkStealingPool& pool, const MctsConfig& config, TranspositionTable* table)
+        : mPool(pool)
+        , mConfig(config)
+        , mTable(table)
+        , mNodes(new Node[config.mMaxNodes])
+        , mWorkers(new Worker[pool.GetNumThreads()])
+        , mPaths(pool.GetNumThreads())
+        , mNumTableHits(0)
+    {
+    }
+
+    MctsPlayer::~MctsPlayer() = default;
+
+    size_t MctsPlayer::AllocateChildren()
+    {
+        if (mNumNodes + NumMoves > mConfig.mMaxNodes)
+        {
+            return 0;
+        }
+
+        size_t first = mNumNodes;
+        for (size_t i = first; i < first + NumMoves; i++)
+        {
+            mNodes[i].Clear();
+        }
+        mNumNodes += NumMoves;
+        return first;
+    }
+
+    void MctsPlayer::SelectLeaf(std::vector<uint32_t>& pathOut)
+    {
+        pathOut.clear();
+
+        uint32_t index = 0;
+        for (;;)
+        {
+            Node& node = mNodes[index];
+            pathOut.push_back(index);
+            node.mVirtualLoss.fetch_add(1, std::memory_order_relaxed);
+
+            if (node.mState.load(std::memory_order_acquire) != Node::Expanded || node.mNumChildren == 0)
+            {
+                break;
+            }
+
+            // UCT, with every selection in flight counted as a visit that died
+            double parentVisits = static_cast<double>(node.mVisits.load(std::memory_order_relaxed) + node.mVirtualLoss.load(std::memory_order_relaxed));
+            double logParentVisits = std::log(std::max(parentVisits, 1.0));
+
+            uint32_t best = node.mFirstChild;
+            double bestScore = -std::numeric_limits<double>::infinity();
+            for (uint32_t child = node.mFirstChild; child < node.mFirstChild + node.mNumChildren; child++)
+            {
+                const Node& childNode = mNodes[child];
+                uint64_t virtualLoss = childNode.mVirtualLoss.load(std::memory_order_relaxed);
+                uint64_t visits = childNode.mVisits.load(std::memory_order_relaxed) + virtualLoss;
+                if (visits == 0)
+                {
+                    best = child;
+                    break;
+                }
+
+                double value = static_cast<double>(childNode.mValueSum.load(std::memory_order_relaxed) -
+                    static_cast<int64_t>(virtualLoss) * mConfig.mDeathPenalty);
+                double score = value / static_cast<double>(visits) +
+                    mConfig.mExploration * std::sqrt(logParentVisits / static_cast<double>(visits));
+                if (score > bestScore)
+                {
+                    bestScore = score;
+                    best = child;
+                }
+            }
+
+            index = best;
+        }
+
+        Node& leaf = mNodes[index];
+        if (leaf.mState.load(std::memory_order_relaxed) == Node::Unexpanded && leaf.mFirstChild == 0)
+        {
+            leaf.mFirstChild = static_cast<uint32_t>(AllocateChildren());
+        }
+    }
+
+    // Records the position of a node the first time any thread reaches it and starts the node from its stored statistics
+    void MctsPlayer::ReachNode(Node& node, const Simulation& simulation, size_t rootLength)
+    {
+        if (mTable == nullptr || node.mHash.load(std::memory_order_relaxed) != 0)
+        {
+            return;
+        }
+
+        uint64_t hash = simulation.GetHash();
+        uint64_t expected = 0;
+        if (hash == 0 || !node.mHash.compare_exchange_strong(expected, hash, std::memory_order_relaxed))
+        {
+            return;
+        }
+
+        uint64_t packed;
+        if (mTable->Probe(hash, packed))
+        {
+            uint64_t visits;
+            int64_t valueSum;
+            UnpackStatistics(packed, rootLength, visits, valueSum);
+            node.mVisits.fetch_add(visits, std::memory_order_relaxed);
+            node.mValueSum.fetch_add(valueSum, std::memory_order_relaxed);
+            mNumTableHits.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void MctsPlayer::StoreNodes(size_t rootLength)
+    {
+        for (size_t i = 0; i < mNumNodes; i++)
+        {
+            const Node& node = mNodes[i];
+            uint64_t hash = node.mHash.load(std::memory_order_relaxed);
+            uint64_t visits = node.mVisits.load(std::memory_order_relaxed);
+            if (hash != 0 && visits > 0)
+            {
+                mTable->Store(hash, PackStatistics(visits, node.mValueSum.load(std::memory_order_relaxed), rootLength));
+            }
+        }
+    }
+
+    void MctsPlayer::RunIteration(const Simulation& root, uint64_t iteration, std::vector<uint32_t>& path, Worker& worker)
+    {
+        Simulation& simulation = worker.Load(root);
+        Random random(MixSeed(mConfig.mSeed ^ MixSeed(root.GetStepCount() ^ MixSeed(iteration))));
+
+        for (size_t i = 1; i < path.size(); i++)
+        {
+            AdvanceCell(simulation, mNodes[path[i]].mInputs);
+            ReachNode(mNodes[path[i]], simulation, root.GetBodyLength());
+        }
+        size_t numVirtualLosses = path.size();
+
+        Node& leaf = mNodes[path.back()];
+        Move moves[NumMoves];
+        int numSafe = simulation.IsOver() ? 0 : GetSafeMoves(simulation, moves);
+
+        // Threads that picked the same leaf see the same position, so the one that wins the swap publishes the
+        // children and the others use their own identical move list without waiting
+        if (leaf.mFirstChild != 0)
+        {
+            uint8_t expected = Node::Unexpanded;
+            if (leaf.mState.compare_exchange_strong(expected, Node::Expanding, std::memory_order_acq_rel))
+            {
+                for (int i = 0; i < numSafe; i++)
+                {
+                    mNodes[leaf.mFirstChild + i].mInputs = moves[i].mInputs;
+                }
+                leaf.mNumChildren = static_cast<uint8_t>(numSafe);
+                leaf.mState.store(Node::Expanded, std::memory_order_release);
+            }
+
+            if (numSafe > 0)
+            {
+                int choice = static_cast<int>(random() % numSafe);
+                path.push_back(leaf.mFirstChild + choice);
+                AdvanceCell(simulation, moves[choice].mInputs);
+                ReachNode(mNodes[path.back()], simulation, root.GetBodyLength());
+            }
+        }
+
+        for (uint32_t cell = 0; cell < mConfig.mRolloutCells && !simulation.IsOver(); cell++)
+        {
+            AdvanceCell(simulation, ChooseRolloutMove(simulation, random));
+        }
+
+        int64_t reward = static_cast<int64_t>(simulation.GetBodyLength()) - static_cast<int64_t>(root.GetBodyLength());
+        if (simulation.GetGameOverCause() == GameOverCause::HitWall || simulation.GetGameOverCause() == GameOverCause::HitBody)
+        {
+            reward -= mConfig.mDeathPenalty;
+        }
+
+        for (size_t i = 0; i < path.size(); i++)
+        {
+            Node& node = mNodes[path[i]];
+            node.mVisits.fetch_add(1, std::memory_order_relaxed);
+            node.mValueSum.fetch_add(reward, std::memory_order_relaxed);
+            if (i < numVirtualLosses)
+            {
+                node.mVirtualLoss.fetch_sub(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    uint32_t MctsPlayer::ChooseMove(const Simulation& simulation, MctsStats* statsOut)
+    {
+        assert(!simulation.IsOver());
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        auto elapsedSeconds = [&]()
+        {
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        };
+
+        mNodes[0].Clear();
+        mNumNodes = 1;
+        mNumTableHits.store(0, std::memory_order_relaxed);
+        ReachNode(mNodes[0], simulation, simulation.GetBodyLength());
+
+        size_t numSlots = mPaths.size();
+        uint64_t numRollouts = 0;
+        do
+        {
+            for (size_t slot = 0; slot < numSlots; slot++)
+            {
+                SelectLeaf(mPaths[slot]);
+            }
+
+            mPool.ParallelFor(numSlots, [&](size_t workerIndex, size_t slot)
+            {
+                RunIteration(simulation, numRollouts + slot, mPaths[slot], mWorkers[workerIndex]);
+            });
+            numRollouts += numSlots;
+        }
+        while (mConfig.mTimeBudgetSeconds > 0.0 ? elapsedSeconds() < mConfig.mTimeBudgetSeconds : numRollouts < mConfig.mRolloutsPerMove);
+
+        if (mTable != nullptr)
+        {
+            StoreNodes(simulation.GetBodyLength());
+        }
+
+        uint32_t inputs = 0;
+        const Node& root = mNodes[0];
+        if (root.mState.load(std::memory_order_acquire) == Node::Expanded)
+        {
+            uint64_t bestVisits = 0;
+            for (uint32_t child = root.mFirstChild; child < root.mFirstChild + root.mNumChildren; child++)
+            {
+                uint64_t visits = mNodes[child].mVisits.load(std::memory_order_relaxed);
+                if (visits > bestVisits)
+                {
+                    bestVisits = visits;
+                    inputs = mNodes[child].mInputs;
+                }
+            }
+        }
+
+        if (statsOut != nullptr)
+        {
+            statsOut->mNumRollouts = numRollouts;
+            statsOut->mNumNodes = mNumNodes;
+            statsOut->mNumTableHits = mNumTableHits.load(std::memory_order_relaxed);
+            statsOut->mElapsedSeconds = elapsedSeconds();
+        }
+
+        return inputs;
+    }
+
+} // namespace Snake
@@ -0,0 +1,81 @@
+// MctsPlayer.h
+
+#pragma once
+
+#include "Simulation.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace Vnm
+{
+    class WorkStealingPool;
+}
+
+namespace Snake
+{
+    class TranspositionTable;
+
+    class MctsConfig
+    {
+    public:
+        uint64_t mSeed = 1;
+        uint64_t mRolloutsPerMove = 4096;
+        double   mTimeBudgetSeconds = 0.0;  // Above zero, searches until the budget is spent instead; not reproducible
+        double   mExploration = 2.0;
+        uint32_t mRolloutCells = 64;        // Random moves a rollout plays past the tree
+        int32_t  mDeathPenalty = 8;         // In power-ups
+        size_t   mMaxNodes = 1 << 18;
+    };
+
+    class MctsStats
+    {
+    public:
+        uint64_t mNumRollouts = 0;
+        size_t   mNumNodes = 0;
+        size_t   mNumTableHits = 0;         // Nodes that started from statistics in the transposition table
+        double   mElapsedSeconds = 0.0;
+    };
+
+    // Tree-parallel Monte Carlo tree search over the moves at each cell boundary
+    // Each round selects one leaf per pool thread, adding virtual loss along the way so the threads spread out. The
+    // threads then replay their paths and run rollouts on their own copies of the simulation, expand leaves with a
+    // compare-and-swap and add results back with atomics. Selection is the only serial part, and integer results sum
+    // the same in any order, so with a rollout budget a move depends only on the seed and the thread count.
+    // Power-up placement follows the simulation's own generator, so the search sees the actual future of the position.
+    // With a transposition table, nodes start from the statistics earlier searches stored for their position, keyed by
+    // Simulation::GetHash, and each search stores its own once it is done. The table is only read during a search and
+    // only written between searches, so moves stay reproducible; players searching in turn can share one.
+    class MctsPlayer
+    {
+    public:
+        MctsPlayer(Vnm::WorkStealingPool& pool, const MctsConfig& config, TranspositionTable* table = nullptr);
+        ~MctsPlayer();
+
+        MctsPlayer(const MctsPlayer&) = delete;
+        MctsPlayer& operator=(const MctsPlayer&) = delete;
+
+        // Inputs of the most visited move from a simulation that has just entered a cell
+        uint32_t ChooseMove(const Simulation& simulation, MctsStats* statsOut = nullptr);
+
+    private:
+        class Node;
+        class Worker;
+
+        size_t AllocateChildren();
+        void SelectLeaf(std::vector<uint32_t>& pathOut);
+        void RunIteration(const Simulation& root, uint64_t iteration, std::vector<uint32_t>& path, Worker& worker);
+        void ReachNode(Node& node, const Simulation& simulation, size_t rootLength);
+        void StoreNodes(size_t rootLength);
+
+        Vnm::WorkStealingPool&      mPool;
+        MctsConfig                  mConfig;
+        TranspositionTable*         mTable;
+        std::unique_ptr<Node[]>     mNodes;
+        size_t                      mNumNodes = 0;
+        std::unique_ptr<Worker[]>   mWorkers;
+        std::vector<std::vector<uint32_t>> mPaths;  // Selected path of each slot of the current round
+        std::atomic<size_t>         mNumTableHits;
+    };
+
+} // namespace Snake
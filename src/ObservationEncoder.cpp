@@ -0,0 +1,367 @@
+// ObservationEncoder.cpp
+
+#include "ObservationEncoder.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define OBSERVATION_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define OBSERVATION_SSE2
+#endif
+
+namespace Snake
+{
+    namespace
+    {
+        constexpr uint8_t ChannelOn = 255;
+
+        // Round to nearest even; values below the smallest normal half flush to zero, which observations never reach
+        uint16_t FloatToHalf(float value)
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+
+            uint32_t sign = (bits >> 16) & 0x8000;
+            int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+            uint32_t mantissa = bits & 0x7fffff;
+            if (exponent <= 0)
+            {
+                return static_cast<uint16_t>(sign);
+            }
+            if (exponent >= 31)
+            {
+                return static_cast<uint16_t>(sign | 0x7c00);
+            }
+
+            // A carry out of the mantissa correctly bumps the exponent
+            uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+            uint32_t remainder = mantissa & 0x1fff;
+            if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+            {
+                half++;
+            }
+            return static_cast<uint16_t>(half);
+        }
+
+        // Half precision of value / 255 for every byte value
+        class HalfTable
+        {
+        public:
+            HalfTable()
+            {
+                for (int i = 0; i < 256; i++)
+                {
+                    mValues[i] = FloatToHalf(static_cast<float>(i) * (1.0f / 255.0f));
+                }
+            }
+
+            uint16_t mValues[256];
+        };
+
+        const HalfTable& GetHalfTable()
+        {
+            static const HalfTable table;
+            return table;
+        }
+
+        constexpr uint16_t HalfOne = 0x3c00;
+
+        uint8_t ToOutput(uint8_t value, uint8_t*)   { return value; }
+        uint16_t ToOutput(uint8_t value, uint16_t*) { return GetHalfTable().mValues[value]; }
+
+        // Writes full scale wherever the cell type matches, zero elsewhere
+        void EncodeTypeMask(const GamePieceType* types, size_t numCells, GamePieceType type, uint8_t* out)
+        {
+            const uint8_t* typeBytes = reinterpret_cast<const uint8_t*>(types);
+            size_t i = 0;
+
+#if defined(OBSERVATION_AVX2)
+            // Equal bytes compare to 0xff, which is exactly full scale
+            const __m256i typeVector = _mm256_set1_epi8(static_cast<char>(type));
+            for (; i + 32 <= numCells; i += 32)
+            {
+                __m256i cells = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(typeBytes + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_cmpeq_epi8(cells, typeVector));
+            }
+#elif defined(OBSERVATION_SSE2)
+            const __m128i typeVector = _mm_set1_epi8(static_cast<char>(type));
+            for (; i + 16 <= numCells; i += 16)
+            {
+                __m128i cells = _mm_loadu_si128(reinterpret_cast<const __m128i*>(typeBytes + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_cmpeq_epi8(cells, typeVector));
+            }
+#endif
+
+            for (; i < numCells; i++)
+            {
+                out[i] = typeBytes[i] == static_cast<uint8_t>(type) ? ChannelOn : 0;
+            }
+        }
+
+        void EncodeTypeMask(const GamePieceType* types, size_t numCells, GamePieceType type, uint16_t* out)
+        {
+            const uint8_t* typeBytes = reinterpret_cast<const uint8_t*>(types);
+            size_t i = 0;
+
+#if defined(OBSERVATION_AVX2)
+            // Widen each byte mask to 16 bits and keep the bits of 1.0
+            const __m256i typeVector = _mm256_set1_epi8(static_cast<char>(type));
+            const __m256i one = _mm256_set1_epi16(static_cast<short>(HalfOne));
+            for (; i + 32 <= numCells; i += 32)
+            {
+                __m256i mask = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(typeBytes + i)), typeVector);
+                __m256i low = _mm256_cvtepi8_epi16(_mm256_castsi256_si128(mask));
+                __m256i high = _mm256_cvtepi8_epi16(_mm256_extracti128_si256(mask, 1));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_and_si256(low, one));
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 16), _mm256_and_si256(high, one));
+            }
+#elif defined(OBSERVATION_SSE2)
+            const __m128i typeVector = _mm_set1_epi8(static_cast<char>(type));
+            const __m128i one = _mm_set1_epi16(static_cast<short>(HalfOne));
+            for (; i + 16 <= numCells; i += 16)
+            {
+                __m128i mask = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(typeBytes + i)), typeVector);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_and_si128(_mm_unpacklo_epi8(mask, mask), one));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i + 8), _mm_and_si128(_mm_unpackhi_epi8(mask, mask), one));
+            }
+#endif
+
+            for (; i < numCells; i++)
+            {
+                out[i] = typeBytes[i] == static_cast<uint8_t>(type) ? HalfOne : 0;
+            }
+        }
+
+        // Body ages from the tail up, ChannelOn * (index + 1) / length, carried forward rather than divided per piece
+        class BodyAges
+        {
+        public:
+            explicit BodyAges(size_t length)
+                : mLength(length)
+                , mStep(length > 0 ? ChannelOn / length : 0)
+                , mStepRemainder(length > 0 ? ChannelOn % length : 0)
+            {
+            }
+
+            // Carries are data dependent, so they are added rather than branched on
+            uint8_t Next()
+            {
+                mRemainder += mStepRemainder;
+                size_t carry = mRemainder >= mLength ? 1 : 0;
+                mRemainder -= carry * mLength;
+                mAge += mStep + carry;
+                return static_cast<uint8_t>(mAge);
+            }
+
+        private:
+            size_t mLength;
+            size_t mStep;
+            size_t mStepRemainder;
+            size_t mAge = 0;
+            size_t mRemainder = 0;
+        };
+
+        template<typename OutputType> void EncodeGrid(const Simulation& simulation, OutputType* out)
+        {
+            const GameBoard& board = simulation.GetBoard();
+            const SnakeBody& body = simulation.GetBody();
+
+            size_t numCells = board.GetNumCells();
+            OutputType* wall = out + static_cast<size_t>(ObservationChannel::Wall) * numCells;
+            OutputType* bodyAge = out + static_cast<size_t>(ObservationChannel::BodyAge) * numCells;
+            OutputType* powerUp = out + static_cast<size_t>(ObservationChannel::PowerUp) * numCells;
+            OutputType* head = out + static_cast<size_t>(ObservationChannel::Head) * numCells;
+
+            // Dense channels come straight from the cell types
+            EncodeTypeMask(board.GetGamePieceTypes(), numCells, GamePieceType::Wall, wall);
+            EncodeTypeMask(board.GetGamePieceTypes(), numCells, GamePieceType::PowerUp, powerUp);
+
+            // Sparse channels are cleared, zero is all zero bits in both formats, and then touch only the snake's cells
+            memset(bodyAge, 0, numCells * sizeof(OutputType));
+            memset(head, 0, numCells * sizeof(OutputType));
+
+            size_t length = body.GetLength();
+            BodyAges ages(length);
+            for (size_t i = 0; i < length; i++)
+            {
+                bodyAge[body.GetCell(i)] = ToOutput(ages.Next(), out);
+            }
+            if (length > 0)
+            {
+                head[body.GetHead()] = ToOutput(ChannelOn, out);
+            }
+        }
+
+        // Reads the crop straight from the board, so its cost depends on the crop and body size, not the board size
+        template<typename OutputType> void EncodeCrop(const Simulation& simulation, int radius, OutputType* out)
+        {
+            const GameBoard& board = simulation.GetBoard();
+            const BoardLayout& layout = board.GetLayout();
+            const GamePieceType* types = board.GetGamePieceTypes();
+            const int* head = simulation.GetHeadCell();
+            const int* right = simulation.GetRight();
+            const int* up = simulation.GetUp();
+            const int* forward = simulation.GetForward();
+
+            int side = 2 * radius + 1;
+            size_t channelSize = static_cast<size_t>(side) * side * side;
+            OutputType* wall = out + static_cast<size_t>(ObservationChannel::Wall) * channelSize;
+            OutputType* bodyAge = out + static_cast<size_t>(ObservationChannel::BodyAge) * channelSize;
+            OutputType* powerUp = out + static_cast<size_t>(ObservationChannel::PowerUp) * channelSize;
+            OutputType* headChannel = out + static_cast<size_t>(ObservationChannel::Head) * channelSize;
+
+            // The snake's basis is a signed permutation of the board axes, so crop rows run along right's axis and b and c
+            // each step along one other axis; which rows are on the board, and where rows clip, is worked out per axis
+            auto findAxis = [](const int* direction) { return direction[0] != 0 ? 0 : direction[1] != 0 ? 1 : 2; };
+            auto calcStride = [&](const int* direction, int axis)
+            {
+                return direction[axis] * static_cast<ptrdiff_t>(layout.CalcIndex(axis == 0, axis == 1, axis == 2));
+            };
+            auto clipToBoard = [&](const int* direction, int axis, int& beginOut, int& endOut)
+            {
+                int size = static_cast<int>(layout.GetNumPieces(axis));
+                int low = direction[axis] > 0 ? -head[axis] : head[axis] - size + 1;
+                beginOut = std::max(0, low + radius);
+                endOut = std::max(beginOut, std::min(side, low + size + radius));
+            };
+
+            int rowAxis = findAxis(right);
+            int upAxis = findAxis(up);
+            int forwardAxis = findAxis(forward);
+            ptrdiff_t rowStride = calcStride(right, rowAxis);
+            ptrdiff_t upStride = calcStride(up, upAxis);
+            ptrdiff_t forwardStride = calcStride(forward, forwardAxis);
+
+            int aBegin;
+            int aEnd;
+            int bBegin;
+            int bEnd;
+            int cBegin;
+            int cEnd;
+            clipToBoard(right, rowAxis, aBegin, aEnd);
+            clipToBoard(up, upAxis, bBegin, bEnd);
+            clipToBoard(forward, forwardAxis, cBegin, cEnd);
+
+            // Gather the crop's cell types into the body age channel, which is cleared only afterwards, so the wall and
+            // power-up channels come from the same vector masks as the grid's. Everything off the board reads as wall.
+            uint8_t* cropTypes = reinterpret_cast<uint8_t*>(bodyAge);
+            const uint8_t* typeBytes = reinterpret_cast<const uint8_t*>(types);
+            memset(cropTypes, static_cast<int>(GamePieceType::Wall), channelSize);
+            if (aBegin < aEnd)
+            {
+                ptrdiff_t headIndex = static_cast<ptrdiff_t>(layout.CalcIndex(head[0], head[1], head[2]));
+                size_t rowLength = static_cast<size_t>(aEnd - aBegin);
+                for (int c = cBegin; c < cEnd; c++)
+                {
+                    for (int b = bBegin; b < bEnd; b++)
+                    {
+                        uint8_t* row = cropTypes + (static_cast<size_t>(c) * side + b) * side + aBegin;
+                        const uint8_t* cells = typeBytes + headIndex + (aBegin - radius) * rowStride + (b - radius) * upStride +
+                            (c - radius) * forwardStride;
+                        if (rowStride == 1)
+                        {
+                            memcpy(row, cells, rowLength);
+                        }
+                        else
+                        {
+                            for (size_t a = 0; a < rowLength; a++, cells += rowStride)
+                            {
+                                row[a] = *cells;
+                            }
+                        }
+                    }
+                }
+            }
+
+            const GamePieceType* cropTypePieces = reinterpret_cast<const GamePieceType*>(cropTypes);
+            EncodeTypeMask(cropTypePieces, channelSize, GamePieceType::Wall, wall);
+            EncodeTypeMask(cropTypePieces, channelSize, GamePieceType::PowerUp, powerUp);
+
+            const OutputType on = ToOutput(ChannelOn, out);
+            memset(bodyAge, 0, channelSize * sizeof(OutputType));
+            memset(headChannel, 0, channelSize * sizeof(OutputType));
+
+            // Project body pieces into crop space and keep those that land inside it. Consecutive pieces are neighbouring
+            // cells, so a piece d cells from the head along its farthest axis rules out the next d - radius - 1 as well.
+            const SnakeBody& body = simulation.GetBody();
+            size_t length = body.GetLength();
+            for (size_t i = 0; i < length; )
+            {
+                int cell[3];
+                board.GetCellCoords(body.GetCell(i), cell[0], cell[1], cell[2]);
+
+                int delta[3] = { cell[0] - head[0], cell[1] - head[1], cell[2] - head[2] };
+                int distance = std::max({ std::abs(delta[0]), std::abs(delta[1]), std::abs(delta[2]) });
+                if (distance > radius)
+                {
+                    i += distance - radius;
+                    continue;
+                }
+
+                int a = delta[0] * right[0] + delta[1] * right[1] + delta[2] * right[2];
+                int b = delta[0] * up[0] + delta[1] * up[1] + delta[2] * up[2];
+                int c = delta[0] * forward[0] + delta[1] * forward[1] + delta[2] * forward[2];
+                size_t index = (static_cast<size_t>(c + radius) * side + (b + radius)) * side + (a + radius);
+
+                // Same age as BodyAges gives the piece, computed directly as pieces are skipped
+                bodyAge[index] = ToOutput(static_cast<uint8_t>(ChannelOn * (i + 1) / length), out);
+                i++;
+            }
+
+            if (length > 0)
+            {
+                headChannel[(static_cast<size_t>(radius) * side + radius) * side + radius] = on;
+            }
+        }
+    }
+
+    size_t GetGridObservationSize(const BoardLayout& layout, ObservationFormat format)
+    {
+        return NumObservationChannels * layout.GetNumCells() * GetObservationElementSize(format);
+    }
+
+    size_t GetEgocentricObservationSize(int radius, ObservationFormat format)
+    {
+        assert(radius >= 0);
+        size_t side = 2 * static_cast<size_t>(radius) + 1;
+        return NumObservationChannels * side * side * side * GetObservationElementSize(format);
+    }
+
+    int GetMaxEgocentricRadius(const BoardLayout& layout)
+    {
+        // From any interior head, every board cell is within the largest extent less one
+        size_t maxExtent = std::max({ layout.GetNumPieces(0), layout.GetNumPieces(1), layout.GetNumPieces(2) });
+        return static_cast<int>(maxExtent - 1);
+    }
+
+    void EncodeGridObservation(const Simulation& simulation, ObservationFormat format, void* out)
+    {
+        if (format == ObservationFormat::UInt8)
+        {
+            EncodeGrid(simulation, static_cast<uint8_t*>(out));
+        }
+        else
+        {
+            EncodeGrid(simulation, static_cast<uint16_t*>(out));
+        }
+    }
+
+    void EncodeEgocentricObservation(const Simulation& simulation, int radius, ObservationFormat format, void* out)
+    {
+        assert(radius >= 0 && radius <= GetMaxEgocentricRadius(simulation.GetBoard().GetLayout()));
+
+        if (format == ObservationFormat::UInt8)
+        {
+            EncodeCrop(simulation, radius, static_cast<uint8_t*>(out));
+        }
+        else
+        {
+            EncodeCrop(simulation, radius, static_cast<uint16_t*>(out));
+        }
+    }
+
+} // namespace Snake
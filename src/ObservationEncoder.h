@@ -0,0 +1,42 @@
+// ObservationEncoder.h
+
+#pragma once
+
+#include "Simulation.h"
+
+namespace Snake
+{
+    // Channels are stored one after another, each a full grid of cells
+    enum class ObservationChannel : uint8_t
+    {
+        Wall,
+        BodyAge,        // Rises from the tail, the next piece to expire, up to the head
+        PowerUp,
+        Head,
+        Count
+    };
+
+    enum class ObservationFormat : uint8_t
+    {
+        UInt8,          // 0 to 255
+        Float16,        // 0.0 to 1.0, IEEE half precision
+    };
+
+    constexpr size_t NumObservationChannels = static_cast<size_t>(ObservationChannel::Count);
+
+    inline size_t GetObservationElementSize(ObservationFormat format) { return format == ObservationFormat::UInt8 ? 1 : 2; }
+
+    // Voxel grids of game state for agents, written straight into caller memory
+    // The grid covers the whole board in board index order. The egocentric crop is a cube of side 2 * radius + 1 centered
+    // on the head with its x, y and z axes along the snake's right, up and forward, so it reads the same whichever way
+    // the snake is facing; cells beyond the board read as wall.
+    size_t GetGridObservationSize(const BoardLayout& layout, ObservationFormat format);
+    size_t GetEgocentricObservationSize(int radius, ObservationFormat format);
+
+    // Largest egocentric radius for a board; past it a crop only adds wall, so larger radii are rejected
+    int GetMaxEgocentricRadius(const BoardLayout& layout);
+
+    void EncodeGridObservation(const Simulation& simulation, ObservationFormat format, void* out);
+    void EncodeEgocentricObservation(const Simulation& simulation, int radius, ObservationFormat format, void* out);
+
+} // namespace Snake
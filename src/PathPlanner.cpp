@@ -0,0 +1,253 @@
+// PathPlanner.cpp
+
+#include "PathPlanner.h"
+
+namespace Snake
+{
+    class PathPlanner::Grids
+    {
+    public:
+        explicit Grids(const BoardLayout& layout)
+            : mLayout(layout)
+            , mPassable(layout)
+            , mAfterPath(layout)
+            , mVisited(layout)
+        {
+            mLayers.emplace_back(layout);
+            mLayers.emplace_back(layout);
+        }
+
+        BoardLayout          mLayout;
+        BitGrid              mPassable;     // Empty and power-up cells of the tracked board
+        BitGrid              mAfterPath;    // Passable cells once the snake has followed mPath
+        BitGrid              mVisited;
+        std::vector<BitGrid> mLayers;       // Cells first reached at each distance of the last search
+    };
+
+    PathPlanner::PathPlanner() = default;
+    PathPlanner::~PathPlanner() = default;
+
+    void PathPlanner::Reset()
+    {
+        mBoard = nullptr;
+    }
+
+    const BitGrid* PathPlanner::GetPassable() const
+    {
+        return mGrids != nullptr ? &mGrids->mPassable : nullptr;
+    }
+
+    void PathPlanner::SyncPassable(const GameBoard& board)
+    {
+        if (mGrids == nullptr || !(mGrids->mLayout == board.GetLayout()))
+        {
+            mGrids = std::make_unique<Grids>(board.GetLayout());
+            mBoard = nullptr;
+        }
+
+        BitGrid& passable = mGrids->mPassable;
+        bool drained = mBoard == &board && board.GetJournal().Drain(mJournalCursor, [&](const BoardChange& change)
+        {
+            if (change.mNewType == GamePieceType::Empty || change.mNewType == GamePieceType::PowerUp)
+            {
+                passable.Set(change.mCellIndex);
+            }
+            else
+            {
+                passable.Reset(change.mCellIndex);
+            }
+        });
+
+        if (!drained)
+        {
+            passable.Clear();
+            passable.SetFromTypes(board, GamePieceType::Empty);
+            passable.SetFromTypes(board, GamePieceType::PowerUp);
+            mBoard = &board;
+            mJournalCursor = board.GetJournal().GetWritePosition();
+        }
+    }
+
+    size_t PathPlanner::Search(size_t from, size_t to, const BitGrid& passable, size_t minDistance)
+    {
+        std::vector<BitGrid>& layers = mGrids->mLayers;
+        BitGrid& visited = mGrids->mVisited;
+
+        visited.Clear();
+        visited.Set(from);
+        layers[0].Clear();
+        layers[0].Set(from);
+
+        for (size_t distance = 1; ; distance++)
+        {
+            if (distance == layers.size())
+            {
+                layers.emplace_back(mGrids->mLayout);
+            }
+
+            if (!BitGrid::ExpandFrontier(layers[distance - 1], passable, visited, layers[distance]))
+            {
+                return 0;
+            }
+
+            if (!layers[distance].Test(to))
+            {
+                continue;
+            }
+
+            if (distance < minDistance)
+            {
+                // Too close; leave it to be reached again by a longer route
+                layers[distance].Reset(to);
+                visited.Reset(to);
+                continue;
+            }
+
+            // Walk back through the layers; any neighbour one layer nearer lies on a shortest path
+            const ptrdiff_t* offsets = passable.GetNeighbourOffsets();
+            mPath.resize(distance);
+            size_t cell = to;
+            mPath[distance - 1] = to;
+            for (size_t layer = distance - 1; layer > 0; layer--)
+            {
+                for (int n = 0; n < 6; n++)
+                {
+                    size_t neighbour = cell + offsets[n];
+                    if (layers[layer].Test(neighbour))
+                    {
+                        cell = neighbour;
+                        break;
+                    }
+                }
+                mPath[layer - 1] = cell;
+            }
+
+            return distance;
+        }
+    }
+
+    size_t PathPlanner::FloodFill(size_t from, const BitGrid& passable)
+    {
+        std::vector<BitGrid>& layers = mGrids->mLayers;
+        BitGrid& visited = mGrids->mVisited;
+
+        visited.Clear();
+        visited.Set(from);
+        layers[0].Clear();
+        layers[0].Set(from);
+
+        size_t current = 0;
+        while (BitGrid::ExpandFrontier(layers[current], passable, visited, layers[current ^ 1]))
+        {
+            current ^= 1;
+        }
+
+        return visited.Count();
+    }
+
+    bool PathPlanner::CanReachTailAfterPath(const Simulation& simulation)
+    {
+        // Replay mPath on a copy of the passable grid: every step but the last, which eats, frees a tail cell
+        const SnakeBody& body = simulation.GetBody();
+        size_t bodyLength = body.GetLength();
+        size_t numFreed = mPath.size() - 1;
+
+        // Cells the snake has covered, from the current tail through the body and along the path
+        auto trailCell = [&](size_t i)
+        {
+            return i < bodyLength ? body.GetCell(i) : mPath[i - bodyLength];
+        };
+
+        BitGrid& afterPath = mGrids->mAfterPath;
+        afterPath = mGrids->mPassable;
+        for (size_t cell : mPath)
+        {
+            afterPath.Reset(cell);
+        }
+        for (size_t i = 0; i < numFreed; i++)
+        {
+            afterPath.Set(trailCell(i));
+        }
+
+        // The tail cell is still occupied when the head would enter it, so it has to be at least two moves away
+        size_t tail = trailCell(numFreed);
+        size_t head = mPath.back();
+        afterPath.Set(tail);
+        return Search(head, tail, afterPath, 2) != 0;
+    }
+
+    size_t PathPlanner::Plan(const Simulation& simulation)
+    {
+        mNumPlans++;
+
+        const GameBoard& board = simulation.GetBoard();
+        SyncPassable(board);
+        BitGrid& passable = mGrids->mPassable;
+
+        const int* head = simulation.GetHeadCell();
+        const int* forward = simulation.GetForward();
+        size_t headIndex = board.GetCellIndex(head[0], head[1], head[2]);
+        size_t straightIndex = board.GetCellIndex(head[0] + forward[0], head[1] + forward[1], head[2] + forward[2]);
+
+        // Reversing is never a move; the cell behind is body anyway except on a snake of length one
+        size_t behindIndex = board.GetCellIndex(head[0] - forward[0], head[1] - forward[1], head[2] - forward[2]);
+        bool behindPassable = passable.Test(behindIndex);
+        passable.Reset(behindIndex);
+
+        size_t next = straightIndex;
+        bool planned = false;
+
+        if (Search(headIndex, simulation.GetPowerUpCell(), passable) != 0)
+        {
+            size_t firstCell = mPath[0];
+            if (CanReachTailAfterPath(simulation))
+            {
+                next = firstCell;
+                planned = true;
+            }
+        }
+
+        // Following the tail keeps a way out open until the power-up becomes safe to take
+        size_t tailIndex = simulation.GetBody().GetTail();
+        if (!planned && tailIndex != headIndex)
+        {
+            passable.Set(tailIndex);
+            if (Search(headIndex, tailIndex, passable, 2) != 0)
+            {
+                next = mPath[0];
+                planned = true;
+            }
+            passable.Reset(tailIndex);
+        }
+
+        // Boxed in: survive as long as possible in the largest region
+        if (!planned)
+        {
+            const ptrdiff_t* offsets = passable.GetNeighbourOffsets();
+            size_t bestArea = passable.Test(straightIndex) ? FloodFill(straightIndex, passable) : 0;
+            for (int n = 0; n < 6; n++)
+            {
+                size_t neighbour = headIndex + offsets[n];
+                if (neighbour == straightIndex || !passable.Test(neighbour))
+                {
+                    continue;
+                }
+
+                size_t area = FloodFill(neighbour, passable);
+                if (area > bestArea)
+                {
+                    bestArea = area;
+                    next = neighbour;
+                }
+            }
+        }
+
+        if (behindPassable)
+        {
+            passable.Set(behindIndex);
+        }
+
+        return next;
+    }
+
+} // namespace Snake
@@ -0,0 +1,57 @@
+// PathPlanner.h
+
+#pragma once
+
+#include "BitGrid.h"
+#include "Simulation.h"
+#include <memory>
+#include <vector>
+
+namespace Snake
+{
+    // Picks the head's next cell by breadth-first search over bit grids
+    // Takes the shortest path to the power-up when the tail is still reachable once it is eaten, otherwise follows
+    // the tail, otherwise moves into the largest open region. The passable grid follows the board through its
+    // journal, so a plan costs a few searches rather than a rebuild from the cell types.
+    class PathPlanner
+    {
+    public:
+        PathPlanner();
+        ~PathPlanner();
+
+        PathPlanner(const PathPlanner&) = delete;
+        PathPlanner& operator=(const PathPlanner&) = delete;
+
+        // Drops board tracking so the next plan rebuilds from the full board
+        void Reset();
+
+        // Neighbour of the head to move into next, or the cell straight ahead if every move is fatal
+        size_t Plan(const Simulation& simulation);
+
+        uint64_t GetNumPlans() const { return mNumPlans; }
+
+        // Empty and power-up cells as of the last plan, kept up to date through the board's journal; null before any plan
+        const BitGrid* GetPassable() const;
+
+    private:
+        class Grids;
+
+        void SyncPassable(const GameBoard& board);
+
+        // Distance of the shortest passable path from one cell to another, or zero if there is none
+        // The path is left in mPath, excluding from and ending with to. Paths shorter than minDistance are ignored.
+        size_t Search(size_t from, size_t to, const BitGrid& passable, size_t minDistance = 1);
+
+        // Number of passable cells reachable from a passable cell, including it
+        size_t FloodFill(size_t from, const BitGrid& passable);
+
+        bool CanReachTailAfterPath(const Simulation& simulation);
+
+        std::unique_ptr<Grids> mGrids;
+        const GameBoard*       mBoard = nullptr;
+        uint64_t               mJournalCursor = 0;
+        std::vector<size_t>    mPath;
+        uint64_t               mNumPlans = 0;
+    };
+
+} // namespace Snake
@@ -0,0 +1,157 @@
+// Policy.cpp
+
+#include "Policy.h"
+#include "PathPlanner.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace Snake
+{
+    namespace
+    {
+        class GreedyPolicy : public Policy
+        {
+        public:
+            void Reset(uint64_t) override {}
+
+            uint32_t ChooseInputs(const Simulation& simulation, StepResult lastResult) override
+            {
+                // Only a new cell offers a new choice
+                if (lastResult == StepResult::Moved)
+                {
+                    return 0;
+                }
+
+                const GameBoard& board = simulation.GetBoard();
+                const int* head = simulation.GetHeadCell();
+
+                int target[3];
+                board.GetCellCoords(simulation.GetPowerUpCell(), target[0], target[1], target[2]);
+
+                Move moves[NumMoves];
+                GetMoves(simulation, moves);
+
+                uint32_t bestInputs = 0;
+                int bestDistance = INT32_MAX;
+                for (const Move& move : moves)
+                {
+                    int next[3] = { head[0] + move.mDirection[0], head[1] + move.mDirection[1], head[2] + move.mDirection[2] };
+                    if (board.IsWall(next[0], next[1], next[2]) ||
+                        board.GetGamePieceType(next[0], next[1], next[2]) == GamePieceType::SnakeBody)
+                    {
+                        continue;
+                    }
+
+                    int distance = std::abs(target[0] - next[0]) + std::abs(target[1] - next[1]) + std::abs(target[2] - next[2]);
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        bestInputs = move.mInputs;
+                    }
+                }
+
+                return bestInputs;
+            }
+        };
+
+        class RandomTurnsPolicy : public Policy
+        {
+        public:
+            void Reset(uint64_t seed) override { mRandom.Seed(~seed); }
+
+            uint32_t ChooseInputs(const Simulation&, StepResult) override
+            {
+                const uint32_t turns[] = { InputTurnLeft, InputTurnRight, InputTiltUp, InputTiltDown };
+                return mRandom() % Simulation::UnitsPerBlock == 0 ? turns[mRandom() % 4] : 0;
+            }
+
+        private:
+            Random mRandom;
+        };
+
+        class PathfindingPolicy : public Policy
+        {
+        public:
+            void Reset(uint64_t) override { mPlanner.Reset(); }
+
+            uint32_t ChooseInputs(const Simulation& simulation, StepResult lastResult) override
+            {
+                if (lastResult == StepResult::Moved)
+                {
+                    return 0;
+                }
+
+                int next[3];
+                simulation.GetBoard().GetCellCoords(mPlanner.Plan(simulation), next[0], next[1], next[2]);
+                const int* head = simulation.GetHeadCell();
+
+                Move moves[NumMoves];
+                GetMoves(simulation, moves);
+                for (const Move& move : moves)
+                {
+                    if (head[0] + move.mDirection[0] == next[0] &&
+                        head[1] + move.mDirection[1] == next[1] &&
+                        head[2] + move.mDirection[2] == next[2])
+                    {
+                        return move.mInputs;
+                    }
+                }
+
+                return 0;
+            }
+
+        private:
+            PathPlanner mPlanner;
+        };
+
+        const char* const PolicyNames[] = { "greedy", "random", "path" };
+    }
+
+    void GetMoves(const Simulation& simulation, Move movesOut[NumMoves])
+    {
+        const int* forward = simulation.GetForward();
+        const int* up = simulation.GetUp();
+        const int* right = simulation.GetRight();
+
+        movesOut[0] = { 0,               {  forward[0],  forward[1],  forward[2] } };
+        movesOut[1] = { InputTurnRight,  {  right[0],    right[1],    right[2] } };
+        movesOut[2] = { InputTurnLeft,   { -right[0],   -right[1],   -right[2] } };
+        movesOut[3] = { InputTiltUp,     {  up[0],       up[1],       up[2] } };
+        movesOut[4] = { InputTiltDown,   { -up[0],      -up[1],      -up[2] } };
+    }
+
+    std::unique_ptr<Policy> CreatePolicy(PolicyType type)
+    {
+        switch (type)
+        {
+        case PolicyType::Greedy:
+            return std::make_unique<GreedyPolicy>();
+        case PolicyType::RandomTurns:
+            return std::make_unique<RandomTurnsPolicy>();
+        case PolicyType::Pathfinding:
+            return std::make_unique<PathfindingPolicy>();
+        }
+
+        return nullptr;
+    }
+
+    const char* GetPolicyName(PolicyType type)
+    {
+        return PolicyNames[static_cast<size_t>(type)];
+    }
+
+    bool FindPolicy(const char* name, PolicyType& typeOut)
+    {
+        for (size_t i = 0; i < sizeof(PolicyNames) / sizeof(PolicyNames[0]); i++)
+        {
+            if (strcmp(name, PolicyNames[i]) == 0)
+            {
+                typeOut = static_cast<PolicyType>(i);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+} // namespace Snake
@@ -0,0 +1,49 @@
+// Policy.h
+
+#pragma once
+
+#include "Random.h"
+#include "Simulation.h"
+#include <memory>
+
+namespace Snake
+{
+    enum class PolicyType : uint8_t
+    {
+        Greedy,         // Heads for the power-up through whichever free neighbouring cell is closest to it
+        RandomTurns,    // Quarter turn in a random direction about once per block
+        Pathfinding,    // Shortest safe path to the power-up, see PathPlanner
+    };
+
+    // A choice at a cell boundary: the inputs to press and the direction the head then travels
+    class Move
+    {
+    public:
+        uint32_t mInputs;
+        int      mDirection[3];
+    };
+
+    constexpr int NumMoves = 5;
+
+    // Candidate moves from the current basis; going straight comes first so it wins ties
+    void GetMoves(const Simulation& simulation, Move movesOut[NumMoves]);
+
+    // Chooses the inputs for each simulation step
+    // A policy instance is used by one thread at a time and carries whatever state it needs between steps
+    class Policy
+    {
+    public:
+        virtual ~Policy() = default;
+
+        // Called before each game; policies with randomness derive it from the game seed
+        virtual void Reset(uint64_t seed) = 0;
+
+        // Inputs for the next step; lastResult is the result of the previous step, EnteredCell at the start of a game
+        virtual uint32_t ChooseInputs(const Simulation& simulation, StepResult lastResult) = 0;
+    };
+
+    std::unique_ptr<Policy> CreatePolicy(PolicyType type);
+    const char* GetPolicyName(PolicyType type);
+    bool FindPolicy(const char* name, PolicyType& typeOut);
+
+} // namespace Snake
@@ -0,0 +1,395 @@
+// Pool.h
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace Vnm
+{
+    // 32-bit reference to a pooled object; the low bits index a slot and the high bits hold the slot's generation
+    class PoolHandle
+    {
+    public:
+        PoolHandle() = default;
+        explicit PoolHandle(uint32_t value) : mValue(value) {}
+
+        bool IsNull() const                             { return mValue == 0; }
+        uint32_t GetValue() const                       { return mValue; }
+        bool operator==(const PoolHandle& other) const  { return mValue == other.mValue; }
+        bool operator!=(const PoolHandle& other) const  { return mValue != other.mValue; }
+
+    private:
+        uint32_t mValue = 0;    // Generations start at one, so zero is never a live handle
+    };
+
+    // Bits of a handle that index a slot, for pools of a given capacity
+    constexpr uint32_t CalcPoolIndexBits(size_t capacity)
+    {
+        uint32_t bits = 0;
+        while ((size_t(1) << bits) < capacity)
+        {
+            bits++;
+        }
+        return bits;
+    }
+
+    // Fixed-capacity object pool with O(1) alloc and free
+    // Live objects are kept densely packed (freeing swaps the last object into the hole) so they can be iterated contiguously;
+    // handles stay valid across those moves and are generation checked, so stale handles resolve to null rather than to a reused slot
+    template<typename T, size_t Capacity> class Pool
+    {
+    public:
+        Pool();
+        ~Pool();
+
+        Pool(const Pool&) = delete;
+        Pool& operator=(const Pool&) = delete;
+
+        template<typename... Args> PoolHandle Alloc(Args&&... args);
+        void Free(PoolHandle handle);
+        void Clear();
+
+        T* Get(PoolHandle handle);
+        const T* Get(PoolHandle handle) const;
+        bool IsValid(PoolHandle handle) const { return Get(handle) != nullptr; }
+
+        // Handle of the object at a position in the dense array
+        PoolHandle GetHandle(size_t denseIndex) const;
+
+        size_t GetSize() const                  { return mSize; }
+        static constexpr size_t GetCapacity()   { return Capacity; }
+
+        // Contiguous iteration over live objects
+        T* begin()                              { return GetObjects(); }
+        T* end()                                { return GetObjects() + mSize; }
+        const T* begin() const                  { return GetObjects(); }
+        const T* end() const                    { return GetObjects() + mSize; }
+
+    private:
+        static constexpr uint32_t IndexBits = CalcPoolIndexBits(Capacity);
+        static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+        static constexpr uint32_t GenerationMask = 0xffffffffu >> IndexBits;
+        static constexpr uint32_t FreeFlag = 0x80000000u;  // Marks mDenseIndexOrNextFree of a slot on the free list
+        static_assert(IndexBits <= 24, "Pool capacity leaves too few bits for generations");
+
+        class Slot
+        {
+        public:
+            uint32_t mDenseIndexOrNextFree;     // Dense index while live, next free slot with FreeFlag set otherwise
+            uint32_t mGeneration;
+        };
+
+        alignas(T) unsigned char mObjectStorage[sizeof(T) * Capacity];
+        uint32_t mDenseToSlot[Capacity];    // Slot owning each dense object
+        Slot     mSlots[Capacity];
+        uint32_t mFreeSlot;                 // Head of the slot free list, Capacity when empty
+        size_t   mSize = 0;
+
+        T* GetObjects()             { return reinterpret_cast<T*>(mObjectStorage); }
+        const T* GetObjects() const { return reinterpret_cast<const T*>(mObjectStorage); }
+        uint32_t FindSlot(PoolHandle handle) const;
+    };
+
+    template<typename T, size_t Capacity> Pool<T, Capacity>::Pool()
+    {
+        for (uint32_t i = 0; i < Capacity; i++)
+        {
+            mSlots[i].mDenseIndexOrNextFree = (i + 1) | FreeFlag;
+            mSlots[i].mGeneration = 1;
+        }
+
+        mFreeSlot = 0;
+    }
+
+    template<typename T, size_t Capacity> Pool<T, Capacity>::~Pool()
+    {
+        Clear();
+    }
+
+    template<typename T, size_t Capacity> template<typename... Args> PoolHandle Pool<T, Capacity>::Alloc(Args&&... args)
+    {
+        if (mFreeSlot == Capacity)
+        {
+            return PoolHandle();
+        }
+
+        uint32_t slotIndex = mFreeSlot;
+        Slot& slot = mSlots[slotIndex];
+        mFreeSlot = slot.mDenseIndexOrNextFree & ~FreeFlag;
+
+        uint32_t denseIndex = static_cast<uint32_t>(mSize++);
+        new (GetObjects() + denseIndex) T(std::forward<Args>(args)...);
+        mDenseToSlot[denseIndex] = slotIndex;
+        slot.mDenseIndexOrNextFree = denseIndex;
+
+        return PoolHandle((slot.mGeneration << IndexBits) | slotIndex);
+    }
+
+    template<typename T, size_t Capacity> void Pool<T, Capacity>::Free(PoolHandle handle)
+    {
+        uint32_t slotIndex = FindSlot(handle);
+        assert(slotIndex != Capacity);
+        if (slotIndex == Capacity)
+        {
+            return;
+        }
+
+        Slot& slot = mSlots[slotIndex];
+        uint32_t denseIndex = slot.mDenseIndexOrNextFree;
+        uint32_t lastIndex = static_cast<uint32_t>(--mSize);
+
+        // Keep live objects packed by moving the last one into the hole
+        T* objects = GetObjects();
+        if (denseIndex != lastIndex)
+        {
+            objects[denseIndex] = std::move(objects[lastIndex]);
+            mDenseToSlot[denseIndex] = mDenseToSlot[lastIndex];
+            mSlots[mDenseToSlot[denseIndex]].mDenseIndexOrNextFree = denseIndex;
+        }
+        objects[lastIndex].~T();
+
+        // Bump generation so outstanding handles go stale, skipping zero so a live handle is never null
+        slot.mGeneration = (slot.mGeneration + 1) & GenerationMask;
+        if (slot.mGeneration == 0)
+        {
+            slot.mGeneration = 1;
+        }
+
+        slot.mDenseIndexOrNextFree = mFreeSlot | FreeFlag;
+        mFreeSlot = slotIndex;
+    }
+
+    template<typename T, size_t Capacity> void Pool<T, Capacity>::Clear()
+    {
+        while (mSize > 0)
+        {
+            Free(GetHandle(mSize - 1));
+        }
+    }
+
+    template<typename T, size_t Capacity> T* Pool<T, Capacity>::Get(PoolHandle handle)
+    {
+        uint32_t slotIndex = FindSlot(handle);
+        return slotIndex != Capacity ? GetObjects() + mSlots[slotIndex].mDenseIndexOrNextFree : nullptr;
+    }
+
+    template<typename T, size_t Capacity> const T* Pool<T, Capacity>::Get(PoolHandle handle) const
+    {
+        uint32_t slotIndex = FindSlot(handle);
+        return slotIndex != Capacity ? GetObjects() + mSlots[slotIndex].mDenseIndexOrNextFree : nullptr;
+    }
+
+    template<typename T, size_t Capacity> PoolHandle Pool<T, Capacity>::GetHandle(size_t denseIndex) const
+    {
+        assert(denseIndex < mSize);
+
+        uint32_t slotIndex = mDenseToSlot[denseIndex];
+        return PoolHandle((mSlots[slotIndex].mGeneration << IndexBits) | slotIndex);
+    }
+
+    // Returns the slot a handle refers to, or Capacity if the handle is null, stale or was never handed out
+    // Free slots keep the generation their next handle will carry, so the free flag is what rejects those handles
+    template<typename T, size_t Capacity> uint32_t Pool<T, Capacity>::FindSlot(PoolHandle handle) const
+    {
+        uint32_t slotIndex = handle.GetValue() & IndexMask;
+        uint32_t generation = handle.GetValue() >> IndexBits;
+        if (handle.IsNull() || slotIndex >= Capacity || mSlots[slotIndex].mGeneration != generation ||
+            (mSlots[slotIndex].mDenseIndexOrNextFree & FreeFlag) != 0)
+        {
+            return static_cast<uint32_t>(Capacity);
+        }
+
+        return slotIndex;
+    }
+
+    // Fixed-capacity pool shared by several threads, each allocating and freeing through a Cache of its own
+    // A cache holds a batch of free slots, so the shared free list and its lock are only touched once per batch. Objects
+    // stay in their slots rather than being packed, so other threads can keep using them while the pool changes; there
+    // is no contiguous iteration. Handles are generation checked as with Pool, and any thread may check one while
+    // another frees it: the slot's state is atomic, so the check sees either the live object or a stale handle.
+    // A pointer from Get stays usable only until the object is freed, which the caller has to rule out.
+    template<typename T, size_t Capacity> class SharedPool
+    {
+    public:
+        // Free slots owned by one thread, padded so threads never share a cache line; Flush returns them before the cache goes away
+        class alignas(64) Cache
+        {
+        public:
+            static constexpr uint32_t Size = 64;
+
+            Cache() = default;
+            ~Cache() { assert(mNumSlots == 0); }
+
+            Cache(const Cache&) = delete;
+            Cache& operator=(const Cache&) = delete;
+
+        private:
+            friend class SharedPool;
+
+            uint32_t mSlots[Size];
+            uint32_t mNumSlots = 0;
+        };
+
+        SharedPool();
+        ~SharedPool();
+
+        SharedPool(const SharedPool&) = delete;
+        SharedPool& operator=(const SharedPool&) = delete;
+
+        template<typename... Args> PoolHandle Alloc(Cache& cache, Args&&... args);
+        void Free(Cache& cache, PoolHandle handle);
+        void Flush(Cache& cache);
+
+        T* Get(PoolHandle handle);
+        const T* Get(PoolHandle handle) const;
+        bool IsValid(PoolHandle handle) const { return Get(handle) != nullptr; }
+
+        static constexpr size_t GetCapacity()   { return Capacity; }
+
+    private:
+        static constexpr uint32_t IndexBits = CalcPoolIndexBits(Capacity);
+        static constexpr uint32_t IndexMask = (1u << IndexBits) - 1;
+        static constexpr uint32_t GenerationMask = 0xffffffffu >> IndexBits;
+        static constexpr uint32_t LiveSlot = UINT32_MAX;   // mNextFree of a slot holding an object
+        static_assert(IndexBits <= 24, "Pool capacity leaves too few bits for generations");
+
+        class Slot
+        {
+        public:
+            std::atomic<uint32_t> mNextFree;    // Next slot on the shared free list, LiveSlot while the slot holds an object
+            std::atomic<uint32_t> mGeneration;
+        };
+
+        alignas(T) unsigned char mObjectStorage[sizeof(T) * Capacity];
+        Slot       mSlots[Capacity];
+        std::mutex mMutex;          // Guards the shared free list
+        uint32_t   mFreeSlot;       // Head of the shared free list, Capacity when empty
+
+        T* GetObjects()             { return reinterpret_cast<T*>(mObjectStorage); }
+        const T* GetObjects() const { return reinterpret_cast<const T*>(mObjectStorage); }
+        uint32_t FindSlot(PoolHandle handle) const;
+    };
+
+    template<typename T, size_t Capacity> SharedPool<T, Capacity>::SharedPool()
+    {
+        for (uint32_t i = 0; i < Capacity; i++)
+        {
+            mSlots[i].mNextFree.store(i + 1, std::memory_order_relaxed);
+            mSlots[i].mGeneration.store(1, std::memory_order_relaxed);
+        }
+
+        mFreeSlot = 0;
+    }
+
+    template<typename T, size_t Capacity> SharedPool<T, Capacity>::~SharedPool()
+    {
+        for (uint32_t i = 0; i < Capacity; i++)
+        {
+            if (mSlots[i].mNextFree.load(std::memory_order_relaxed) == LiveSlot)
+            {
+                GetObjects()[i].~T();
+            }
+        }
+    }
+
+    template<typename T, size_t Capacity> template<typename... Args> PoolHandle SharedPool<T, Capacity>::Alloc(Cache& cache, Args&&... args)
+    {
+        // Refill half the cache at once, leaving room for frees before the next trip to the shared list
+        if (cache.mNumSlots == 0)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            while (cache.mNumSlots < Cache::Size / 2 && mFreeSlot != Capacity)
+            {
+                cache.mSlots[cache.mNumSlots++] = mFreeSlot;
+                mFreeSlot = mSlots[mFreeSlot].mNextFree.load(std::memory_order_relaxed);
+            }
+        }
+        if (cache.mNumSlots == 0)
+        {
+            return PoolHandle();
+        }
+
+        uint32_t slotIndex = cache.mSlots[--cache.mNumSlots];
+        Slot& slot = mSlots[slotIndex];
+        new (GetObjects() + slotIndex) T(std::forward<Args>(args)...);
+        // Publishes the constructed object to threads that find the slot live
+        slot.mNextFree.store(LiveSlot, std::memory_order_release);
+
+        return PoolHandle((slot.mGeneration.load(std::memory_order_relaxed) << IndexBits) | slotIndex);
+    }
+
+    template<typename T, size_t Capacity> void SharedPool<T, Capacity>::Free(Cache& cache, PoolHandle handle)
+    {
+        uint32_t slotIndex = FindSlot(handle);
+        assert(slotIndex != Capacity);
+        if (slotIndex == Capacity)
+        {
+            return;
+        }
+
+        Slot& slot = mSlots[slotIndex];
+        // Retire the generation before the object goes, so concurrent checks of the old handle fail from here on
+        uint32_t generation = (slot.mGeneration.load(std::memory_order_relaxed) + 1) & GenerationMask;
+        slot.mGeneration.store(generation != 0 ? generation : 1, std::memory_order_release);
+        slot.mNextFree.store(Capacity, std::memory_order_release);
+        GetObjects()[slotIndex].~T();
+
+        // A full cache gives half its slots back, so alternating allocs and frees stay local
+        if (cache.mNumSlots == Cache::Size)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            while (cache.mNumSlots > Cache::Size / 2)
+            {
+                uint32_t returned = cache.mSlots[--cache.mNumSlots];
+                mSlots[returned].mNextFree.store(mFreeSlot, std::memory_order_relaxed);
+                mFreeSlot = returned;
+            }
+        }
+        cache.mSlots[cache.mNumSlots++] = slotIndex;
+    }
+
+    template<typename T, size_t Capacity> void SharedPool<T, Capacity>::Flush(Cache& cache)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        while (cache.mNumSlots > 0)
+        {
+            uint32_t returned = cache.mSlots[--cache.mNumSlots];
+            mSlots[returned].mNextFree.store(mFreeSlot, std::memory_order_relaxed);
+            mFreeSlot = returned;
+        }
+    }
+
+    template<typename T, size_t Capacity> T* SharedPool<T, Capacity>::Get(PoolHandle handle)
+    {
+        uint32_t slotIndex = FindSlot(handle);
+        return slotIndex != Capacity ? GetObjects() + slotIndex : nullptr;
+    }
+
+    template<typename T, size_t Capacity> const T* SharedPool<T, Capacity>::Get(PoolHandle handle) const
+    {
+        uint32_t slotIndex = FindSlot(handle);
+        return slotIndex != Capacity ? GetObjects() + slotIndex : nullptr;
+    }
+
+    // Returns the slot a handle refers to, or Capacity if the handle is null, stale or was never handed out
+    template<typename T, size_t Capacity> uint32_t SharedPool<T, Capacity>::FindSlot(PoolHandle handle) const
+    {
+        uint32_t slotIndex = handle.GetValue() & IndexMask;
+        uint32_t generation = handle.GetValue() >> IndexBits;
+        if (handle.IsNull() || slotIndex >= Capacity ||
+            mSlots[slotIndex].mNextFree.load(std::memory_order_acquire) != LiveSlot ||
+            mSlots[slotIndex].mGeneration.load(std::memory_order_acquire) != generation)
+        {
+            return static_cast<uint32_t>(Capacity);
+        }
+
+        return slotIndex;
+    }
+
+} // namespace Vnm
@@ -0,0 +1,53 @@
+// Random.h
+
+#pragma once
+
+#include <cstdint>
+
+namespace Snake
+{
+    // PCG32 generator with an explicit seed
+    // Its output sequence is fully specified, unlike std::random_device or the standard distributions, so seeded runs
+    // reproduce bit for bit on every platform. Small enough to copy along with the game state.
+    class Random
+    {
+    public:
+        using result_type = uint32_t;
+
+        explicit Random(uint64_t seed = 0) { Seed(seed); }
+
+        void Seed(uint64_t seed)
+        {
+            mState = 0;
+            Next();
+            mState += seed;
+            Next();
+        }
+
+        uint32_t operator()() { return Next(); }
+
+        // Raw generator state, for saving a game
+        uint64_t GetState() const       { return mState; }
+        void SetState(uint64_t state)   { mState = state; }
+
+        static constexpr uint32_t min() { return 0; }
+        static constexpr uint32_t max() { return UINT32_MAX; }
+
+    private:
+        static constexpr uint64_t Multiplier = 6364136223846793005ull;
+        static constexpr uint64_t Increment = 1442695040888963407ull;
+
+        uint32_t Next()
+        {
+            uint64_t oldState = mState;
+            mState = oldState * Multiplier + Increment;
+
+            uint32_t xorShifted = static_cast<uint32_t>(((oldState >> 18) ^ oldState) >> 27);
+            uint32_t rotation = static_cast<uint32_t>(oldState >> 59);
+            return (xorShifted >> rotation) | (xorShifted << ((32 - rotation) & 31));
+        }
+
+        uint64_t mState;
+    };
+
+} // namespace Snake
@@ -0,0 +1,93 @@
+// RecordingRenderer.cpp
+
+#include "RecordingRenderer.h"
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+namespace Vnm
+{
+    namespace
+    {
+        uint32_t GetBits(float value)
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            return bits;
+        }
+    }
+
+    RecordingRenderer::RecordingRenderer(size_t maxKeptFrames)
+        : mMaxKeptFrames(maxKeptFrames > 0 ? maxKeptFrames : 1)
+    {
+    }
+
+    void RecordingRenderer::BeginFrame(const float view[16])
+    {
+        assert(!mInFrame);
+        mInFrame = true;
+
+        // Recycle the oldest kept frame, so steady recording stops allocating once vectors have grown
+        if (mFrames.size() >= mMaxKeptFrames)
+        {
+            mCurrent = std::move(mFrames.front());
+            mFrames.pop_front();
+        }
+
+        memcpy(mCurrent.mView, view, sizeof(mCurrent.mView));
+        mCurrent.mInstances.clear();
+        mCurrent.mDrawSizes.clear();
+    }
+
+    void RecordingRenderer::SubmitInstances(const Snake::RenderInstance* instances, size_t numInstances)
+    {
+        assert(mInFrame);
+        mCurrent.mInstances.insert(mCurrent.mInstances.end(), instances, instances + numInstances);
+        mCurrent.mDrawSizes.push_back(numInstances);
+    }
+
+    void RecordingRenderer::EndFrame()
+    {
+        assert(mInFrame);
+        mInFrame = false;
+
+        // Field by field, so struct padding never reaches the hash
+        for (float value : mCurrent.mView)
+        {
+            HashValue(GetBits(value));
+        }
+        for (size_t drawSize : mCurrent.mDrawSizes)
+        {
+            HashValue(drawSize);
+        }
+        for (const Snake::RenderInstance& instance : mCurrent.mInstances)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                HashValue((static_cast<uint64_t>(GetBits(instance.mCenter[axis])) << 32) | GetBits(instance.mExtent[axis]));
+            }
+            HashValue(static_cast<uint64_t>(instance.mColor));
+        }
+
+        mNumFrames++;
+        mNumInstances += mCurrent.mInstances.size();
+        mFrames.push_back(std::move(mCurrent));
+        mCurrent = RecordedFrame();
+    }
+
+    void RecordingRenderer::Clear()
+    {
+        assert(!mInFrame);
+        mFrames.clear();
+        mNumFrames = 0;
+        mNumInstances = 0;
+        mHash = 0;
+    }
+
+    void RecordingRenderer::HashValue(uint64_t value)
+    {
+        // Order dependent: a multiply by an odd constant after every value
+        mHash = (mHash ^ value) * 0x9e3779b97f4a7c15ull;
+        mHash ^= mHash >> 29;
+    }
+}
@@ -0,0 +1,50 @@
+// RecordingRenderer.h
+
+#pragma once
+
+#include "Renderer.h"
+#include <deque>
+#include <vector>
+
+namespace Vnm
+{
+    class RecordedFrame
+    {
+    public:
+        float                               mView[16];
+        std::vector<Snake::RenderInstance>  mInstances;     // Every submission's instances, in order
+        std::vector<size_t>                 mDrawSizes;     // Instance count of each SubmitInstances call
+    };
+
+    // Captures frames for tests and benchmarks without a GPU
+    // Only the latest frames are kept, reusing the oldest one's memory, but the hash covers every frame ever ended, so
+    // long runs can be compared against a known value without holding them in memory
+    class RecordingRenderer : public IRenderer
+    {
+    public:
+        explicit RecordingRenderer(size_t maxKeptFrames = 1);
+
+        void BeginFrame(const float view[16]) override;
+        void SubmitInstances(const Snake::RenderInstance* instances, size_t numInstances) override;
+        void EndFrame() override;
+
+        // Oldest first; the frame in progress is not included until EndFrame
+        const std::deque<RecordedFrame>& GetFrames() const  { return mFrames; }
+        uint64_t GetNumFrames() const                       { return mNumFrames; }
+        uint64_t GetNumInstances() const                    { return mNumInstances; }
+        uint64_t GetHash() const                            { return mHash; }
+
+        void Clear();
+
+    private:
+        void HashValue(uint64_t value);
+
+        size_t                    mMaxKeptFrames;
+        std::deque<RecordedFrame> mFrames;
+        RecordedFrame             mCurrent;
+        bool                      mInFrame = false;
+        uint64_t                  mNumFrames = 0;
+        uint64_t                  mNumInstances = 0;
+        uint64_t                  mHash = 0;
+    };
+}
@@ -0,0 +1,114 @@
+// RenderFrame.cpp
+
+#include "RenderFrame.h"
+#include <algorithm>
+
+namespace Snake
+{
+    size_t CalcMaxRenderInstances(const BoardLayout& layout)
+    {
+        return NumWallFaces + layout.GetNumInteriorCells();
+    }
+
+    void BuildRenderInstances(const GameBoard& board, std::vector<RenderInstance>& instancesOut)
+    {
+        instancesOut.clear();
+
+        float origin[3];
+        float blockSize[3];
+        board.GetPosition(0, 0, 0, origin);
+        board.GetPosition(1, 1, 1, blockSize);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            blockSize[axis] -= origin[axis];
+        }
+
+        // Walls are implicit on the board, draw each face as one stretched cube
+        for (int face = 0; face < NumWallFaces; face++)
+        {
+            int minBlock[3];
+            int maxBlock[3];
+            board.GetLayout().GetWallFace(face, minBlock, maxBlock);
+
+            float minPosition[3];
+            float maxPosition[3];
+            board.GetPosition(minBlock[0], minBlock[1], minBlock[2], minPosition);
+            board.GetPosition(maxBlock[0], maxBlock[1], maxBlock[2], maxPosition);
+
+            // Cube mesh is one block wide and centered on the block position
+            RenderInstance instance;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                instance.mCenter[axis] = 0.5f * (minPosition[axis] + maxPosition[axis]);
+                instance.mExtent[axis] = maxPosition[axis] - minPosition[axis] + blockSize[axis];
+            }
+            instance.mColor = static_cast<PieceColor>(static_cast<int>(PieceColor::WallXmin) + face);
+            instancesOut.push_back(instance);
+        }
+
+        size_t numOccupiedCells;
+        const OccupiedCell* occupiedCells = board.GetOccupiedCells(&numOccupiedCells);
+        for (size_t i = 0; i < numOccupiedCells; i++)
+        {
+            int xBlock;
+            int yBlock;
+            int zBlock;
+            board.GetCellCoords(occupiedCells[i].mCellIndex, xBlock, yBlock, zBlock);
+
+            RenderInstance instance;
+            board.GetPosition(xBlock, yBlock, zBlock, instance.mCenter);
+            for (int axis = 0; axis < 3; axis++)
+            {
+                instance.mExtent[axis] = blockSize[axis];
+            }
+            instance.mColor = occupiedCells[i].mColor;
+            instancesOut.push_back(instance);
+        }
+    }
+
+    void InputLatencyMeter::OnPresent(const RenderFrame& frame, std::chrono::steady_clock::time_point presentTime)
+    {
+        const InputTimes& inputs = frame.mInputs;
+        if (inputs.GetFirstHeld() > mNumSeen)
+        {
+            mNumMissed += inputs.GetFirstHeld() - mNumSeen;
+            mNumSeen = inputs.GetFirstHeld();
+        }
+
+        for (; mNumSeen < inputs.GetCount(); mNumSeen++)
+        {
+            Add(presentTime - inputs.Get(mNumSeen));
+        }
+    }
+
+    void InputLatencyMeter::Add(std::chrono::steady_clock::duration latency)
+    {
+        double milliseconds = std::chrono::duration<double, std::milli>(latency).count();
+        size_t bucket = milliseconds > 0.0 ? static_cast<size_t>(milliseconds / BucketMilliseconds) : 0;
+        mBuckets[std::min(bucket, NumBuckets)]++;
+        mCount++;
+        mSumMilliseconds += milliseconds;
+        mMaxMilliseconds = std::max(mMaxMilliseconds, milliseconds);
+    }
+
+    double InputLatencyMeter::GetMeanMilliseconds() const
+    {
+        return mCount > 0 ? mSumMilliseconds / static_cast<double>(mCount) : 0.0;
+    }
+
+    double InputLatencyMeter::GetPercentileMilliseconds(double fraction) const
+    {
+        uint64_t target = static_cast<uint64_t>(fraction * static_cast<double>(mCount));
+        uint64_t numBelow = 0;
+        for (size_t bucket = 0; bucket < NumBuckets; bucket++)
+        {
+            numBelow += mBuckets[bucket];
+            if (numBelow > target)
+            {
+                return static_cast<double>(bucket + 1) * BucketMilliseconds;
+            }
+        }
+        return mMaxMilliseconds;
+    }
+
+} // namespace Snake
@@ -0,0 +1,120 @@
+// RenderFrame.h
+
+#pragma once
+
+#include "Snake3D.h"
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+namespace Snake
+{
+    // One stretched cube
+    class RenderInstance
+    {
+    public:
+        float      mCenter[3];
+        float      mExtent[3];
+        PieceColor mColor;
+    };
+
+    // Arrival times of the latest inputs a game has consumed, numbered from zero in consumption order
+    class InputTimes
+    {
+    public:
+        static constexpr uint64_t Capacity = 8;
+
+        void Add(std::chrono::steady_clock::time_point time)
+        {
+            mTimes[mCount % Capacity] = time;
+            mCount++;
+        }
+
+        uint64_t GetCount() const           { return mCount; }
+        uint64_t GetFirstHeld() const       { return mCount > Capacity ? mCount - Capacity : 0; }
+        std::chrono::steady_clock::time_point Get(uint64_t input) const
+        {
+            assert(input >= GetFirstHeld() && input < mCount);
+            return mTimes[input % Capacity];
+        }
+
+    private:
+        std::chrono::steady_clock::time_point mTimes[Capacity];
+        uint64_t mCount = 0;
+    };
+
+    // Arrival time of the earliest input the game has yet to consume, handed from the thread receiving inputs to the one
+    // running the game
+    class PendingInputTime
+    {
+    public:
+        void Mark(std::chrono::steady_clock::time_point time)
+        {
+            // Zero means none pending; keep the earliest of several inputs arriving between updates
+            std::chrono::steady_clock::rep expected = 0;
+            mTime.compare_exchange_strong(expected, time.time_since_epoch().count(), std::memory_order_relaxed);
+        }
+
+        bool Take(std::chrono::steady_clock::time_point& timeOut)
+        {
+            std::chrono::steady_clock::rep time = mTime.exchange(0, std::memory_order_relaxed);
+            timeOut = std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(time));
+            return time != 0;
+        }
+
+    private:
+        std::atomic<std::chrono::steady_clock::rep> mTime{ 0 };
+    };
+
+    // Everything the renderer needs from one simulation update, built on the simulation thread and never changed once
+    // published
+    class RenderFrame
+    {
+    public:
+        explicit RenderFrame(size_t maxInstances = 0) { mInstances.reserve(maxInstances); }
+
+        std::vector<RenderInstance> mInstances;     // Capacity reserved up front, so rebuilding a frame never allocates
+        float       mView[16] = { 1.0f, 0.0f, 0.0f, 0.0f,   // Row-major world to view transform
+                                  0.0f, 1.0f, 0.0f, 0.0f,
+                                  0.0f, 0.0f, 1.0f, 0.0f,
+                                  0.0f, 0.0f, 0.0f, 1.0f };
+        uint64_t    mFrameNumber = 0;               // Counts publishes, so a repeated frame can be told from a new one
+        uint64_t    mStepCount = 0;
+        InputTimes  mInputs;                        // Latest inputs the game had consumed when the frame was built
+    };
+
+    // Instances a board of this layout can need: the six wall faces plus every interior cell
+    size_t CalcMaxRenderInstances(const BoardLayout& layout);
+
+    // Walls as one instance per face, then one instance per occupied cell
+    void BuildRenderInstances(const GameBoard& board, std::vector<RenderInstance>& instancesOut);
+
+    // Times inputs from arrival until the first presented frame that shows them
+    // Latencies go into 0.1 ms buckets, so percentiles come without keeping samples
+    class InputLatencyMeter
+    {
+    public:
+        static constexpr size_t NumBuckets = 2000;
+        static constexpr double BucketMilliseconds = 0.1;
+
+        // Call right after presenting a frame
+        void OnPresent(const RenderFrame& frame, std::chrono::steady_clock::time_point presentTime);
+        void Add(std::chrono::steady_clock::duration latency);
+
+        uint64_t GetCount() const           { return mCount; }
+        uint64_t GetNumMissed() const       { return mNumMissed; }  // Inputs that scrolled out of InputTimes between presents
+        double GetMeanMilliseconds() const;
+        double GetMaxMilliseconds() const   { return mMaxMilliseconds; }
+        // Upper edge of the bucket holding the given fraction of samples
+        double GetPercentileMilliseconds(double fraction) const;
+
+    private:
+        uint32_t mBuckets[NumBuckets + 1] = {};     // Last bucket holds everything slower
+        uint64_t mCount = 0;
+        uint64_t mNumSeen = 0;
+        uint64_t mNumMissed = 0;
+        double   mSumMilliseconds = 0.0;
+        double   mMaxMilliseconds = 0.0;
+    };
+
+} // namespace Snake
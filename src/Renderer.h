@@ -0,0 +1,40 @@
+// Renderer.h
+
+#pragma once
+
+#include "RenderFrame.h"
+
+namespace Vnm
+{
+    // Rendering backend
+    // A frame is BeginFrame, any number of SubmitInstances calls, then EndFrame, all on the thread that owns the renderer
+    class IRenderer
+    {
+    public:
+        virtual ~IRenderer() = default;
+
+        // Starts a frame seen through a row-major world to view transform
+        virtual void BeginFrame(const float view[16]) = 0;
+        // Adds instances to the frame; they are only read during the call
+        virtual void SubmitInstances(const Snake::RenderInstance* instances, size_t numInstances) = 0;
+        // Finishes the frame and presents it
+        virtual void EndFrame() = 0;
+    };
+
+    // Draws nothing, so timing a loop that renders through it measures only simulation and frame preparation
+    class NullRenderer : public IRenderer
+    {
+    public:
+        void BeginFrame(const float[16]) override {}
+        void SubmitInstances(const Snake::RenderInstance*, size_t) override {}
+        void EndFrame() override {}
+    };
+
+    // Draws a published frame as one submission
+    inline void DrawFrame(IRenderer& renderer, const Snake::RenderFrame& frame)
+    {
+        renderer.BeginFrame(frame.mView);
+        renderer.SubmitInstances(frame.mInstances.data(), frame.mInstances.size());
+        renderer.EndFrame();
+    }
+}
@@ -0,0 +1,524 @@
+// Replay.cpp
+
+#include "Replay.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Snake
+{
+    namespace
+    {
+        const char ReplayMagic[4] = { 'S', '3', 'D', 'R' };
+        const char IndexMagic[4] = { 'S', '3', 'D', 'I' };
+
+        // Record varints below 16 would be runs of no ticks, so two of them serve as markers
+        constexpr uint64_t EndMarker = 0;
+        constexpr uint64_t KeyframeMarker = 1;
+
+        constexpr size_t HeaderSize = 40;
+        constexpr size_t TrailerSize = 20;
+        constexpr size_t IndexEntrySize = 16;
+        constexpr size_t FooterSize = 12;
+
+        FILE* OpenFile(const char* path, const char* mode)
+        {
+#if defined(_MSC_VER)
+            FILE* file = nullptr;
+            return fopen_s(&file, path, mode) == 0 ? file : nullptr;
+#else
+            return fopen(path, mode);
+#endif
+        }
+
+        uint64_t LoadFixed(const uint8_t* data, int numBytes)
+        {
+            uint64_t value = 0;
+            for (int i = 0; i < numBytes; i++)
+            {
+                value |= static_cast<uint64_t>(data[i]) << (8 * i);
+            }
+            return value;
+        }
+    }
+
+    ReplayWriter::~ReplayWriter()
+    {
+        Abandon();
+    }
+
+    bool ReplayWriter::Open(const char* path, uint64_t seed, const BoardLayout& layout, uint32_t keyframeInterval)
+    {
+        Abandon();
+
+        mFile = OpenFile(path, "wb");
+        if (mFile == nullptr)
+        {
+            return false;
+        }
+
+        mBufferUsed = 0;
+        mNumBytesFlushed = 0;
+        mRunInputs = 0;
+        mRunLength = 0;
+        mNumTicks = 0;
+        mKeyframeInterval = keyframeInterval > 0 ? keyframeInterval : DefaultKeyframeInterval;
+        mFailed = false;
+        mKeyframes.clear();
+
+        WriteBytes(reinterpret_cast<const uint8_t*>(ReplayMagic), sizeof(ReplayMagic));
+        WriteFixed(ReplayHeader::Version, 4);
+        WriteFixed(seed, 8);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            WriteFixed(layout.GetNumPieces(axis), 4);
+        }
+        WriteFixed(Simulation::StepsPerSecond, 4);
+        WriteFixed(Simulation::UnitsPerBlock, 4);
+        WriteFixed(mKeyframeInterval, 4);
+        return true;
+    }
+
+    void ReplayWriter::RecordTick(const Simulation& simulation, uint32_t inputs)
+    {
+        assert(IsOpen());
+        assert(inputs < 16);
+
+        // Runs end at keyframes, so reading can start right after one
+        if (mNumTicks > 0 && mNumTicks % mKeyframeInterval == 0)
+        {
+            if (mRunLength > 0)
+            {
+                FlushRun();
+            }
+            WriteKeyframe(simulation);
+        }
+        else if (inputs != mRunInputs && mRunLength > 0)
+        {
+            FlushRun();
+        }
+
+        mRunInputs = inputs;
+        mRunLength++;
+        mNumTicks++;
+    }
+
+    void ReplayWriter::FlushRun()
+    {
+        WriteVarint((mRunLength << 4) | mRunInputs);
+        mRunLength = 0;
+    }
+
+    void ReplayWriter::WriteKeyframe(const Simulation& simulation)
+    {
+        simulation.SaveKeyframe(mKeyframeData);
+
+        mKeyframes.push_back({ mNumTicks, mNumBytesFlushed + mBufferUsed });
+        WriteVarint(KeyframeMarker);
+        WriteVarint(mNumTicks);
+        WriteVarint(mKeyframeData.size());
+        WriteBytes(mKeyframeData.data(), mKeyframeData.size());
+    }
+
+    void ReplayWriter::Flush()
+    {
+        if (mFile == nullptr)
+        {
+            return;
+        }
+
+        if (mBufferUsed > 0)
+        {
+            mFailed |= fwrite(mBuffer, 1, mBufferUsed, mFile) != mBufferUsed;
+            mNumBytesFlushed += mBufferUsed;
+            mBufferUsed = 0;
+        }
+        mFailed |= fflush(mFile) != 0;
+    }
+
+    bool ReplayWriter::Close(const Simulation& simulation)
+    {
+        if (mFile == nullptr)
+        {
+            return false;
+        }
+
+        if (mRunLength > 0)
+        {
+            FlushRun();
+        }
+        WriteVarint(EndMarker);
+
+        uint64_t trailerOffset = mNumBytesFlushed + mBufferUsed;
+        WriteFixed(mNumTicks, 8);
+        WriteFixed(simulation.GetHash(), 8);
+        WriteFixed(mKeyframes.size(), 4);
+        for (const ReplayKeyframe& keyframe : mKeyframes)
+        {
+            WriteFixed(keyframe.mTick, 8);
+            WriteFixed(keyframe.mOffset, 8);
+        }
+        WriteFixed(trailerOffset, 8);
+        WriteBytes(reinterpret_cast<const uint8_t*>(IndexMagic), sizeof(IndexMagic));
+
+        Flush();
+        mFailed |= fclose(mFile) != 0;
+        mFile = nullptr;
+        return !mFailed;
+    }
+
+    void ReplayWriter::Abandon()
+    {
+        // Records stay unterminated, so readers see a replay that was cut short
+        if (mFile != nullptr)
+        {
+            Flush();
+            fclose(mFile);
+            mFile = nullptr;
+        }
+    }
+
+    void ReplayWriter::WriteByte(uint8_t value)
+    {
+        if (mBufferUsed == BufferSize)
+        {
+            mFailed |= fwrite(mBuffer, 1, mBufferUsed, mFile) != mBufferUsed;
+            mNumBytesFlushed += mBufferUsed;
+            mBufferUsed = 0;
+        }
+        mBuffer[mBufferUsed++] = value;
+    }
+
+    void ReplayWriter::WriteBytes(const uint8_t* data, size_t size)
+    {
+        while (size > 0)
+        {
+            if (mBufferUsed == BufferSize)
+            {
+                mFailed |= fwrite(mBuffer, 1, mBufferUsed, mFile) != mBufferUsed;
+                mNumBytesFlushed += mBufferUsed;
+                mBufferUsed = 0;
+            }
+
+            size_t numBytes = std::min(size, BufferSize - mBufferUsed);
+            memcpy(mBuffer + mBufferUsed, data, numBytes);
+            mBufferUsed += numBytes;
+            data += numBytes;
+            size -= numBytes;
+        }
+    }
+
+    void ReplayWriter::WriteVarint(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            WriteByte(static_cast<uint8_t>(value) | 0x80);
+            value >>= 7;
+        }
+        WriteByte(static_cast<uint8_t>(value));
+    }
+
+    void ReplayWriter::WriteFixed(uint64_t value, int numBytes)
+    {
+        for (int i = 0; i < numBytes; i++)
+        {
+            WriteByte(static_cast<uint8_t>(value >> (8 * i)));
+        }
+    }
+
+    bool ReplayReader::Open(const char* path)
+    {
+        mRunRemaining = 0;
+        mTick = 0;
+        mEnded = false;
+        mHasTrailer = false;
+        mKeyframes.clear();
+
+        if (!mFile.Open(path) || mFile.GetSize() < HeaderSize || memcmp(mFile.GetData(), ReplayMagic, sizeof(ReplayMagic)) != 0)
+        {
+            mFile.Close();
+            return false;
+        }
+
+        const uint8_t* header = mFile.GetData();
+        mHeader.mSeed = LoadFixed(header + 8, 8);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            mHeader.mNumPieces[axis] = static_cast<uint32_t>(LoadFixed(header + 16 + 4 * axis, 4));
+        }
+        mHeader.mKeyframeInterval = static_cast<uint32_t>(LoadFixed(header + 36, 4));
+
+        // Cell indices are 32-bit, so the board must have at most UINT32_MAX cells; checked an axis at a time so the
+        // product cannot wrap
+        bool validLayout = true;
+        uint64_t numCells = 1;
+        for (int axis = 0; validLayout && axis < 3; axis++)
+        {
+            validLayout = mHeader.mNumPieces[axis] >= 3 && mHeader.mNumPieces[axis] <= UINT32_MAX / numCells;
+            numCells *= mHeader.mNumPieces[axis];
+        }
+
+        // Replays only reproduce under the rules they were recorded with
+        if (LoadFixed(header + 4, 4) != ReplayHeader::Version || !validLayout ||
+            LoadFixed(header + 28, 4) != Simulation::StepsPerSecond ||
+            LoadFixed(header + 32, 4) != Simulation::UnitsPerBlock)
+        {
+            mFile.Close();
+            return false;
+        }
+
+        mRecordsBegin = HeaderSize;
+        mRecordsEnd = mFile.GetSize();
+        if (!ReadTrailer())
+        {
+            ScanKeyframes();
+        }
+
+        mRead = mRecordsBegin;
+        return true;
+    }
+
+    bool ReplayReader::ReadTrailer()
+    {
+        const uint8_t* data = mFile.GetData();
+        const size_t size = mFile.GetSize();
+        if (size < HeaderSize + 1 + TrailerSize + FooterSize ||
+            memcmp(data + size - sizeof(IndexMagic), IndexMagic, sizeof(IndexMagic)) != 0)
+        {
+            return false;
+        }
+
+        uint64_t trailerOffset = LoadFixed(data + size - FooterSize, 8);
+        if (trailerOffset <= HeaderSize || trailerOffset > size - FooterSize - TrailerSize)
+        {
+            return false;
+        }
+
+        const uint8_t* trailer = data + trailerOffset;
+        uint64_t numKeyframes = LoadFixed(trailer + 16, 4);
+        if (numKeyframes * IndexEntrySize != size - FooterSize - TrailerSize - trailerOffset)
+        {
+            return false;
+        }
+
+        for (uint64_t i = 0; i < numKeyframes; i++)
+        {
+            const uint8_t* entry = trailer + TrailerSize + i * IndexEntrySize;
+            ReplayKeyframe keyframe = { LoadFixed(entry, 8), LoadFixed(entry + 8, 8) };
+            if (keyframe.mOffset < HeaderSize || keyframe.mOffset >= trailerOffset ||
+                (!mKeyframes.empty() && keyframe.mTick <= mKeyframes.back().mTick))
+            {
+                mKeyframes.clear();
+                return false;
+            }
+            mKeyframes.push_back(keyframe);
+        }
+
+        mRecordsEnd = static_cast<size_t>(trailerOffset);
+        mTrailerNumTicks = LoadFixed(trailer, 8);
+        mTrailerHash = LoadFixed(trailer + 8, 8);
+        mHasTrailer = true;
+        return true;
+    }
+
+    void ReplayReader::ScanKeyframes()
+    {
+        // One pass over the records, which are a tiny fraction of a byte per tick, in place of the missing index
+        mRead = mRecordsBegin;
+        uint64_t tick = 0;
+        for (;;)
+        {
+            size_t offset = mRead;
+            uint64_t record;
+            if (!ReadVarint(record) || record == EndMarker)
+            {
+                break;
+            }
+
+            if (record == KeyframeMarker)
+            {
+                uint64_t keyframeTick;
+                const uint8_t* data;
+                size_t size;
+                if (!ReadKeyframe(keyframeTick, data, size) || keyframeTick != tick)
+                {
+                    break;
+                }
+                mKeyframes.push_back({ tick, offset });
+            }
+            else if ((record >> 4) == 0)
+            {
+                break;
+            }
+            else
+            {
+                tick += record >> 4;
+            }
+        }
+    }
+
+    bool ReplayReader::NextTick(uint32_t& inputsOut)
+    {
+        while (mRunRemaining == 0)
+        {
+            uint64_t record;
+            if (mEnded || !ReadVarint(record) || record == EndMarker)
+            {
+                mEnded = true;
+                return false;
+            }
+
+            if (record == KeyframeMarker)
+            {
+                uint64_t keyframeTick;
+                const uint8_t* data;
+                size_t size;
+                if (!ReadKeyframe(keyframeTick, data, size))
+                {
+                    mEnded = true;
+                    return false;
+                }
+                continue;
+            }
+
+            mRunInputs = static_cast<uint32_t>(record & 15);
+            mRunRemaining = record >> 4;
+            if (mRunRemaining == 0)
+            {
+                mEnded = true;
+                return false;
+            }
+        }
+
+        mRunRemaining--;
+        mTick++;
+        inputsOut = mRunInputs;
+        return true;
+    }
+
+    bool ReplayReader::Seek(uint64_t tick, Simulation& simulation)
+    {
+        if (!mFile.IsOpen() || !(simulation.GetBoard().GetLayout() == mHeader.GetLayout()))
+        {
+            return false;
+        }
+
+        mRunRemaining = 0;
+        mEnded = false;
+
+        std::vector<ReplayKeyframe>::const_iterator keyframe = std::upper_bound(mKeyframes.begin(), mKeyframes.end(), tick,
+            [](uint64_t value, const ReplayKeyframe& entry) { return value < entry.mTick; });
+        if (keyframe != mKeyframes.begin())
+        {
+            --keyframe;
+            mRead = static_cast<size_t>(keyframe->mOffset);
+
+            uint64_t marker;
+            uint64_t keyframeTick;
+            const uint8_t* data;
+            size_t size;
+            if (!ReadVarint(marker) || marker != KeyframeMarker || !ReadKeyframe(keyframeTick, data, size) ||
+                keyframeTick != keyframe->mTick || !simulation.LoadKeyframe(data, size))
+            {
+                mEnded = true;
+                return false;
+            }
+            mTick = keyframeTick;
+        }
+        else
+        {
+            simulation.Reset(mHeader.mSeed);
+            mRead = mRecordsBegin;
+            mTick = 0;
+        }
+
+        while (mTick < tick)
+        {
+            uint32_t inputs;
+            if (simulation.IsOver() || !NextTick(inputs))
+            {
+                return false;
+            }
+            simulation.Step(inputs);
+        }
+        return true;
+    }
+
+    bool ReplayReader::ReadByte(uint8_t& valueOut)
+    {
+        if (mRead >= mRecordsEnd)
+        {
+            return false;
+        }
+
+        valueOut = mFile.GetData()[mRead++];
+        return true;
+    }
+
+    bool ReplayReader::ReadVarint(uint64_t& valueOut)
+    {
+        valueOut = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            uint8_t value;
+            if (!ReadByte(value))
+            {
+                return false;
+            }
+
+            valueOut |= static_cast<uint64_t>(value & 0x7f) << shift;
+            if ((value & 0x80) == 0)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Reads a keyframe after its marker; the data points into the mapped file
+    bool ReplayReader::ReadKeyframe(uint64_t& tickOut, const uint8_t*& dataOut, size_t& sizeOut)
+    {
+        uint64_t size;
+        if (!ReadVarint(tickOut) || !ReadVarint(size) || size > mRecordsEnd - mRead)
+        {
+            return false;
+        }
+
+        dataOut = mFile.GetData() + mRead;
+        sizeOut = static_cast<size_t>(size);
+        mRead += sizeOut;
+        return true;
+    }
+
+    bool VerifyReplay(const char* path, ReplayVerification& resultOut)
+    {
+        ReplayReader reader;
+        if (!reader.Open(path))
+        {
+            return false;
+        }
+
+        Simulation simulation(reader.GetHeader().mSeed, reader.GetHeader().GetLayout());
+
+        resultOut = ReplayVerification();
+        bool overran = false;
+        uint32_t inputs;
+        while (reader.NextTick(inputs))
+        {
+            // Ticks past the end of the game mean the replay diverged
+            if (simulation.IsOver())
+            {
+                overran = true;
+                break;
+            }
+
+            simulation.Step(inputs);
+            resultOut.mNumTicks++;
+        }
+
+        resultOut.mHasTrailer = reader.HasTrailer();
+        resultOut.mMatches = !overran && reader.HasTrailer() &&
+            reader.GetNumTicks() == resultOut.mNumTicks && reader.GetFinalHash() == simulation.GetHash();
+        return true;
+    }
+
+} // namespace Snake
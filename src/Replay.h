@@ -0,0 +1,159 @@
+// Replay.h
+
+#pragma once
+
+#include "MappedFile.h"
+#include "Simulation.h"
+#include <cstdio>
+#include <vector>
+
+namespace Snake
+{
+    // Replay file layout, all integers little endian:
+    //   header    "S3DR", u32 version, u64 seed, u32 board size per axis, u32 steps per second, u32 units per block,
+    //             u32 keyframe interval
+    //   records   varints: (runLength << 4 | inputs) for a run of ticks with the same inputs, KeyframeMarker followed by
+    //             a keyframe, or EndMarker after the last tick
+    //   keyframe  varint tick, varint size, Simulation::SaveKeyframe data of the game just before that tick
+    //   trailer   u64 tick count, u64 Simulation::GetHash after the last tick, u32 keyframe count, then per keyframe u64
+    //             tick and u64 file offset of its marker
+    //   footer    u64 file offset of the trailer, "S3DI"
+    // The game is a fresh Simulation with the header's seed and board stepped once per tick, so ticks store only inputs.
+    // Most ticks carry no input, so typical play costs a few bytes per turn and well under a byte per tick.
+    class ReplayHeader
+    {
+    public:
+        static constexpr uint32_t Version = 2;
+
+        uint64_t mSeed = 0;
+        uint32_t mNumPieces[3] = {};
+        uint32_t mKeyframeInterval = 0;
+
+        BoardLayout GetLayout() const { return BoardLayout(mNumPieces[0], mNumPieces[1], mNumPieces[2]); }
+    };
+
+    // Seek index entry
+    class ReplayKeyframe
+    {
+    public:
+        uint64_t mTick;
+        uint64_t mOffset;       // File offset of the keyframe's marker
+    };
+
+    // Streams a replay to a file as the game is played, with a fixed-size buffer whatever the game length
+    class ReplayWriter
+    {
+    public:
+        static constexpr uint32_t DefaultKeyframeInterval = 1 << 16;   // About 18 minutes of play; seeks replay at most this many ticks
+
+        ReplayWriter() = default;
+        ~ReplayWriter();
+
+        ReplayWriter(const ReplayWriter&) = delete;
+        ReplayWriter& operator=(const ReplayWriter&) = delete;
+
+        // Starts a replay of a game about to be played from Simulation(seed, layout); closes any open one unfinished
+        bool Open(const char* path, uint64_t seed, const BoardLayout& layout, uint32_t keyframeInterval = DefaultKeyframeInterval);
+        bool IsOpen() const { return mFile != nullptr; }
+
+        // Inputs passed to one Simulation::Step, given the game just before that step
+        void RecordTick(const Simulation& simulation, uint32_t inputs);
+
+        // Hands buffered bytes to the OS, so a crash loses nothing recorded before the call
+        void Flush();
+
+        // Ends the replay with the state after the last recorded tick, which playback checks against, and the seek index
+        bool Close(const Simulation& simulation);
+
+        uint64_t GetNumTicks() const { return mNumTicks; }
+
+    private:
+        void FlushRun();
+        void WriteKeyframe(const Simulation& simulation);
+        void WriteByte(uint8_t value);
+        void WriteBytes(const uint8_t* data, size_t size);
+        void WriteVarint(uint64_t value);
+        void WriteFixed(uint64_t value, int numBytes);
+        void Abandon();
+
+        static constexpr size_t BufferSize = 4096;
+
+        FILE*    mFile = nullptr;
+        uint8_t  mBuffer[BufferSize];
+        size_t   mBufferUsed = 0;
+        uint64_t mNumBytesFlushed = 0;
+        uint32_t mRunInputs = 0;
+        uint64_t mRunLength = 0;
+        uint64_t mNumTicks = 0;
+        uint32_t mKeyframeInterval = DefaultKeyframeInterval;
+        bool     mFailed = false;
+
+        std::vector<uint8_t>        mKeyframeData;  // Scratch space reused by every keyframe
+        std::vector<ReplayKeyframe> mKeyframes;     // Sixteen bytes per keyframe interval, written out by Close
+    };
+
+    // Reads a memory-mapped replay, tick by tick or by seeking straight to any tick
+    class ReplayReader
+    {
+    public:
+        ReplayReader() = default;
+        ~ReplayReader() = default;
+
+        ReplayReader(const ReplayReader&) = delete;
+        ReplayReader& operator=(const ReplayReader&) = delete;
+
+        // Maps the file and checks the header, failing on other files, versions or rule constants, then loads the seek
+        // index; a replay cut off by a crash has none, so its records are scanned for keyframes instead
+        bool Open(const char* path);
+        const ReplayHeader& GetHeader() const { return mHeader; }
+
+        // Inputs of the next tick; false after the last one, or early if the file is cut short or corrupt
+        bool NextTick(uint32_t& inputsOut);
+        // Ticks read or sought past so far
+        uint64_t GetTick() const { return mTick; }
+
+        // Puts a Simulation with the header's board into the state just before the given tick, by loading the latest
+        // keyframe at or before it and replaying the rest; NextTick carries on from there. False if the replay does not
+        // reach that tick.
+        bool Seek(uint64_t tick, Simulation& simulation);
+        const std::vector<ReplayKeyframe>& GetKeyframes() const { return mKeyframes; }
+
+        // Whether the replay was closed properly; a replay cut off by a crash has no trailer
+        bool HasTrailer() const         { return mHasTrailer; }
+        uint64_t GetNumTicks() const    { return mTrailerNumTicks; }
+        uint64_t GetFinalHash() const   { return mTrailerHash; }
+
+    private:
+        bool ReadByte(uint8_t& valueOut);
+        bool ReadVarint(uint64_t& valueOut);
+        bool ReadKeyframe(uint64_t& tickOut, const uint8_t*& dataOut, size_t& sizeOut);
+        bool ReadTrailer();
+        void ScanKeyframes();
+
+        Vnm::MappedFile mFile;
+        size_t          mRead = 0;
+        size_t          mRecordsBegin = 0;
+        size_t          mRecordsEnd = 0;        // Trailer offset, or the file size if there is none
+        ReplayHeader    mHeader;
+        uint32_t        mRunInputs = 0;
+        uint64_t        mRunRemaining = 0;
+        uint64_t        mTick = 0;
+        bool            mEnded = false;
+        bool            mHasTrailer = false;
+        uint64_t        mTrailerNumTicks = 0;
+        uint64_t        mTrailerHash = 0;
+        std::vector<ReplayKeyframe> mKeyframes;
+    };
+
+    class ReplayVerification
+    {
+    public:
+        uint64_t mNumTicks = 0;
+        bool     mHasTrailer = false;
+        bool     mMatches = false;      // Tick count and final hash agree with the trailer
+    };
+
+    // Re-runs a replay headless as fast as possible; false if the file cannot be read
+    bool VerifyReplay(const char* path, ReplayVerification& resultOut);
+
+} // namespace Snake
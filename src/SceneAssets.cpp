@@ -0,0 +1,164 @@
+// SceneAssets.cpp
+
+#include "SceneAssets.h"
+#include <cmath>
+
+namespace Vnm
+{
+    namespace
+    {
+        constexpr float CubeScale = 0.5f;
+
+        void Normalize(float vector[3])
+        {
+            float length = std::sqrt(vector[0] * vector[0] + vector[1] * vector[1] + vector[2] * vector[2]);
+            for (int i = 0; i < 3; i++)
+            {
+                vector[i] /= length;
+            }
+        }
+
+        void Cross(const float lhs[3], const float rhs[3], float crossOut[3])
+        {
+            crossOut[0] = lhs[1] * rhs[2] - lhs[2] * rhs[1];
+            crossOut[1] = lhs[2] * rhs[0] - lhs[0] * rhs[2];
+            crossOut[2] = lhs[0] * rhs[1] - lhs[1] * rhs[0];
+        }
+
+        float Dot(const float lhs[3], const float rhs[3])
+        {
+            return lhs[0] * rhs[0] + lhs[1] * rhs[1] + lhs[2] * rhs[2];
+        }
+    }
+
+    const CubeVertex CubeVertices[NumCubeVertices] =
+    {
+        // Top
+        { { -1.0f * CubeScale,  1.0f * CubeScale,  1.0f * CubeScale }, { 1.0f, 0.25f, 0.25f, 1.0f }, { 0.0f, 1.0f } },
+        { {  1.0f * CubeScale,  1.0f * CubeScale,  1.0f * CubeScale }, { 0.25f, 1.0f, 0.25f, 1.0f }, { 1.0f, 1.0f } },
+        { {  1.0f * CubeScale,  1.0f * CubeScale, -1.0f * CubeScale }, { 0.25f, 0.25f, 1.0f, 1.0f }, { 1.0f, 0.0f } },
+        { { -1.0f * CubeScale,  1.0f * CubeScale, -1.0f * CubeScale }, { 1.0f, 0.25f, 1.0f,  1.0f }, { 0.0f, 0.0f } },
+        // Bottom
+        { { -1.0f * CubeScale, -1.0f * CubeScale, -1.0f * CubeScale }, { 1.0f, 0.25f, 0.25f, 1.0f }, { 0.0f, 0.0f } },
+        { { -1.0f * CubeScale, -1.0f * CubeScale,  1.0f * CubeScale }, { 0.25f, 1.0f, 0.25f, 1.0f }, { 0.0f, 1.0f } },
+        { {  1.0f * CubeScale, -1.0f * CubeScale,  1.0f * CubeScale }, { 0.25f, 0.25f, 1.0f, 1.0f }, { 1.0f, 1.0f } },
+        { {  1.0f * CubeScale, -1.0f * CubeScale, -1.0f * CubeScale }, { 1.0f, 0.25f, 1.0f,  1.0f }, { 1.0f, 0.0f } },
+        // Left
+        { { -1.0f * CubeScale,  1.0f * CubeScale, -1.0f * CubeScale }, { 1.0f, 0.25f, 0.25f, 1.0f }, { 0.0f, 1.0f } },
+        { { -1.0f * CubeScale,  1.0f * CubeScale,  1.0f * CubeScale }, { 0.25f, 1.0f, 0.25f, 1.0f }, { 1.0f, 1.0f } },
+        { { -1.0f * CubeScale, -1.0f * CubeScale,  1.0f * CubeScale }, { 0.25f, 0.25f, 1.0f, 1.0f }, { 1.0f, 0.0f } },
+        { { -1.0f * CubeScale, -1.0f * CubeScale, -1.0f * CubeScale }, { 1.0f, 0.25f, 1.0f,  1.0f }, { 0.0f, 0.0f } },
+        // Right
+        { {  1.0f * CubeScale,  1.0f * CubeScale, -1.0f * CubeScale }, { 1.0f, 0.25f, 0.25f, 1.0f }, { 0.0f, 1.0f } },
+        { {  1.0f * CubeScale,  1.0f * CubeScale,  1.0f * CubeScale }, { 0.25f, 1.0f, 0.25f, 1.0f }, { 1.0f, 1.0f } },
+        { {  1.0f * CubeScale, -1.0f * CubeScale,  1.0f * CubeScale }, { 0.25f, 0.25f, 1.0f, 1.0f }, { 1.0f, 0.0f } },
+        { {  1.0f * CubeScale, -1.0f * CubeScale, -1.0f * CubeScale }, { 1.0f, 0.25f, 1.0f,  1.0f }, { 0.0f, 0.0f } },
+        // Back
+        { { -1.0f * CubeScale,  1.0f * CubeScale,  1.0f * CubeScale }, { 1.0f, 0.25f, 0.25f, 1.0f }, { 0.0f, 1.0f } },
+        { {  1.0f * CubeScale,  1.0f * CubeScale,  1.0f * CubeScale }, { 0.25f, 1.0f, 0.25f, 1.0f }, { 1.0f, 1.0f } },
+        { {  1.0f * CubeScale, -1.0f * CubeScale,  1.0f * CubeScale }, { 0.25f, 0.25f, 1.0f, 1.0f }, { 1.0f, 0.0f } },
+        { { -1.0f * CubeScale, -1.0f * CubeScale,  1.0f * CubeScale }, { 1.0f, 0.25f, 1.0f,  1.0f }, { 0.0f, 0.0f } },
+        // Front
+        { { -1.0f * CubeScale,  1.0f * CubeScale, -1.0f * CubeScale }, { 1.0f, 0.25f, 0.25f, 1.0f }, { 0.0f, 1.0f } },
+        { {  1.0f * CubeScale,  1.0f * CubeScale, -1.0f * CubeScale }, { 0.25f, 1.0f, 0.25f, 1.0f }, { 1.0f, 1.0f } },
+        { {  1.0f * CubeScale, -1.0f * CubeScale, -1.0f * CubeScale }, { 0.25f, 0.25f, 1.0f, 1.0f }, { 1.0f, 0.0f } },
+        { { -1.0f * CubeScale, -1.0f * CubeScale, -1.0f * CubeScale }, { 1.0f, 0.25f, 1.0f,  1.0f }, { 0.0f, 0.0f } },
+    };
+
+    const uint32_t CubeIndices[NumCubeIndices] =
+    {
+        0, 1, 3, 3, 1, 2,
+        4, 5, 7, 7, 5, 6,
+        8, 9, 11, 11, 9, 10,
+        12, 13, 15, 15, 13, 14,
+        16, 17, 19, 19, 17, 18,
+        20, 21, 23, 23, 21, 22
+    };
+
+    const float CubeFaceNormals[NumCubeFaces][3] =
+    {
+        {  0.0f,  1.0f,  0.0f },    // Top
+        {  0.0f, -1.0f,  0.0f },    // Bottom
+        { -1.0f,  0.0f,  0.0f },    // Left
+        {  1.0f,  0.0f,  0.0f },    // Right
+        {  0.0f,  0.0f,  1.0f },    // Back
+        {  0.0f,  0.0f, -1.0f },    // Front
+    };
+
+    void InitCheckerTexture(char* dst, uint32_t width, uint32_t height, uint32_t bpp)
+    {
+        for (uint32_t j = 0; j < height; ++j)
+        {
+            for (uint32_t i = 0; i < width; ++i)
+            {
+                dst[j * (width * bpp) + (i * bpp) + 0] = !(i % 16 < 8) != !(j % 16 < 8) ? 0xff : 0;
+                dst[j * (width * bpp) + (i * bpp) + 1] = !(i % 16 < 8) != !(j % 16 < 8) ? 0xff : 0;
+                dst[j * (width * bpp) + (i * bpp) + 2] = !(i % 16 < 8) != !(j % 16 < 8) ? 0xff : 0;
+                dst[j * (width * bpp) + (i * bpp) + 3] = 0xffu;
+            }
+        }
+    }
+
+    void CalcProjection(float aspectRatio, float projectionOut[16])
+    {
+        float height = 1.0f / std::tan(0.5f * FieldOfViewY);
+        float range = FarZ / (FarZ - NearZ);
+        const float projection[16] =
+        {
+            height / aspectRatio, 0.0f,   0.0f,           0.0f,
+            0.0f,                 height, 0.0f,           0.0f,
+            0.0f,                 0.0f,   range,          1.0f,
+            0.0f,                 0.0f,   -range * NearZ, 0.0f
+        };
+        for (int i = 0; i < 16; i++)
+        {
+            projectionOut[i] = projection[i];
+        }
+    }
+
+    void CalcLookTo(const float position[3], const float forward[3], const float up[3], float viewOut[16])
+    {
+        float axisZ[3] = { forward[0], forward[1], forward[2] };
+        Normalize(axisZ);
+        float axisX[3];
+        Cross(up, axisZ, axisX);
+        Normalize(axisX);
+        float axisY[3];
+        Cross(axisZ, axisX, axisY);
+
+        // Camera axes are the columns; the last row moves the camera to the origin
+        const float view[16] =
+        {
+            axisX[0],               axisY[0],               axisZ[0],               0.0f,
+            axisX[1],               axisY[1],               axisZ[1],               0.0f,
+            axisX[2],               axisY[2],               axisZ[2],               0.0f,
+            -Dot(axisX, position),  -Dot(axisY, position),  -Dot(axisZ, position),  1.0f
+        };
+        for (int i = 0; i < 16; i++)
+        {
+            viewOut[i] = view[i];
+        }
+    }
+
+    void MultiplyMatrices(const float lhs[16], const float rhs[16], float productOut[16])
+    {
+        float product[16];
+        for (int row = 0; row < 4; row++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                float sum = 0.0f;
+                for (int i = 0; i < 4; i++)
+                {
+                    sum += lhs[row * 4 + i] * rhs[i * 4 + column];
+                }
+                product[row * 4 + column] = sum;
+            }
+        }
+        for (int i = 0; i < 16; i++)
+        {
+            productOut[i] = product[i];
+        }
+    }
+
+} // namespace Vnm
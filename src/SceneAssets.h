@@ -0,0 +1,49 @@
+// SceneAssets.h
+
+#pragma once
+
+#include <cstdint>
+
+namespace Vnm
+{
+    // Mesh, texture and camera constants every renderer draws the scene with, so backends agree pixel for pixel
+
+    class CubeVertex
+    {
+    public:
+        float mPosition[3];
+        float mColor[4];
+        float mTexcoord[2];
+    };
+
+    constexpr int NumCubeFaces = 6;
+    constexpr int NumCubeVertices = 24;
+    constexpr int NumCubeIndices = 36;
+
+    // Unit cube centered on the origin, four vertices and two triangles per face, faces in the order top, bottom, left,
+    // right, back, front
+    extern const CubeVertex CubeVertices[NumCubeVertices];
+    extern const uint32_t   CubeIndices[NumCubeIndices];
+    extern const float      CubeFaceNormals[NumCubeFaces][3];   // Outward, in face order
+
+    constexpr uint32_t CheckerTextureWidth = 64;
+    constexpr uint32_t CheckerTextureHeight = 64;
+    constexpr uint32_t CheckerTextureBpp = 4;
+
+    // Black and white checkerboard of 8 texel squares, RGBA8, opaque
+    void InitCheckerTexture(char* dst, uint32_t width, uint32_t height, uint32_t bpp);
+
+    constexpr float ClearColor[4] = { 0.65f, 0.65f, 0.85f, 1.0f };
+    constexpr float FieldOfViewY = 1.0f;
+    constexpr float NearZ = 0.1f;
+    constexpr float FarZ = 100.0f;
+
+    // Row-major matrices for row vectors, laid out as DirectXMath stores them
+
+    // Left-handed perspective projection with depth from 0 at NearZ to 1 at FarZ, as XMMatrixPerspectiveFovLH
+    void CalcProjection(float aspectRatio, float projectionOut[16]);
+    // World to view transform of a camera at position looking along forward, as XMMatrixLookToLH
+    void CalcLookTo(const float position[3], const float forward[3], const float up[3], float viewOut[16]);
+    void MultiplyMatrices(const float lhs[16], const float rhs[16], float productOut[16]);
+
+} // namespace Vnm
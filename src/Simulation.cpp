@@ -0,0 +1,632 @@
+// Simulation.cpp
+
+#include "Simulation.h"
+#include "Zobrist.h"
+#include <algorithm>
+
+namespace Snake
+{
+    static void Cross(const int a[3], const int b[3], int sign, int out[3])
+    {
+        out[0] = sign * (a[1] * b[2] - a[2] * b[1]);
+        out[1] = sign * (a[2] * b[0] - a[0] * b[2]);
+        out[2] = sign * (a[0] * b[1] - a[1] * b[0]);
+    }
+
+    static void Copy(const int in[3], int out[3])
+    {
+        out[0] = in[0];
+        out[1] = in[1];
+        out[2] = in[2];
+    }
+
+    Simulation::Simulation(uint64_t seed, const BoardLayout& layout)
+        : mBoard(layout)
+    {
+        mBody.Init(mBoard.GetNumCells());
+        Reset(seed);
+    }
+
+    void Simulation::Reset(uint64_t seed)
+    {
+        mRandom.Seed(seed);
+        Reset();
+    }
+
+    void Simulation::Reset()
+    {
+        mBoard.Reset();
+        mBody.Reset();
+
+        // Start at block 5 on each axis, facing +z, or nearer the middle on boards too small for that
+        const BoardLayout& layout = mBoard.GetLayout();
+        for (int axis = 0; axis < 3; axis++)
+        {
+            mHeadCell[axis] = std::min(5, static_cast<int>(layout.GetNumPieces(axis)) / 2);
+            mPosition[axis] = mHeadCell[axis] * UnitsPerBlock;
+            mForward[axis] = axis == 2 ? 1 : 0;
+            mUp[axis] = axis == 1 ? 1 : 0;
+            mRight[axis] = axis == 0 ? 1 : 0;
+        }
+
+        mBoard.PlaceGamePiece(mHeadCell[0], mHeadCell[1], mHeadCell[2], PieceColor::SnakeBody, GamePieceType::SnakeBody);
+        mBody.PushHead(mBoard.GetCellIndex(mHeadCell[0], mHeadCell[1], mHeadCell[2]));
+        mBodyLength = 1;
+        mStepCount = 0;
+        mGameOverCause = GameOverCause::None;
+
+        PlacePowerUp();
+    }
+
+    // Quarter turn about up; positive turns right
+    void Simulation::Yaw(int sign)
+    {
+        int forward[3];
+        int right[3];
+        Cross(mUp, mForward, sign, forward);
+        Cross(mUp, mRight, sign, right);
+        Copy(forward, mForward);
+        Copy(right, mRight);
+    }
+
+    // Quarter turn about right; positive tilts down
+    void Simulation::Pitch(int sign)
+    {
+        int forward[3];
+        int up[3];
+        Cross(mRight, mForward, sign, forward);
+        Cross(mRight, mUp, sign, up);
+        Copy(forward, mForward);
+        Copy(up, mUp);
+    }
+
+    // Returns false if there is no empty cell left, i.e. the board has been filled and the game is won
+    bool Simulation::PlacePowerUp(uint32_t* emptySlotOut)
+    {
+        if (mBoard.EmptyCellCount() == 0)
+        {
+            return false;
+        }
+
+        int x;
+        int y;
+        int z;
+        mPowerUpCell = mBoard.SampleEmptyCell(mRandom);
+        if (emptySlotOut != nullptr)
+        {
+            *emptySlotOut = mBoard.GetCellSlot(mPowerUpCell);
+        }
+        mBoard.GetCellCoords(mPowerUpCell, x, y, z);
+        mBoard.PlaceGamePiece(x, y, z, PieceColor::PowerUp, GamePieceType::PowerUp);
+        return true;
+    }
+
+    StepResult Simulation::Step(uint32_t inputs)
+    {
+        return StepInternal(inputs, nullptr);
+    }
+
+    StepResult Simulation::ApplyStep(uint32_t inputs, StepUndo& undo)
+    {
+        Copy(mPosition, undo.mPosition);
+        Copy(mHeadCell, undo.mHeadCell);
+        Copy(mForward, undo.mForward);
+        Copy(mUp, undo.mUp);
+        Copy(mRight, undo.mRight);
+        undo.mRandom = mRandom;
+        undo.mPowerUpCell = mPowerUpCell;
+        undo.mBodyLength = mBodyLength;
+        undo.mGameOverCause = mGameOverCause;
+        undo.mEatenPowerUpSlot = StepUndo::NoSlot;
+        undo.mHeadSlot = StepUndo::NoSlot;
+        undo.mTailSlot = StepUndo::NoSlot;
+        undo.mTailCell = 0;
+        undo.mNewPowerUpSlot = StepUndo::NoSlot;
+
+        return StepInternal(inputs, &undo);
+    }
+
+    void Simulation::UndoStep(const StepUndo& undo)
+    {
+        // Reverse order of StepInternal, so every board change is undone while it is the latest one
+        if (undo.mNewPowerUpSlot != StepUndo::NoSlot)
+        {
+            mBoard.UndoPlaceGamePiece(mPowerUpCell, undo.mNewPowerUpSlot);
+        }
+
+        if (undo.mTailSlot != StepUndo::NoSlot)
+        {
+            mBoard.UndoRemoveGamePiece(undo.mTailCell, undo.mTailSlot, PieceColor::SnakeBody, GamePieceType::SnakeBody);
+            mBody.PushTail(undo.mTailCell);
+        }
+
+        if (undo.mHeadSlot != StepUndo::NoSlot)
+        {
+            size_t headCell = mBody.PopHead();
+            mBoard.UndoPlaceGamePiece(headCell, undo.mHeadSlot);
+
+            if (undo.mEatenPowerUpSlot != StepUndo::NoSlot)
+            {
+                mBoard.UndoRemoveGamePiece(headCell, undo.mEatenPowerUpSlot, PieceColor::PowerUp, GamePieceType::PowerUp);
+            }
+        }
+
+        Copy(undo.mPosition, mPosition);
+        Copy(undo.mHeadCell, mHeadCell);
+        Copy(undo.mForward, mForward);
+        Copy(undo.mUp, mUp);
+        Copy(undo.mRight, mRight);
+        mRandom = undo.mRandom;
+        mPowerUpCell = undo.mPowerUpCell;
+        mBodyLength = undo.mBodyLength;
+        mGameOverCause = undo.mGameOverCause;
+        mStepCount--;
+    }
+
+    StepResult Simulation::StepInternal(uint32_t inputs, StepUndo* undo)
+    {
+        assert(!IsOver());
+
+        if (inputs & InputTurnLeft)
+        {
+            Yaw(-1);
+        }
+        if (inputs & InputTurnRight)
+        {
+            Yaw(1);
+        }
+        if (inputs & InputTiltDown)
+        {
+            Pitch(1);
+        }
+        if (inputs & InputTiltUp)
+        {
+            Pitch(-1);
+        }
+
+        mStepCount++;
+
+        int cell[3];
+        for (int axis = 0; axis < 3; axis++)
+        {
+            mPosition[axis] += mForward[axis];
+
+            // The boundary wall stops the head before it can go negative, so division floors
+            assert(mPosition[axis] >= 0);
+            cell[axis] = mPosition[axis] / UnitsPerBlock;
+        }
+
+        if (cell[0] == mHeadCell[0] && cell[1] == mHeadCell[1] && cell[2] == mHeadCell[2])
+        {
+            return StepResult::Moved;
+        }
+
+        // Walls are implicit, so hitting one is a bounds check; the tail has not moved yet, so running into it is fatal
+        GamePieceType gamePieceType = mBoard.IsWall(cell[0], cell[1], cell[2]) ?
+            GamePieceType::Wall :
+            mBoard.GetGamePieceType(cell[0], cell[1], cell[2]);
+        if (gamePieceType == GamePieceType::Wall || gamePieceType == GamePieceType::SnakeBody)
+        {
+            mGameOverCause = gamePieceType == GamePieceType::Wall ? GameOverCause::HitWall : GameOverCause::HitBody;
+            return StepResult::Died;
+        }
+
+        size_t cellIndex = mBoard.GetCellIndex(cell[0], cell[1], cell[2]);
+        StepResult result = StepResult::EnteredCell;
+        if (gamePieceType == GamePieceType::PowerUp)
+        {
+            // Power-up grows the body by one
+            if (undo != nullptr)
+            {
+                undo->mEatenPowerUpSlot = mBoard.GetCellSlot(cellIndex);
+            }
+            mBoard.RemoveGamePiece(cell[0], cell[1], cell[2]);
+            mBodyLength++;
+            result = StepResult::AtePowerUp;
+        }
+
+        if (undo != nullptr)
+        {
+            undo->mHeadSlot = mBoard.GetCellSlot(cellIndex);
+        }
+        mBoard.PlaceGamePiece(cell[0], cell[1], cell[2], PieceColor::SnakeBody, GamePieceType::SnakeBody);
+        mBody.PushHead(cellIndex);
+        Copy(cell, mHeadCell);
+
+        // The body grows by at most one cell per step, so at most one tail piece drops
+        if (mBody.GetLength() > mBodyLength)
+        {
+            size_t tailCell = mBody.PopTail();
+            if (undo != nullptr)
+            {
+                undo->mTailCell = static_cast<uint32_t>(tailCell);
+                undo->mTailSlot = mBoard.GetCellSlot(tailCell);
+            }
+
+            int xTail;
+            int yTail;
+            int zTail;
+            mBoard.GetCellCoords(tailCell, xTail, yTail, zTail);
+            mBoard.RemoveGamePiece(xTail, yTail, zTail);
+        }
+
+        // No room left for a new power-up means the board is full and the game is won
+        if (result == StepResult::AtePowerUp && !PlacePowerUp(undo != nullptr ? &undo->mNewPowerUpSlot : nullptr))
+        {
+            mGameOverCause = GameOverCause::BoardFull;
+            return StepResult::Won;
+        }
+
+        return result;
+    }
+
+    uint64_t Simulation::GetHash() const
+    {
+        return mBoard.GetHash() ^ ZobristHeadKey(mPosition) ^ ZobristBasisKey(mForward, mUp);
+    }
+
+    void Simulation::GetHeadPosition(float positionOut[3]) const
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            positionOut[axis] = static_cast<float>(mPosition[axis]) / static_cast<float>(UnitsPerBlock);
+        }
+    }
+
+    namespace
+    {
+        // Little endian fixed-width fields
+        class KeyframeWriter
+        {
+        public:
+            explicit KeyframeWriter(std::vector<uint8_t>& data) : mData(data) {}
+
+            void Write(uint64_t value, size_t numBytes)
+            {
+                for (size_t i = 0; i < numBytes; i++)
+                {
+                    mData.push_back(static_cast<uint8_t>(value >> (8 * i)));
+                }
+            }
+
+            void WriteVector(const int v[3])
+            {
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    Write(static_cast<uint32_t>(v[axis]), 4);
+                }
+            }
+
+        private:
+            std::vector<uint8_t>& mData;
+        };
+
+        class KeyframeReader
+        {
+        public:
+            KeyframeReader(const uint8_t* data, size_t size) : mData(data), mSize(size) {}
+
+            bool Read(uint64_t& valueOut, size_t numBytes)
+            {
+                if (mSize - mRead < numBytes)
+                {
+                    return false;
+                }
+
+                valueOut = 0;
+                for (size_t i = 0; i < numBytes; i++)
+                {
+                    valueOut |= static_cast<uint64_t>(mData[mRead++]) << (8 * i);
+                }
+                return true;
+            }
+
+            bool ReadVector(int vOut[3])
+            {
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    uint64_t value;
+                    if (!Read(value, 4))
+                    {
+                        return false;
+                    }
+                    vOut[axis] = static_cast<int>(static_cast<uint32_t>(value));
+                }
+                return true;
+            }
+
+            // Count followed by that many cells, refusing counts the remaining bytes cannot hold
+            bool ReadCount(size_t& countOut, size_t bytesPerEntry)
+            {
+                uint64_t count;
+                if (!Read(count, 4) || count > (mSize - mRead) / bytesPerEntry)
+                {
+                    return false;
+                }
+                countOut = static_cast<size_t>(count);
+                return true;
+            }
+
+            bool IsAtEnd() const { return mRead == mSize; }
+
+        private:
+            const uint8_t* mData;
+            size_t         mSize;
+            size_t         mRead = 0;
+        };
+
+        bool IsAxis(const int v[3])
+        {
+            int length = 0;
+            for (int axis = 0; axis < 3; axis++)
+            {
+                if (v[axis] < -1 || v[axis] > 1)
+                {
+                    return false;
+                }
+                length += v[axis] * v[axis];
+            }
+            return length == 1;
+        }
+
+        // The head must be on the board, in an interior cell, and face along the axes, or stepping leaves the board arrays
+        // A dead head has already moved on into the cell that killed it
+        bool IsValidHead(const BoardLayout& layout, const int position[3], const int headCell[3], const int forward[3],
+            const int up[3], const int right[3], bool isOver)
+        {
+            for (int axis = 0; axis < 3; axis++)
+            {
+                int numPieces = static_cast<int>(layout.GetNumPieces(axis));
+                int positionCell = position[axis] / Simulation::UnitsPerBlock;
+                if (position[axis] < 0 || positionCell >= numPieces || headCell[axis] <= 0 || headCell[axis] >= numPieces - 1 ||
+                    (!isOver && positionCell != headCell[axis]))
+                {
+                    return false;
+                }
+            }
+            return IsAxis(forward) && IsAxis(up) && IsAxis(right);
+        }
+    }
+
+    void Simulation::SaveKeyframe(std::vector<uint8_t>& dataOut) const
+    {
+        const size_t cellBytes = mBoard.GetNumCells() <= 65536 ? 2 : 4;
+        dataOut.clear();
+
+        KeyframeWriter writer(dataOut);
+        writer.Write(mRandom.GetState(), 8);
+        writer.WriteVector(mPosition);
+        writer.WriteVector(mHeadCell);
+        writer.WriteVector(mForward);
+        writer.WriteVector(mUp);
+        writer.WriteVector(mRight);
+        writer.Write(mPowerUpCell, 4);
+        writer.Write(mBodyLength, 4);
+        writer.Write(mStepCount, 8);
+        writer.Write(static_cast<uint8_t>(mGameOverCause), 1);
+
+        writer.Write(mBody.GetLength(), 4);
+        for (size_t i = 0; i < mBody.GetLength(); i++)
+        {
+            writer.Write(mBody.GetCell(i), cellBytes);
+        }
+
+        writer.Write(mBoard.EmptyCellCount(), 4);
+        const uint32_t* emptyCells = mBoard.GetEmptyCells();
+        for (size_t i = 0; i < mBoard.EmptyCellCount(); i++)
+        {
+            writer.Write(emptyCells[i], cellBytes);
+        }
+
+        size_t numOccupiedCells;
+        const OccupiedCell* occupiedCells = mBoard.GetOccupiedCells(&numOccupiedCells);
+        writer.Write(numOccupiedCells, 4);
+        for (size_t i = 0; i < numOccupiedCells; i++)
+        {
+            writer.Write(occupiedCells[i].mCellIndex, cellBytes);
+            writer.Write(static_cast<uint8_t>(occupiedCells[i].mGamePieceType), 1);
+            writer.Write(static_cast<uint8_t>(occupiedCells[i].mColor), 1);
+        }
+    }
+
+    bool Simulation::LoadKeyframe(const uint8_t* data, size_t size)
+    {
+        const size_t cellBytes = mBoard.GetNumCells() <= 65536 ? 2 : 4;
+        KeyframeReader reader(data, size);
+
+        uint64_t randomState;
+        uint64_t powerUpCell;
+        uint64_t bodyLength;
+        uint64_t stepCount;
+        uint64_t gameOverCause;
+        bool valid = reader.Read(randomState, 8) &&
+            reader.ReadVector(mPosition) &&
+            reader.ReadVector(mHeadCell) &&
+            reader.ReadVector(mForward) &&
+            reader.ReadVector(mUp) &&
+            reader.ReadVector(mRight) &&
+            reader.Read(powerUpCell, 4) &&
+            reader.Read(bodyLength, 4) &&
+            reader.Read(stepCount, 8) &&
+            reader.Read(gameOverCause, 1);
+
+        valid = valid &&
+            IsValidHead(mBoard.GetLayout(), mPosition, mHeadCell, mForward, mUp, mRight, gameOverCause != static_cast<uint8_t>(GameOverCause::None)) &&
+            powerUpCell < mBoard.GetNumCells() && bodyLength <= mBoard.GetNumCells() &&
+            gameOverCause <= static_cast<uint8_t>(GameOverCause::BoardFull);
+
+        size_t numBodyCells = 0;
+        std::vector<uint32_t> bodyCells;
+        valid = valid && reader.ReadCount(numBodyCells, cellBytes) && numBodyCells > 0 && numBodyCells <= bodyLength;
+        for (size_t i = 0; valid && i < numBodyCells; i++)
+        {
+            uint64_t cell = 0;
+            valid = reader.Read(cell, cellBytes);
+            bodyCells.push_back(static_cast<uint32_t>(cell));
+        }
+
+        size_t numEmptyCells = 0;
+        std::vector<uint32_t> emptyCells;
+        valid = valid && reader.ReadCount(numEmptyCells, cellBytes);
+        for (size_t i = 0; valid && i < numEmptyCells; i++)
+        {
+            uint64_t cell = 0;
+            valid = reader.Read(cell, cellBytes);
+            emptyCells.push_back(static_cast<uint32_t>(cell));
+        }
+
+        size_t numOccupiedCells = 0;
+        std::vector<OccupiedCell> occupiedCells;
+        valid = valid && reader.ReadCount(numOccupiedCells, cellBytes + 2);
+        for (size_t i = 0; valid && i < numOccupiedCells; i++)
+        {
+            uint64_t cell = 0;
+            uint64_t type = 0;
+            uint64_t color = 0;
+            valid = reader.Read(cell, cellBytes) && reader.Read(type, 1) && reader.Read(color, 1);
+            occupiedCells.push_back({ static_cast<uint32_t>(cell), static_cast<GamePieceType>(type), static_cast<PieceColor>(color) });
+        }
+
+        valid = valid && reader.IsAtEnd() &&
+            mBoard.Restore(emptyCells.data(), numEmptyCells, occupiedCells.data(), numOccupiedCells);
+
+        // Body cells must be distinct body pieces, all of them, ending at the head
+        size_t numBodyPieces = 0;
+        for (size_t i = 0; valid && i < numOccupiedCells; i++)
+        {
+            numBodyPieces += occupiedCells[i].mGamePieceType == GamePieceType::SnakeBody ? 1 : 0;
+        }
+        std::vector<bool> isBodyCell(valid ? mBoard.GetNumCells() : 0);
+        for (size_t i = 0; valid && i < numBodyCells; i++)
+        {
+            valid = bodyCells[i] < mBoard.GetNumCells() && !isBodyCell[bodyCells[i]] &&
+                mBoard.GetGamePieceType(bodyCells[i]) == GamePieceType::SnakeBody;
+            if (valid)
+            {
+                isBodyCell[bodyCells[i]] = true;
+            }
+        }
+        valid = valid && numBodyPieces == numBodyCells &&
+            bodyCells.back() == mBoard.GetCellIndex(mHeadCell[0], mHeadCell[1], mHeadCell[2]);
+
+        if (!valid)
+        {
+            Reset();
+            return false;
+        }
+
+        mBody.Reset();
+        for (uint32_t cell : bodyCells)
+        {
+            mBody.PushHead(cell);
+        }
+
+        mRandom.SetState(randomState);
+        mPowerUpCell = static_cast<size_t>(powerUpCell);
+        mBodyLength = static_cast<size_t>(bodyLength);
+        mStepCount = stepCount;
+        mGameOverCause = static_cast<GameOverCause>(gameOverCause);
+        return true;
+    }
+
+    void Simulation::GetState(SimulationState& stateOut) const
+    {
+        stateOut.mRandomState = mRandom.GetState();
+        stateOut.mStepCount = mStepCount;
+        Copy(mPosition, stateOut.mPosition);
+        Copy(mHeadCell, stateOut.mHeadCell);
+        Copy(mForward, stateOut.mForward);
+        Copy(mUp, stateOut.mUp);
+        Copy(mRight, stateOut.mRight);
+        stateOut.mPowerUpCell = static_cast<uint32_t>(mPowerUpCell);
+        stateOut.mBodyLength = static_cast<uint32_t>(mBodyLength);
+        stateOut.mGameOverCause = static_cast<uint32_t>(mGameOverCause);
+    }
+
+    bool Simulation::SetState(const SimulationState& state, const uint32_t* bodyCells, size_t numBodyCells, const GameBoard& board)
+    {
+        bool valid = board.GetLayout() == mBoard.GetLayout() &&
+            IsValidHead(board.GetLayout(), state.mPosition, state.mHeadCell, state.mForward, state.mUp, state.mRight,
+                state.mGameOverCause != static_cast<uint32_t>(GameOverCause::None)) &&
+            state.mPowerUpCell < board.GetNumCells() && state.mGameOverCause <= static_cast<uint32_t>(GameOverCause::BoardFull) &&
+            numBodyCells > 0 && numBodyCells <= state.mBodyLength && state.mBodyLength <= board.GetNumCells() &&
+            bodyCells[numBodyCells - 1] == board.GetCellIndex(state.mHeadCell[0], state.mHeadCell[1], state.mHeadCell[2]);
+
+        // Besides the body the board may hold only the power-up, so with every body cell distinct and a body piece,
+        // the counts matching means there are no stray body pieces either
+        size_t numOccupiedCells = 0;
+        const OccupiedCell* occupiedCells = board.GetOccupiedCells(&numOccupiedCells);
+        if (valid)
+        {
+            bool hasPowerUp = board.GetGamePieceType(state.mPowerUpCell) == GamePieceType::PowerUp;
+            valid = numOccupiedCells == numBodyCells + (hasPowerUp ? 1 : 0);
+        }
+
+        // Distinct cells have distinct occupied list slots, so a bit per slot finds repeats in O(body)
+        std::vector<uint64_t> usedSlots(valid ? (numOccupiedCells + 63) / 64 : 0, 0);
+        for (size_t i = 0; valid && i < numBodyCells; i++)
+        {
+            valid = bodyCells[i] < board.GetNumCells() && board.GetGamePieceType(bodyCells[i]) == GamePieceType::SnakeBody;
+            if (valid)
+            {
+                uint32_t slot = board.GetCellSlot(bodyCells[i]);
+                uint64_t bit = uint64_t(1) << (slot % 64);
+                valid = slot < numOccupiedCells && occupiedCells[slot].mCellIndex == bodyCells[i] && (usedSlots[slot / 64] & bit) == 0;
+                usedSlots[slot / 64] |= valid ? bit : 0;
+            }
+        }
+
+        // The lists and slots are copied as they are, so check them as Restore does: entries that point back at their own
+        // slots are distinct, and with the counts adding up to the interior and every other cell a wall they cover it
+        const BoardLayout& layout = board.GetLayout();
+        size_t numEmptyCells = board.EmptyCellCount();
+        const uint32_t* emptyCells = board.GetEmptyCells();
+        valid = valid && numEmptyCells + numOccupiedCells == layout.GetNumInteriorCells();
+        for (size_t slot = 0; valid && slot < numEmptyCells; slot++)
+        {
+            valid = emptyCells[slot] < board.GetNumCells() && board.GetGamePieceType(emptyCells[slot]) == GamePieceType::Empty &&
+                board.GetCellSlot(emptyCells[slot]) == slot;
+        }
+        for (size_t slot = 0; valid && slot < numOccupiedCells; slot++)
+        {
+            const OccupiedCell& occupiedCell = occupiedCells[slot];
+            valid = occupiedCell.mCellIndex < board.GetNumCells() &&
+                board.GetGamePieceType(occupiedCell.mCellIndex) == occupiedCell.mGamePieceType &&
+                (occupiedCell.mGamePieceType == GamePieceType::SnakeBody || occupiedCell.mGamePieceType == GamePieceType::PowerUp) &&
+                occupiedCell.mColor < PieceColor::Count && board.GetCellSlot(occupiedCell.mCellIndex) == slot;
+        }
+        if (valid)
+        {
+            const GamePieceType* types = board.GetGamePieceTypes();
+            size_t numWallCells = static_cast<size_t>(std::count(types, types + board.GetNumCells(), GamePieceType::Wall));
+            valid = numWallCells == board.GetNumCells() - layout.GetNumInteriorCells();
+        }
+
+        if (!valid)
+        {
+            Reset();
+            return false;
+        }
+
+        // The board is a single block copy
+        mBoard = board;
+        mBody.Reset();
+        for (size_t i = 0; i < numBodyCells; i++)
+        {
+            mBody.PushHead(bodyCells[i]);
+        }
+
+        mRandom.SetState(state.mRandomState);
+        mStepCount = state.mStepCount;
+        Copy(state.mPosition, mPosition);
+        Copy(state.mHeadCell, mHeadCell);
+        Copy(state.mForward, mForward);
+        Copy(state.mUp, mUp);
+        Copy(state.mRight, mRight);
+        mPowerUpCell = state.mPowerUpCell;
+        mBodyLength = state.mBodyLength;
+        mGameOverCause = static_cast<GameOverCause>(state.mGameOverCause);
+        return true;
+    }
+
+} // namespace Snake
@@ -0,0 +1,153 @@
+// Simulation.h
+
+#pragma once
+
+#include "Random.h"
+#include "Snake3D.h"
+#include "SnakeBody.h"
+#include <vector>
+
+namespace Snake
+{
+    // Per-step input bits; each set bit turns the snake a quarter turn before it advances
+    constexpr uint32_t InputTurnLeft  = 1 << 0;
+    constexpr uint32_t InputTurnRight = 1 << 1;
+    constexpr uint32_t InputTiltUp    = 1 << 2;
+    constexpr uint32_t InputTiltDown  = 1 << 3;
+
+    enum class StepResult : uint8_t
+    {
+        Moved,          // Head is still inside the same cell
+        EnteredCell,    // Head moved into an empty cell
+        AtePowerUp,
+        Died,           // Head hit a wall or the body
+        Won,            // No empty cell is left for the next power-up
+    };
+
+    enum class GameOverCause : uint8_t
+    {
+        None,           // Game is still running
+        HitWall,
+        HitBody,
+        BoardFull,
+    };
+
+    // Everything one step changes, so the step can be undone without copying the game
+    class StepUndo
+    {
+    public:
+        static constexpr uint32_t NoSlot = UINT32_MAX;
+
+        int           mPosition[3];
+        int           mHeadCell[3];
+        int           mForward[3];
+        int           mUp[3];
+        int           mRight[3];
+        Random        mRandom;
+        size_t        mPowerUpCell;
+        size_t        mBodyLength;
+        GameOverCause mGameOverCause;
+
+        // Board list slots the touched cells held before the step, NoSlot where the step did not touch them
+        uint32_t      mEatenPowerUpSlot;
+        uint32_t      mHeadSlot;
+        uint32_t      mTailSlot;
+        uint32_t      mTailCell;
+        uint32_t      mNewPowerUpSlot;
+    };
+
+    // Fixed-size part of a game beyond its board and body, laid out to be stored as is
+    class SimulationState
+    {
+    public:
+        uint64_t mRandomState;
+        uint64_t mStepCount;
+        int32_t  mPosition[3];
+        int32_t  mHeadCell[3];
+        int32_t  mForward[3];
+        int32_t  mUp[3];
+        int32_t  mRight[3];
+        uint32_t mPowerUpCell;
+        uint32_t mBodyLength;
+        uint32_t mGameOverCause;
+    };
+
+    // Fixed-timestep snake game, independent of rendering and wall-clock time
+    // State is integer only and randomness comes from an explicitly seeded generator, so a seed plus an input
+    // sequence always reproduces the same game bit for bit
+    class Simulation
+    {
+    public:
+        static constexpr int StepsPerSecond = 60;
+        static constexpr int UnitsPerBlock = 40;    // Head advances one unit per step
+
+        explicit Simulation(uint64_t seed, const BoardLayout& layout = DefaultGameBoard::Layout);
+
+        // Starts a new game, continuing the current random sequence
+        void Reset();
+        // Starts a new game from a fresh random sequence
+        void Reset(uint64_t seed);
+
+        // Advances one fixed timestep; after Died or Won the game must be Reset before stepping again
+        StepResult Step(uint32_t inputs);
+
+        // Step that records what it changes, and its exact inverse
+        // Steps must be undone newest first; afterwards the game, including the board's internal order and the random
+        // sequence, is as it was, so lookahead can explore any number of moves without copying or allocating.
+        StepResult ApplyStep(uint32_t inputs, StepUndo& undo);
+        void UndoStep(const StepUndo& undo);
+
+        const GameBoard& GetBoard() const   { return mBoard; }
+        const SnakeBody& GetBody() const    { return mBody; }
+        size_t GetBodyLength() const        { return mBodyLength; }
+        uint64_t GetStepCount() const       { return mStepCount; }
+        bool IsOver() const                 { return mGameOverCause != GameOverCause::None; }
+        GameOverCause GetGameOverCause() const { return mGameOverCause; }
+
+        // Head position in board space, where block (x, y, z) spans [x, x + 1) on each axis
+        void GetHeadPosition(float positionOut[3]) const;
+        const int* GetHeadCell() const      { return mHeadCell; }
+        size_t GetPowerUpCell() const       { return mPowerUpCell; }
+
+        // Orthonormal basis of the head, always axis aligned
+        const int* GetForward() const       { return mForward; }
+        const int* GetUp() const            { return mUp; }
+        const int* GetRight() const         { return mRight; }
+
+        // Zobrist hash of the board cells plus the head position and orientation
+        uint64_t GetHash() const;
+
+        // Compact copy of the whole game, board list order and random sequence included, from which LoadKeyframe
+        // carries on bit for bit; cells take two bytes each on boards of up to 65536 cells
+        void SaveKeyframe(std::vector<uint8_t>& dataOut) const;
+        // Replaces the game with a saved one for the same board layout; false, starting a new game, if the data is not one
+        bool LoadKeyframe(const uint8_t* data, size_t size);
+
+        // Fixed-size state, and its inverse given the body cells tail to head and a board with the same layout, such as a
+        // read-only one over a mapped snapshot; only the head and body are checked against the board, which must hold
+        // each body cell once and no other body pieces, false starting a new game if they do not fit
+        void GetState(SimulationState& stateOut) const;
+        bool SetState(const SimulationState& state, const uint32_t* bodyCells, size_t numBodyCells, const GameBoard& board);
+
+    private:
+        void Yaw(int sign);
+        void Pitch(int sign);
+        StepResult StepInternal(uint32_t inputs, StepUndo* undo);
+        bool PlacePowerUp(uint32_t* emptySlotOut = nullptr);
+
+        GameBoard mBoard;
+        SnakeBody mBody;
+        Random    mRandom;
+
+        int       mPosition[3];     // Head position in units, UnitsPerBlock units per block
+        int       mHeadCell[3];
+        int       mForward[3];
+        int       mUp[3];
+        int       mRight[3];
+        size_t    mPowerUpCell;
+        size_t    mBodyLength;
+        uint64_t  mStepCount;
+        GameOverCause mGameOverCause;
+    };
+
+} // namespace Snake
@@ -0,0 +1,65 @@
+// SimulationThread.cpp
+
+#include "SimulationThread.h"
+#include <utility>
+
+namespace Snake
+{
+    SimulationThread::SimulationThread(size_t maxRenderInstances)
+        : mFrames(maxRenderInstances)
+    {
+    }
+
+    SimulationThread::~SimulationThread()
+    {
+        Stop();
+    }
+
+    void SimulationThread::Start(std::chrono::steady_clock::duration interval, UpdateFunction update)
+    {
+        Stop();
+        mInterval = interval;
+        mUpdate = std::move(update);
+        mStopRequested.store(false, std::memory_order_relaxed);
+        mThread = std::thread(&SimulationThread::Run, this);
+    }
+
+    void SimulationThread::Stop()
+    {
+        if (mThread.joinable())
+        {
+            mStopRequested.store(true, std::memory_order_relaxed);
+            mThread.join();
+        }
+    }
+
+    void SimulationThread::Run()
+    {
+        std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now();
+        while (!mStopRequested.load(std::memory_order_relaxed))
+        {
+            std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+            std::chrono::steady_clock::duration lateness = startTime - deadline;
+            if (lateness.count() > mMaxLateness.load(std::memory_order_relaxed))
+            {
+                mMaxLateness.store(lateness.count(), std::memory_order_relaxed);
+            }
+            if (lateness >= mInterval)
+            {
+                // After a stall carry on from now rather than running a burst of updates; the update itself catches
+                // the game up. Updates with no interval run back to back and are never late.
+                mNumLateUpdates.fetch_add(mInterval.count() > 0 ? 1 : 0, std::memory_order_relaxed);
+                deadline = startTime;
+            }
+
+            RenderFrame& frame = mFrames.GetWriteBuffer();
+            mUpdate(frame);
+            frame.mFrameNumber = mNumUpdates.fetch_add(1, std::memory_order_relaxed) + 1;
+            mFrames.Publish();
+
+            deadline += mInterval;
+            std::this_thread::sleep_until(deadline);
+        }
+    }
+
+} // namespace Snake
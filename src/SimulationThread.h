@@ -0,0 +1,56 @@
+// SimulationThread.h
+
+#pragma once
+
+#include "RenderFrame.h"
+#include "TripleBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace Snake
+{
+    // Runs game updates at a fixed rate on a thread of their own and hands each one's RenderFrame to the render thread
+    // through a triple buffer, so a renderer stalled on vsync or the GPU never holds up the game and always draws the
+    // newest state
+    class SimulationThread
+    {
+    public:
+        // Fills the write buffer's frame; runs on the simulation thread, which owns the game between Start and Stop
+        using UpdateFunction = std::function<void(RenderFrame& frameOut)>;
+
+        explicit SimulationThread(size_t maxRenderInstances);
+        ~SimulationThread();
+
+        SimulationThread(const SimulationThread&) = delete;
+        SimulationThread& operator=(const SimulationThread&) = delete;
+
+        void Start(std::chrono::steady_clock::duration interval, UpdateFunction update);
+        // Returns once the update in progress, if any, has finished
+        void Stop();
+
+        // Render thread: switches to the newest published frame, false if there is none since the last call
+        bool AcquireFrame()                         { return mFrames.Acquire(); }
+        const RenderFrame& GetFrame() const         { return mFrames.GetReadBuffer(); }
+
+        // Updates run, and how far behind schedule they started; safe to read from any thread
+        uint64_t GetNumUpdates() const              { return mNumUpdates.load(std::memory_order_relaxed); }
+        uint64_t GetNumLateUpdates() const          { return mNumLateUpdates.load(std::memory_order_relaxed); }
+        std::chrono::steady_clock::duration GetMaxLateness() const { return std::chrono::steady_clock::duration(mMaxLateness.load(std::memory_order_relaxed)); }
+
+    private:
+        void Run();
+
+        Vnm::TripleBuffer<RenderFrame> mFrames;
+        std::thread                    mThread;
+        std::atomic<bool>              mStopRequested{ false };
+        std::chrono::steady_clock::duration mInterval{};
+        UpdateFunction                 mUpdate;
+
+        std::atomic<uint64_t>          mNumUpdates{ 0 };
+        std::atomic<uint64_t>          mNumLateUpdates{ 0 };    // Started a whole interval or more behind schedule
+        std::atomic<std::chrono::steady_clock::rep> mMaxLateness{ 0 };
+    };
+
+} // namespace Snake
@@ -1,124 +1,500 @@
 // Snake3D.cpp
 
 #include "Snake3D.h"
+#include "Zobrist.h"
 #include <cassert>
-
-template<typename T, size_t N> constexpr size_t ArraySize(T(&)[N])
-{
-    return N;
-}
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
 
 namespace Snake
 {
-    static size_t CalcIndex(int xBlock, int yBlock, int zBlock)
+    constexpr size_t StorageAlignment = 64;
+
+    static const float Palette[static_cast<size_t>(PieceColor::Count)][4] =
+    {
+        { 1.0f, 1.0f, 1.0f, 0.0f },     // SnakeBody
+        { 0.7f, 0.8f, 1.0f, 1.0f },     // PowerUp
+        { 1.0f, 0.4f, 0.4f, 1.0f },     // WallXmin
+        { 1.0f, 0.4f, 1.0f, 1.0f },     // WallXmax
+        { 0.4f, 0.4f, 1.0f, 1.0f },     // WallYmin
+        { 0.4f, 1.0f, 1.0f, 1.0f },     // WallYmax
+        { 0.4f, 1.0f, 0.4f, 1.0f },     // WallZmin
+        { 1.0f, 1.0f, 0.4f, 1.0f },     // WallZmax
+    };
+
+    static size_t AlignUp(size_t value, size_t alignment)
     {
-        return xBlock + yBlock * NumPiecesX + zBlock * NumPiecesX * NumPiecesY;
+        return (value + alignment - 1) & ~(alignment - 1);
     }
 
-    void GameBoard::Init()
+    // Baked post-Init cell storage, one per distinct layout, shared by every board using that layout
+    class InitialStorageCache
     {
-        // Initialize pool
-        size_t gamePieceArraySize = ArraySize(mGamePiecePool);
-        for (size_t i = 0; i < gamePieceArraySize - 1; i++)
+    public:
+        std::shared_ptr<const uint8_t[]> Find(const BoardLayout& layout)
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (const Entry& entry : mEntries)
+            {
+                if (entry.mLayout == layout)
+                {
+                    return entry.mStorage;
+                }
+            }
+            return nullptr;
+        }
+
+        std::shared_ptr<const uint8_t[]> Insert(const BoardLayout& layout, const void* storage, size_t size)
         {
-            // Set up linked list
-            mGamePiecePool[i].mNext = &mGamePiecePool[i + 1];
+            std::shared_ptr<uint8_t[]> baked(new uint8_t[size]);
+            memcpy(baked.get(), storage, size);
+
+            std::lock_guard<std::mutex> lock(mMutex);
+            mEntries.push_back({ layout, baked });
+            return baked;
         }
 
-        // Set up final item in pool
-        size_t finalIndex = gamePieceArraySize - 1;
-        mGamePiecePool[finalIndex].mNext = nullptr;
+    private:
+        class Entry
+        {
+        public:
+            BoardLayout                      mLayout;
+            std::shared_ptr<const uint8_t[]> mStorage;
+        };
+
+        std::mutex         mMutex;
+        std::vector<Entry> mEntries;
+    };
+
+    static InitialStorageCache gInitialStorageCache;
+
+    // Byte offsets of the per-cell arrays within a board's storage block
+    // The occupied list goes last; it starts out empty, so the initial state is everything before it
+    class StorageOffsets
+    {
+    public:
+        explicit StorageOffsets(size_t numCells)
+            : mTypes(0)
+            , mEmptyCells(AlignUp(mTypes + numCells * sizeof(GamePieceType), StorageAlignment))
+            , mCellSlots(AlignUp(mEmptyCells + numCells * sizeof(uint32_t), StorageAlignment))
+            , mOccupiedCells(AlignUp(mCellSlots + numCells * sizeof(uint32_t), StorageAlignment))
+            , mSize(AlignUp(mOccupiedCells + numCells * sizeof(OccupiedCell), StorageAlignment))
+        {}
+
+        size_t mTypes;
+        size_t mEmptyCells;
+        size_t mCellSlots;
+        size_t mOccupiedCells;
+        size_t mSize;
+    };
 
-        mGamePieceFreeList = mGamePiecePool;
+    const float* GetPaletteColor(PieceColor color)
+    {
+        return Palette[static_cast<size_t>(color)];
     }
 
-    void GameBoard::Reset()
+    GameBoard::GameBoard(const BoardLayout& layout)
+        : mLayout(layout)
     {
-        // Reset pool to initial state
+        assert(mLayout.GetNumPieces(0) > 2 && mLayout.GetNumPieces(1) > 2 && mLayout.GetNumPieces(2) > 2);
+        assert(GetNumCells() <= UINT32_MAX);
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            mBoardWorldScale[axis] = static_cast<float>(mLayout.GetNumPieces(axis));
+        }
+
+        AllocateStorage();
+
+        // Build the initial state once per layout; every later Init is a single copy of it
+        mInitialStorage = gInitialStorageCache.Find(mLayout);
+        if (mInitialStorage == nullptr)
+        {
+            BuildInitialState();
+            mInitialStorage = gInitialStorageCache.Insert(mLayout, mStorage, mInitialStorageSize);
+        }
+
         Init();
+    }
+
+    GameBoard::GameBoard(const BoardLayout& layout, const void* storage, size_t numEmptyCells, size_t numOccupiedCells, uint64_t hash)
+        : mLayout(layout)
+        , mStorage(const_cast<void*>(storage))
+        , mOwnsStorage(false)
+        , mNumOccupiedCells(numOccupiedCells)
+        , mNumEmptyCells(numEmptyCells)
+        , mHash(hash)
+    {
+        assert(reinterpret_cast<uintptr_t>(storage) % StorageAlignment == 0);
+        assert(numEmptyCells + numOccupiedCells == mLayout.GetNumInteriorCells());
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            mBoardWorldScale[axis] = static_cast<float>(mLayout.GetNumPieces(axis));
+        }
+
+        StorageOffsets offsets(GetNumCells());
+        mStorageSize = offsets.mSize;
+        mInitialStorageSize = offsets.mOccupiedCells;
+        AssignArrays();
 
-        for (size_t i = 0; i < NumGamePieces; i++)
+        // Copies need the baked initial state like any other board; constructing one bakes it if no board has yet
+        mInitialStorage = gInitialStorageCache.Find(mLayout);
+        if (mInitialStorage == nullptr)
         {
-            mGamePieces[i] = nullptr;
+            mInitialStorage = GameBoard(mLayout).mInitialStorage;
         }
     }
 
-    DirectX::XMVECTOR GameBoard::GetPosition(int xBlock, int yBlock, int zBlock) const
+    GameBoard::GameBoard(const GameBoard& other)
+        : mLayout(other.mLayout)
+        , mInitialStorage(other.mInitialStorage)
+        , mNumOccupiedCells(other.mNumOccupiedCells)
+        , mNumEmptyCells(other.mNumEmptyCells)
+        , mHash(other.mHash)
+    {
+        memcpy(mBoardWorldScale, other.mBoardWorldScale, sizeof(mBoardWorldScale));
+
+        // Storage holds no pointers, so a board copies with a single block copy
+        AllocateStorage();
+        memcpy(mStorage, other.mStorage, mStorageSize);
+    }
+
+    GameBoard::~GameBoard()
     {
-        return DirectX::XMVectorSet(
-            mBoardWorldScale[0] / static_cast<float>(NumPiecesX) * static_cast<float>(xBlock),
-            mBoardWorldScale[1] / static_cast<float>(NumPiecesY) * static_cast<float>(yBlock),
-            mBoardWorldScale[2] / static_cast<float>(NumPiecesZ) * static_cast<float>(zBlock),
-            1.0f);
+        if (mOwnsStorage)
+        {
+            ::operator delete(mStorage, std::align_val_t(StorageAlignment));
+        }
     }
 
-    void GameBoard::GetBlockCoords(const DirectX::XMVECTOR& position, int& xBlockOut, int& yBlockOut, int& zBlockOut) const
+    GameBoard& GameBoard::operator=(const GameBoard& other)
     {
-        float blockSizeX = mBoardWorldScale[0] / static_cast<float>(NumPiecesX);
-        float blockSizeY = mBoardWorldScale[1] / static_cast<float>(NumPiecesY);
-        float blockSizeZ = mBoardWorldScale[2] / static_cast<float>(NumPiecesZ);
+        assert(mOwnsStorage);
+        if (this != &other)
+        {
+            if (GetNumCells() != other.GetNumCells())
+            {
+                ::operator delete(mStorage, std::align_val_t(StorageAlignment));
+                mLayout = other.mLayout;
+                AllocateStorage();
+            }
+
+            mLayout = other.mLayout;
+            mInitialStorage = other.mInitialStorage;
+            mNumOccupiedCells = other.mNumOccupiedCells;
+            mNumEmptyCells = other.mNumEmptyCells;
+            mHash = other.mHash;
+            memcpy(mBoardWorldScale, other.mBoardWorldScale, sizeof(mBoardWorldScale));
+            memcpy(mStorage, other.mStorage, mStorageSize);
+            mJournal.Invalidate();
+        }
 
-        xBlockOut = static_cast<int>(DirectX::XMVectorGetX(position) / blockSizeX);
-        yBlockOut = static_cast<int>(DirectX::XMVectorGetY(position) / blockSizeY);
-        zBlockOut = static_cast<int>(DirectX::XMVectorGetZ(position) / blockSizeZ);
+        return *this;
     }
 
-    const GamePiece* GameBoard::GetGamePiece(int xBlock, int yBlock, int zBlock) const
+    size_t GameBoard::CalcStorageSize(const BoardLayout& layout)
     {
-        return mGamePieces[CalcIndex(xBlock, yBlock, zBlock)];
+        return StorageOffsets(layout.GetNumCells()).mSize;
     }
 
-    GamePiece* GameBoard::GetGamePiece(int xBlock, int yBlock, int zBlock)
+    void GameBoard::AllocateStorage()
     {
-        return mGamePieces[CalcIndex(xBlock, yBlock, zBlock)];
+        // Carve every per-cell array out of one cache line aligned block
+        StorageOffsets offsets(GetNumCells());
+        mStorageSize = offsets.mSize;
+        mInitialStorageSize = offsets.mOccupiedCells;
+
+        mStorage = ::operator new(mStorageSize, std::align_val_t(StorageAlignment));
+        AssignArrays();
     }
 
-    GamePiece* GameBoard::AllocGamePiece()
+    void GameBoard::AssignArrays()
     {
-        assert(mGamePieceFreeList != nullptr);
-        
-        GamePiece* result = mGamePieceFreeList;
-        mGamePieceFreeList = result->mNext;
-        result->mNext = nullptr;
-        return result;
+        StorageOffsets offsets(GetNumCells());
+        uint8_t* storage = static_cast<uint8_t*>(mStorage);
+        mTypes = reinterpret_cast<GamePieceType*>(storage + offsets.mTypes);
+        mOccupiedCells = reinterpret_cast<OccupiedCell*>(storage + offsets.mOccupiedCells);
+        mEmptyCells = reinterpret_cast<uint32_t*>(storage + offsets.mEmptyCells);
+        mCellSlots = reinterpret_cast<uint32_t*>(storage + offsets.mCellSlots);
     }
 
-    const GamePiece* const* GameBoard::GetGamePieces(size_t* outNumGamePieces) const
+    void GameBoard::Init()
     {
-        if (outNumGamePieces != nullptr)
+        assert(mOwnsStorage);
+
+        // Restore the baked initial state with one bulk copy
+        memcpy(mStorage, mInitialStorage.get(), mInitialStorageSize);
+        mNumOccupiedCells = 0;
+        mNumEmptyCells = mLayout.GetNumInteriorCells();
+        mHash = 0;
+
+        mJournal.Invalidate();
+    }
+
+    void GameBoard::BuildInitialState()
+    {
+        size_t numCells = GetNumCells();
+
+        // Every interior cell starts out empty, the boundary layer reads as wall
+        mNumOccupiedCells = 0;
+        mNumEmptyCells = 0;
+        for (size_t i = 0; i < numCells; i++)
         {
-            *outNumGamePieces = ArraySize(mGamePieces);
+            int xBlock;
+            int yBlock;
+            int zBlock;
+            GetCellCoords(i, xBlock, yBlock, zBlock);
+
+            if (IsWall(xBlock, yBlock, zBlock))
+            {
+                mTypes[i] = GamePieceType::Wall;
+                mCellSlots[i] = 0;
+            }
+            else
+            {
+                mTypes[i] = GamePieceType::Empty;
+                mEmptyCells[mNumEmptyCells] = static_cast<uint32_t>(i);
+                mCellSlots[i] = static_cast<uint32_t>(mNumEmptyCells);
+                mNumEmptyCells++;
+            }
         }
-        return mGamePieces;
     }
 
-    void GameBoard::FreeGamePiece(GamePiece* gamePiece)
+    void GameBoard::Reset()
     {
-        gamePiece->mNext = mGamePieceFreeList;
-        mGamePieceFreeList = gamePiece;
+        // Reset cells to initial state
+        Init();
     }
 
-    void GameBoard::PlaceGamePiece(int xBlock, int yBlock, int zBlock, const DirectX::XMVECTOR& color, int remainingTicks, GamePieceType gamePieceType)
+    void GameBoard::GetPosition(int xBlock, int yBlock, int zBlock, float positionOut[3]) const
     {
-        size_t index = CalcIndex(xBlock, yBlock, zBlock);
-        assert(mGamePieces[index] == nullptr);
-        
-        GamePiece* gamePiece = AllocGamePiece();
-        gamePiece->mRemainingTicks = remainingTicks;
-        gamePiece->mGamePieceType = gamePieceType;
-        gamePiece->mColor = color;
-        gamePiece->mPosition = GetPosition(xBlock, yBlock, zBlock);
-        mGamePieces[index] = gamePiece;
+        positionOut[0] = mBoardWorldScale[0] / static_cast<float>(mLayout.GetNumPieces(0)) * static_cast<float>(xBlock);
+        positionOut[1] = mBoardWorldScale[1] / static_cast<float>(mLayout.GetNumPieces(1)) * static_cast<float>(yBlock);
+        positionOut[2] = mBoardWorldScale[2] / static_cast<float>(mLayout.GetNumPieces(2)) * static_cast<float>(zBlock);
     }
 
-    void GameBoard:: RemoveGamePiece(int xBlock, int yBlock, int zBlock)
+    void GameBoard::GetBlockCoords(const float position[3], int& xBlockOut, int& yBlockOut, int& zBlockOut) const
     {
-        size_t index = CalcIndex(xBlock, yBlock, zBlock);
-        GamePiece* gamePiece = mGamePieces[index];
-        assert(gamePiece != nullptr);
+        float blockSizeX = mBoardWorldScale[0] / static_cast<float>(mLayout.GetNumPieces(0));
+        float blockSizeY = mBoardWorldScale[1] / static_cast<float>(mLayout.GetNumPieces(1));
+        float blockSizeZ = mBoardWorldScale[2] / static_cast<float>(mLayout.GetNumPieces(2));
+
+        xBlockOut = static_cast<int>(position[0] / blockSizeX);
+        yBlockOut = static_cast<int>(position[1] / blockSizeY);
+        zBlockOut = static_cast<int>(position[2] / blockSizeZ);
+    }
+
+    PieceColor GameBoard::GetGamePieceColor(size_t cellIndex) const
+    {
+        assert(mTypes[cellIndex] != GamePieceType::Empty);
+        if (mTypes[cellIndex] != GamePieceType::Wall)
+        {
+            return mOccupiedCells[mCellSlots[cellIndex]].mColor;
+        }
+
+        // Walls have no occupied slot; their color is that of the face owning the cell, which GetWallFace assigns
+        // by checking the x layers first, then y, then z
+        int block[3];
+        GetCellCoords(cellIndex, block[0], block[1], block[2]);
+        int face = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            int last = static_cast<int>(mLayout.GetNumPieces(axis)) - 1;
+            if (block[axis] == 0 || block[axis] == last)
+            {
+                face = axis * 2 + (block[axis] == last ? 1 : 0);
+                break;
+            }
+        }
+        return static_cast<PieceColor>(static_cast<int>(PieceColor::WallXmin) + face);
+    }
+
+    const OccupiedCell* GameBoard::GetOccupiedCells(size_t* outNumOccupiedCells) const
+    {
+        if (outNumOccupiedCells != nullptr)
+        {
+            *outNumOccupiedCells = mNumOccupiedCells;
+        }
+        return mOccupiedCells;
+    }
+
+    void GameBoard::InsertEmptyCell(size_t cellIndex)
+    {
+        assert(mNumEmptyCells < GetNumCells());
+
+        mEmptyCells[mNumEmptyCells] = static_cast<uint32_t>(cellIndex);
+        mCellSlots[cellIndex] = static_cast<uint32_t>(mNumEmptyCells);
+        mNumEmptyCells++;
+    }
+
+    void GameBoard::EraseEmptyCell(size_t cellIndex)
+    {
+        assert(mNumEmptyCells > 0);
+
+        // Swap last empty cell into the vacated slot
+        uint32_t slot = mCellSlots[cellIndex];
+        uint32_t lastCell = mEmptyCells[--mNumEmptyCells];
+        mEmptyCells[slot] = lastCell;
+        mCellSlots[lastCell] = slot;
+    }
+
+    void GameBoard::InsertOccupiedCell(size_t cellIndex, GamePieceType gamePieceType, PieceColor color)
+    {
+        assert(mNumOccupiedCells < GetNumCells());
+
+        OccupiedCell& occupiedCell = mOccupiedCells[mNumOccupiedCells];
+        occupiedCell.mCellIndex = static_cast<uint32_t>(cellIndex);
+        occupiedCell.mGamePieceType = gamePieceType;
+        occupiedCell.mColor = color;
+        mCellSlots[cellIndex] = static_cast<uint32_t>(mNumOccupiedCells);
+        mNumOccupiedCells++;
+    }
+
+    void GameBoard::EraseOccupiedCell(size_t cellIndex)
+    {
+        assert(mNumOccupiedCells > 0);
+
+        // Swap last occupied cell into the vacated slot
+        uint32_t slot = mCellSlots[cellIndex];
+        const OccupiedCell& lastCell = mOccupiedCells[--mNumOccupiedCells];
+        mOccupiedCells[slot] = lastCell;
+        mCellSlots[lastCell.mCellIndex] = slot;
+    }
+
+    void GameBoard::PlaceGamePiece(int xBlock, int yBlock, int zBlock, PieceColor color, GamePieceType gamePieceType)
+    {
+        assert(mOwnsStorage);
+        size_t index = GetCellIndex(xBlock, yBlock, zBlock);
+        assert(mTypes[index] == GamePieceType::Empty);
+        assert(gamePieceType != GamePieceType::Empty && gamePieceType != GamePieceType::Wall);
+
+        mTypes[index] = gamePieceType;
+        mHash ^= ZobristCellKey(index, static_cast<uint8_t>(gamePieceType));
+        EraseEmptyCell(index);
+        InsertOccupiedCell(index, gamePieceType, color);
+        mJournal.Record({ static_cast<uint32_t>(index), GamePieceType::Empty, gamePieceType, color });
+    }
+
+    void GameBoard::RemoveGamePiece(int xBlock, int yBlock, int zBlock)
+    {
+        assert(mOwnsStorage);
+        size_t index = GetCellIndex(xBlock, yBlock, zBlock);
+        assert(mTypes[index] != GamePieceType::Empty && mTypes[index] != GamePieceType::Wall);
+
+        const OccupiedCell& occupiedCell = mOccupiedCells[mCellSlots[index]];
+        mJournal.Record({ static_cast<uint32_t>(index), occupiedCell.mGamePieceType, GamePieceType::Empty, occupiedCell.mColor });
+
+        mHash ^= ZobristCellKey(index, static_cast<uint8_t>(mTypes[index]));
+        mTypes[index] = GamePieceType::Empty;
+        EraseOccupiedCell(index);
+        InsertEmptyCell(index);
+    }
+
+    void GameBoard::UndoPlaceGamePiece(size_t cellIndex, uint32_t emptySlot)
+    {
+        assert(mOwnsStorage);
+        GamePieceType gamePieceType = mTypes[cellIndex];
+        assert(gamePieceType != GamePieceType::Empty && gamePieceType != GamePieceType::Wall);
+        assert(mCellSlots[cellIndex] == mNumOccupiedCells - 1);
+        assert(emptySlot <= mNumEmptyCells);
+
+        mJournal.Record({ static_cast<uint32_t>(cellIndex), gamePieceType, GamePieceType::Empty, mOccupiedCells[mCellSlots[cellIndex]].mColor });
+        mHash ^= ZobristCellKey(cellIndex, static_cast<uint8_t>(gamePieceType));
+        mTypes[cellIndex] = GamePieceType::Empty;
+
+        // The piece was the last one listed; the cell that filled its empty slot goes back to the end
+        mNumOccupiedCells--;
+        if (emptySlot < mNumEmptyCells)
+        {
+            uint32_t movedCell = mEmptyCells[emptySlot];
+            mEmptyCells[mNumEmptyCells] = movedCell;
+            mCellSlots[movedCell] = static_cast<uint32_t>(mNumEmptyCells);
+        }
+        mEmptyCells[emptySlot] = static_cast<uint32_t>(cellIndex);
+        mCellSlots[cellIndex] = emptySlot;
+        mNumEmptyCells++;
+    }
+
+    void GameBoard::UndoRemoveGamePiece(size_t cellIndex, uint32_t occupiedSlot, PieceColor color, GamePieceType gamePieceType)
+    {
+        assert(mOwnsStorage);
+        assert(mTypes[cellIndex] == GamePieceType::Empty);
+        assert(mCellSlots[cellIndex] == mNumEmptyCells - 1);
+        assert(occupiedSlot <= mNumOccupiedCells);
+        assert(gamePieceType != GamePieceType::Empty && gamePieceType != GamePieceType::Wall);
+
+        mTypes[cellIndex] = gamePieceType;
+        mHash ^= ZobristCellKey(cellIndex, static_cast<uint8_t>(gamePieceType));
+
+        // The cell was the last one listed empty; the piece that filled its occupied slot goes back to the end
+        mNumEmptyCells--;
+        if (occupiedSlot < mNumOccupiedCells)
+        {
+            const OccupiedCell& movedCell = mOccupiedCells[occupiedSlot];
+            mOccupiedCells[mNumOccupiedCells] = movedCell;
+            mCellSlots[movedCell.mCellIndex] = static_cast<uint32_t>(mNumOccupiedCells);
+        }
+        mOccupiedCells[occupiedSlot] = { static_cast<uint32_t>(cellIndex), gamePieceType, color };
+        mCellSlots[cellIndex] = occupiedSlot;
+        mNumOccupiedCells++;
+
+        mJournal.Record({ static_cast<uint32_t>(cellIndex), GamePieceType::Empty, gamePieceType, color });
+    }
+
+    bool GameBoard::Restore(const uint32_t* emptyCells, size_t numEmptyCells, const OccupiedCell* occupiedCells, size_t numOccupiedCells)
+    {
+        Init();
+        if (numEmptyCells + numOccupiedCells != mLayout.GetNumInteriorCells())
+        {
+            return false;
+        }
+
+        // Occupying cells as they are listed rejects walls and repeats
+        for (size_t slot = 0; slot < numOccupiedCells; slot++)
+        {
+            const OccupiedCell& occupiedCell = occupiedCells[slot];
+            if (occupiedCell.mCellIndex >= GetNumCells() || mTypes[occupiedCell.mCellIndex] != GamePieceType::Empty ||
+                (occupiedCell.mGamePieceType != GamePieceType::SnakeBody && occupiedCell.mGamePieceType != GamePieceType::PowerUp) ||
+                occupiedCell.mColor >= PieceColor::Count)
+            {
+                Init();
+                return false;
+            }
+
+            mTypes[occupiedCell.mCellIndex] = occupiedCell.mGamePieceType;
+            mHash ^= ZobristCellKey(occupiedCell.mCellIndex, static_cast<uint8_t>(occupiedCell.mGamePieceType));
+            mOccupiedCells[slot] = occupiedCell;
+            mCellSlots[occupiedCell.mCellIndex] = static_cast<uint32_t>(slot);
+        }
+        mNumOccupiedCells = numOccupiedCells;
+
+        // The counts add up, so empty cells that are all interior, unoccupied and distinct are exactly the rest
+        for (size_t slot = 0; slot < numEmptyCells; slot++)
+        {
+            if (emptyCells[slot] >= GetNumCells() || mTypes[emptyCells[slot]] != GamePieceType::Empty)
+            {
+                Init();
+                return false;
+            }
+
+            mEmptyCells[slot] = emptyCells[slot];
+            mCellSlots[emptyCells[slot]] = static_cast<uint32_t>(slot);
+        }
+        for (size_t slot = 0; slot < numEmptyCells; slot++)
+        {
+            if (mCellSlots[emptyCells[slot]] != slot)
+            {
+                Init();
+                return false;
+            }
+        }
+        mNumEmptyCells = numEmptyCells;
 
-        FreeGamePiece(gamePiece);
-        mGamePieces[index] = nullptr;
+        mJournal.Invalidate();
+        return true;
     }
 
 } // namespace Snake
@@ -2,28 +2,45 @@
 
 #pragma once
 
-#include <DirectXMath.h>
+#include "BoardJournal.h"
+#include <cassert>
+#include <cstdint>
+#include <memory>
 
 namespace Snake
 {
-    enum class GamePieceType
+    enum class GamePieceType : uint8_t
     {
+        Empty,
         SnakeBody,
         PowerUp,
         Wall
     };
 
-    class GamePiece
+    // Index into the piece color palette
+    enum class PieceColor : uint8_t
+    {
+        SnakeBody,
+        PowerUp,
+        WallXmin,
+        WallXmax,
+        WallYmin,
+        WallYmax,
+        WallZmin,
+        WallZmax,
+        Count
+    };
+
+    // Returns the RGBA color for a palette entry
+    const float* GetPaletteColor(PieceColor color);
+
+    // Entry in the board's dense list of occupied cells
+    class OccupiedCell
     {
     public:
-        GamePiece() = default;
-        ~GamePiece() = default;
-
-        DirectX::XMVECTOR mColor;
-        DirectX::XMVECTOR mPosition;
-        GamePiece*        mNext;
-        int               mRemainingTicks;
-        GamePieceType     mGamePieceType;
+        uint32_t      mCellIndex;
+        GamePieceType mGamePieceType;
+        PieceColor    mColor;
     };
 
     constexpr size_t NumPiecesX = 16;
@@ -31,33 +48,221 @@ namespace Snake
     constexpr size_t NumPiecesZ = 16;
     constexpr size_t NumGamePieces = NumPiecesX * NumPiecesY * NumPiecesZ;
 
+    constexpr bool IsPowerOfTwo(size_t value)
+    {
+        return value != 0 && (value & (value - 1)) == 0;
+    }
+
+    constexpr size_t Log2(size_t value)
+    {
+        size_t result = 0;
+        while (value > 1)
+        {
+            value >>= 1;
+            result++;
+        }
+        return result;
+    }
+
+    // Board dimensions and the mapping between block coordinates and cell indices
+    // Boards whose x and y dimensions are powers of two index with shifts and masks instead of multiplies
+    class BoardLayout
+    {
+    public:
+        constexpr BoardLayout(size_t numPiecesX, size_t numPiecesY, size_t numPiecesZ)
+            : mNumPieces{ numPiecesX, numPiecesY, numPiecesZ }
+            , mUsesShifts(IsPowerOfTwo(numPiecesX) && IsPowerOfTwo(numPiecesY))
+            , mShiftY(Log2(numPiecesX))
+            , mShiftZ(Log2(numPiecesX) + Log2(numPiecesY))
+        {}
+
+        constexpr bool operator==(const BoardLayout& other) const
+        {
+            return mNumPieces[0] == other.mNumPieces[0] && mNumPieces[1] == other.mNumPieces[1] && mNumPieces[2] == other.mNumPieces[2];
+        }
+
+        constexpr size_t GetNumPieces(int axis) const { return mNumPieces[axis]; }
+        constexpr size_t GetNumCells() const          { return mNumPieces[0] * mNumPieces[1] * mNumPieces[2]; }
+        constexpr bool UsesShifts() const             { return mUsesShifts; }
+
+        constexpr size_t CalcIndex(int xBlock, int yBlock, int zBlock) const
+        {
+            return mUsesShifts ?
+                static_cast<size_t>(xBlock) | (static_cast<size_t>(yBlock) << mShiftY) | (static_cast<size_t>(zBlock) << mShiftZ) :
+                static_cast<size_t>(xBlock) + static_cast<size_t>(yBlock) * mNumPieces[0] + static_cast<size_t>(zBlock) * mNumPieces[0] * mNumPieces[1];
+        }
+
+        constexpr void CalcCoords(size_t cellIndex, int& xBlockOut, int& yBlockOut, int& zBlockOut) const
+        {
+            if (mUsesShifts)
+            {
+                xBlockOut = static_cast<int>(cellIndex & (mNumPieces[0] - 1));
+                yBlockOut = static_cast<int>((cellIndex >> mShiftY) & (mNumPieces[1] - 1));
+                zBlockOut = static_cast<int>(cellIndex >> mShiftZ);
+            }
+            else
+            {
+                xBlockOut = static_cast<int>(cellIndex % mNumPieces[0]);
+                yBlockOut = static_cast<int>((cellIndex / mNumPieces[0]) % mNumPieces[1]);
+                zBlockOut = static_cast<int>(cellIndex / (mNumPieces[0] * mNumPieces[1]));
+            }
+        }
+
+        // Walls are implicit and occupy the outermost layer of blocks along every axis
+        constexpr bool IsWall(int xBlock, int yBlock, int zBlock) const
+        {
+            return xBlock <= 0 || xBlock >= static_cast<int>(mNumPieces[0]) - 1 ||
+                   yBlock <= 0 || yBlock >= static_cast<int>(mNumPieces[1]) - 1 ||
+                   zBlock <= 0 || zBlock >= static_cast<int>(mNumPieces[2]) - 1;
+        }
+
+        constexpr size_t GetNumInteriorCells() const
+        {
+            return (mNumPieces[0] - 2) * (mNumPieces[1] - 2) * (mNumPieces[2] - 2);
+        }
+
+        // Inclusive block range covered by one of the six wall faces, in PieceColor::WallXmin..WallZmax order
+        // Faces partition the wall layer: x faces own their edges, then y faces, then z faces
+        void GetWallFace(int face, int minBlockOut[3], int maxBlockOut[3]) const
+        {
+            const int axis = face / 2;
+            for (int i = 0; i < 3; i++)
+            {
+                // Axes before this one belong to earlier faces, so stay clear of their layers
+                minBlockOut[i] = i < axis ? 1 : 0;
+                maxBlockOut[i] = static_cast<int>(mNumPieces[i]) - (i < axis ? 2 : 1);
+            }
+
+            minBlockOut[axis] = maxBlockOut[axis] = (face & 1) ? static_cast<int>(mNumPieces[axis]) - 1 : 0;
+        }
+
+    private:
+        size_t mNumPieces[3];
+        bool   mUsesShifts;
+        size_t mShiftY;
+        size_t mShiftZ;
+    };
+
+    constexpr int NumWallFaces = 6;
+
+    // Runtime-sized board; all per-cell storage lives in a single aligned heap block
+    // Boundary walls are implicit: their cells read as Wall but are never placed, listed as occupied or handed out as empty
+    // Cells are stored as structure of arrays, a couple of bytes each, so full board scans and copies stay in cache
     class GameBoard
     {
     public:
-        GameBoard() = default;
-        ~GameBoard() = default;
+        explicit GameBoard(const BoardLayout& layout);
+        // Read-only board over storage owned elsewhere, such as a mapped snapshot, laid out as GetStorage of a board with
+        // the same layout; the storage must outlive the board, and copies of the board own their storage again
+        GameBoard(const BoardLayout& layout, const void* storage, size_t numEmptyCells, size_t numOccupiedCells, uint64_t hash);
+        GameBoard(const GameBoard& other);
+        ~GameBoard();
+
+        GameBoard& operator=(const GameBoard& other);
 
         void Init();
         void Reset();
 
-        DirectX::XMVECTOR GetPosition(int xBlock, int yBlock, int zBlock) const;
-        void GetBlockCoords(const DirectX::XMVECTOR& position, int& xBlockOut, int& yBlockOut, int& zBlockOut) const;
-        const GamePiece* GetGamePiece(int xBlock, int yBlock, int zBlock) const;
-        GamePiece* GetGamePiece(int xBlock, int yBlock, int zBlock);
-        void PlaceGamePiece(int xBlock, int yBlock, int zBlock, const DirectX::XMVECTOR& color, int remainingTicks, GamePieceType gamePieceType);
+        const BoardLayout& GetLayout() const { return mLayout; }
+        size_t GetNumCells() const           { return mLayout.GetNumCells(); }
+        size_t GetStorageSize() const        { return mStorageSize; }
+        const void* GetStorage() const       { return mStorage; }
+        bool IsReadOnly() const              { return !mOwnsStorage; }
+        static size_t CalcStorageSize(const BoardLayout& layout);
+
+        void GetPosition(int xBlock, int yBlock, int zBlock, float positionOut[3]) const;
+        void GetBlockCoords(const float position[3], int& xBlockOut, int& yBlockOut, int& zBlockOut) const;
+        size_t GetCellIndex(int xBlock, int yBlock, int zBlock) const { return mLayout.CalcIndex(xBlock, yBlock, zBlock); }
+        void GetCellCoords(size_t cellIndex, int& xBlockOut, int& yBlockOut, int& zBlockOut) const { mLayout.CalcCoords(cellIndex, xBlockOut, yBlockOut, zBlockOut); }
+
+        bool IsWall(int xBlock, int yBlock, int zBlock) const                    { return mLayout.IsWall(xBlock, yBlock, zBlock); }
+        GamePieceType GetGamePieceType(int xBlock, int yBlock, int zBlock) const { return mTypes[GetCellIndex(xBlock, yBlock, zBlock)]; }
+        GamePieceType GetGamePieceType(size_t cellIndex) const                   { return mTypes[cellIndex]; }
+        PieceColor GetGamePieceColor(size_t cellIndex) const;
+        const GamePieceType* GetGamePieceTypes() const                           { return mTypes; }
+
+        // Occupied cells in no particular order, maintained incrementally so consumers only touch what exists
+        const OccupiedCell* GetOccupiedCells(size_t* outNumOccupiedCells) const;
+
+        void PlaceGamePiece(int xBlock, int yBlock, int zBlock, PieceColor color, GamePieceType gamePieceType);
         void RemoveGamePiece(int xBlock, int yBlock, int zBlock);
-        const GamePiece* const* GetGamePieces(size_t* outNumGamePieces) const;
+
+        // Exact inverses of the latest PlaceGamePiece or RemoveGamePiece still in effect, given the list slot the cell
+        // held before it. List order is restored too, so empty cell sampling after an undo repeats what it did before.
+        void UndoPlaceGamePiece(size_t cellIndex, uint32_t emptySlot);
+        void UndoRemoveGamePiece(size_t cellIndex, uint32_t occupiedSlot, PieceColor color, GamePieceType gamePieceType);
+
+        // Replaces every piece with the contents of the two lists, in their order, so the board samples empty cells exactly
+        // as the board they were taken from; false, leaving the board empty, if they do not partition its interior
+        bool Restore(const uint32_t* emptyCells, size_t numEmptyCells, const OccupiedCell* occupiedCells, size_t numOccupiedCells);
+
+        // Slot of a cell in the empty or the occupied list, whichever holds it
+        uint32_t GetCellSlot(size_t cellIndex) const { return mCellSlots[cellIndex]; }
+
+        // Zobrist hash of the piece type in every cell, updated with each change; an empty board hashes to zero
+        uint64_t GetHash() const { return mHash; }
+
+        // Every cell change is recorded here so consumers can update incrementally instead of rescanning the board
+        const BoardJournal& GetJournal() const  { return mJournal; }
+        BoardJournal& GetJournal()              { return mJournal; }
+
+        // Empty cell queries; sampling is constant time regardless of how full the board is
+        size_t EmptyCellCount() const { return mNumEmptyCells; }
+        const uint32_t* GetEmptyCells() const { return mEmptyCells; }
+        template<typename RandomGenerator> size_t SampleEmptyCell(RandomGenerator& randomGenerator) const;
 
     private:
-        // TODO: Turn GamePiecePool and mGamePieceFreeList (as well as corresponding alloc / free) into a pooled resource class
-        GamePiece  mGamePiecePool[NumGamePieces];   // Pool of all gamepieces, contains enough to fill board completely
-        GamePiece* mGamePieces[NumGamePieces];      // Locations on the board; can point to a game piece or be null
-        GamePiece* mGamePieceFreeList;              // Allocation convenience
+        BoardLayout    mLayout;
+        void*          mStorage = nullptr;          // Single allocation backing all of the arrays below
+        size_t         mStorageSize = 0;
+        size_t         mInitialStorageSize = 0;     // Bytes of the block restored by Init; the occupied list is excluded
+        bool           mOwnsStorage = true;
+        std::shared_ptr<const uint8_t[]> mInitialStorage;   // Baked post-Init prefix of the block, shared by boards with the same layout
 
-        float      mBoardWorldScale[3] = {static_cast<float>(NumPiecesX), static_cast<float>(NumPiecesY), static_cast<float>(NumPiecesZ)};        // Size of the board along world space axes
+        GamePieceType* mTypes;                      // Piece type per cell, Empty if unoccupied
+        OccupiedCell*  mOccupiedCells;              // Dense list of occupied cells, first mNumOccupiedCells entries are valid
+        uint32_t*      mEmptyCells;                 // Dense set of empty cell indices, first mNumEmptyCells entries are valid
+        uint32_t*      mCellSlots;                  // Cell index to slot in mEmptyCells or mOccupiedCells, depending on whether the cell is occupied
+        size_t         mNumOccupiedCells;
+        size_t         mNumEmptyCells;
+        uint64_t       mHash;
 
-        GamePiece* AllocGamePiece();
-        void FreeGamePiece(GamePiece*);
+        float          mBoardWorldScale[3];         // Size of the board along world space axes
+        BoardJournal   mJournal;                    // Not copied with the board; a copy starts out needing a resync
+
+        void AllocateStorage();
+        void AssignArrays();
+        void BuildInitialState();
+        void InsertEmptyCell(size_t cellIndex);
+        void EraseEmptyCell(size_t cellIndex);
+        void InsertOccupiedCell(size_t cellIndex, GamePieceType gamePieceType, PieceColor color);
+        void EraseOccupiedCell(size_t cellIndex);
     };
 
+    // Board with dimensions fixed at compile time, for code that wants constant-folded indexing and wall tests
+    template<size_t X, size_t Y, size_t Z> class FixedGameBoard : public GameBoard
+    {
+    public:
+        static constexpr BoardLayout Layout = BoardLayout(X, Y, Z);
+
+        FixedGameBoard() : GameBoard(Layout) {}
+        ~FixedGameBoard() = default;
+
+        static constexpr size_t CalcIndex(int xBlock, int yBlock, int zBlock) { return Layout.CalcIndex(xBlock, yBlock, zBlock); }
+        static constexpr bool IsWall(int xBlock, int yBlock, int zBlock)      { return Layout.IsWall(xBlock, yBlock, zBlock); }
+    };
+
+    using DefaultGameBoard = FixedGameBoard<NumPiecesX, NumPiecesY, NumPiecesZ>;
+
+    // Returns the index of a uniformly chosen empty cell; board must not be full
+    template<typename RandomGenerator> size_t GameBoard::SampleEmptyCell(RandomGenerator& randomGenerator) const
+    {
+        assert(mNumEmptyCells > 0);
+
+        // Multiply-shift rather than std::uniform_int_distribution, whose mapping differs between standard libraries
+        static_assert(RandomGenerator::min() == 0 && RandomGenerator::max() >= UINT32_MAX, "Generator must produce at least 32 random bits");
+        uint64_t draw = static_cast<uint32_t>(randomGenerator());
+        return mEmptyCells[(draw * mNumEmptyCells) >> 32];
+    }
+
 } // namespace Snake
@@ -0,0 +1,107 @@
+// SnakeBody.cpp
+
+#include "SnakeBody.h"
+#include <cassert>
+#include <cstring>
+
+namespace Snake
+{
+    void SnakeBody::Init(size_t maxLength)
+    {
+        size_t capacity = 1;
+        while (capacity < maxLength)
+        {
+            capacity <<= 1;
+        }
+
+        mCells.reset(new uint32_t[capacity]);
+        mCapacityMask = capacity - 1;
+        Reset();
+    }
+
+    SnakeBody::SnakeBody(const SnakeBody& other)
+    {
+        *this = other;
+    }
+
+    SnakeBody& SnakeBody::operator=(const SnakeBody& other)
+    {
+        if (this != &other)
+        {
+            if (mCapacityMask != other.mCapacityMask || mCells == nullptr)
+            {
+                mCells.reset(other.mCells != nullptr ? new uint32_t[other.mCapacityMask + 1] : nullptr);
+                mCapacityMask = other.mCapacityMask;
+            }
+
+            if (mCells != nullptr)
+            {
+                memcpy(mCells.get(), other.mCells.get(), (mCapacityMask + 1) * sizeof(uint32_t));
+            }
+            mTail = other.mTail;
+            mLength = other.mLength;
+        }
+
+        return *this;
+    }
+
+    void SnakeBody::Reset()
+    {
+        mTail = 0;
+        mLength = 0;
+    }
+
+    void SnakeBody::PushHead(size_t cellIndex)
+    {
+        assert(mLength <= mCapacityMask);
+
+        mCells[(mTail + mLength) & mCapacityMask] = static_cast<uint32_t>(cellIndex);
+        mLength++;
+    }
+
+    size_t SnakeBody::PopTail()
+    {
+        assert(mLength > 0);
+
+        size_t cellIndex = mCells[mTail];
+        mTail = (mTail + 1) & mCapacityMask;
+        mLength--;
+        return cellIndex;
+    }
+
+    size_t SnakeBody::PopHead()
+    {
+        assert(mLength > 0);
+
+        mLength--;
+        return mCells[(mTail + mLength) & mCapacityMask];
+    }
+
+    void SnakeBody::PushTail(size_t cellIndex)
+    {
+        assert(mLength <= mCapacityMask);
+
+        mTail = (mTail - 1) & mCapacityMask;
+        mCells[mTail] = static_cast<uint32_t>(cellIndex);
+        mLength++;
+    }
+
+    size_t SnakeBody::GetHead() const
+    {
+        assert(mLength > 0);
+        return mCells[(mTail + mLength - 1) & mCapacityMask];
+    }
+
+    size_t SnakeBody::GetTail() const
+    {
+        assert(mLength > 0);
+        return mCells[mTail];
+    }
+
+    size_t SnakeBody::GetCell(size_t indexFromTail) const
+    {
+        assert(indexFromTail < mLength);
+        return mCells[(mTail + indexFromTail) & mCapacityMask];
+    }
+
+} // namespace Snake
@@ -0,0 +1,44 @@
+// SnakeBody.h
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Snake
+{
+    // Fixed-capacity ring buffer of the board cells occupied by the snake, ordered from tail to head
+    class SnakeBody
+    {
+    public:
+        SnakeBody() = default;
+        SnakeBody(const SnakeBody& other);
+        SnakeBody(SnakeBody&& other) = default;
+        ~SnakeBody() = default;
+
+        SnakeBody& operator=(const SnakeBody& other);
+        SnakeBody& operator=(SnakeBody&& other) = default;
+
+        void Init(size_t maxLength);
+        void Reset();
+        void PushHead(size_t cellIndex);
+        size_t PopTail();
+
+        // Inverses of PushHead and PopTail, for undoing steps
+        size_t PopHead();
+        void PushTail(size_t cellIndex);
+
+        size_t GetHead() const;
+        size_t GetTail() const;
+        size_t GetCell(size_t indexFromTail) const;
+        size_t GetLength() const { return mLength; }
+
+    private:
+        std::unique_ptr<uint32_t[]> mCells;
+        size_t   mCapacityMask = 0;     // Capacity is a power of two so wrapping is a mask
+        size_t   mTail = 0;
+        size_t   mLength = 0;
+    };
+
+} // namespace Snake
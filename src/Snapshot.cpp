@@ -0,0 +1,142 @@
+// Snapshot.cpp
+
+#include "Snapshot.h"
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace Snake
+{
+    static_assert(std::is_trivially_copyable<SnapshotHeader>::value, "Snapshot headers are stored as raw bytes");
+
+    namespace
+    {
+        const char SnapshotMagic[4] = { 'S', '3', 'D', 'S' };
+
+        constexpr uint64_t BoardAlignment = 64;
+
+        uint64_t CalcBoardOffset(uint64_t numBodyCells)
+        {
+            uint64_t bodyEnd = sizeof(SnapshotHeader) + numBodyCells * sizeof(uint32_t);
+            return (bodyEnd + BoardAlignment - 1) & ~(BoardAlignment - 1);
+        }
+
+        FILE* OpenFile(const char* path, const char* mode)
+        {
+#if defined(_MSC_VER)
+            FILE* file = nullptr;
+            return fopen_s(&file, path, mode) == 0 ? file : nullptr;
+#else
+            return fopen(path, mode);
+#endif
+        }
+    }
+
+    bool SaveSnapshot(const char* path, const Simulation& simulation, const SnapshotCamera* cameras, int numCameras)
+    {
+        assert(numCameras >= 0 && numCameras <= SnapshotHeader::NumCameras);
+
+        const GameBoard& board = simulation.GetBoard();
+        const SnakeBody& body = simulation.GetBody();
+
+        SnapshotHeader header = {};
+        memcpy(header.mMagic, SnapshotMagic, sizeof(SnapshotMagic));
+        header.mVersion = SnapshotHeader::Version;
+        header.mByteOrderMark = SnapshotHeader::ByteOrderMark;
+        header.mHeaderSize = sizeof(SnapshotHeader);
+        for (int axis = 0; axis < 3; axis++)
+        {
+            header.mNumPieces[axis] = static_cast<uint32_t>(board.GetLayout().GetNumPieces(axis));
+        }
+        header.mNumBodyCells = static_cast<uint32_t>(body.GetLength());
+        size_t numOccupiedCells;
+        board.GetOccupiedCells(&numOccupiedCells);
+        header.mNumEmptyCells = board.EmptyCellCount();
+        header.mNumOccupiedCells = numOccupiedCells;
+        header.mBoardHash = board.GetHash();
+        header.mBoardOffset = CalcBoardOffset(header.mNumBodyCells);
+        header.mBoardSize = board.GetStorageSize();
+        simulation.GetState(header.mState);
+        for (int i = 0; i < numCameras; i++)
+        {
+            header.mCameras[i] = cameras[i];
+        }
+
+        // The body is a ring buffer, so it is laid out from the tail, along with the padding before the board
+        std::vector<uint32_t> bodyCells((header.mBoardOffset - sizeof(SnapshotHeader)) / sizeof(uint32_t), 0);
+        for (size_t i = 0; i < body.GetLength(); i++)
+        {
+            bodyCells[i] = static_cast<uint32_t>(body.GetCell(i));
+        }
+
+        FILE* file = OpenFile(path, "wb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+            fwrite(bodyCells.data(), sizeof(uint32_t), bodyCells.size(), file) == bodyCells.size() &&
+            fwrite(board.GetStorage(), 1, board.GetStorageSize(), file) == board.GetStorageSize();
+        return (fclose(file) == 0) && written;
+    }
+
+    bool Snapshot::Open(const char* path)
+    {
+        Close();
+        if (!mFile.Open(path) || mFile.GetSize() < sizeof(SnapshotHeader))
+        {
+            Close();
+            return false;
+        }
+
+        const SnapshotHeader& header = GetHeader();
+        bool valid = memcmp(header.mMagic, SnapshotMagic, sizeof(SnapshotMagic)) == 0 &&
+            header.mVersion == SnapshotHeader::Version &&
+            header.mByteOrderMark == SnapshotHeader::ByteOrderMark &&
+            header.mHeaderSize == sizeof(SnapshotHeader);
+
+        uint64_t numCells = 1;
+        for (int axis = 0; valid && axis < 3; axis++)
+        {
+            valid = header.mNumPieces[axis] >= 3 && header.mNumPieces[axis] <= UINT32_MAX / numCells;
+            numCells *= header.mNumPieces[axis];
+        }
+
+        // Everything the board view and Restore index with must lie inside the file
+        valid = valid &&
+            header.mNumBodyCells <= numCells && header.mNumEmptyCells <= numCells && header.mNumOccupiedCells <= numCells &&
+            header.mBoardOffset == CalcBoardOffset(header.mNumBodyCells) &&
+            header.mBoardSize == GameBoard::CalcStorageSize(header.GetLayout()) &&
+            header.mBoardSize <= mFile.GetSize() && header.mBoardOffset <= mFile.GetSize() - header.mBoardSize &&
+            header.mNumEmptyCells + header.mNumOccupiedCells == header.GetLayout().GetNumInteriorCells();
+        if (!valid)
+        {
+            Close();
+            return false;
+        }
+
+        mBoard = std::make_unique<GameBoard>(header.GetLayout(), mFile.GetData() + header.mBoardOffset,
+            header.mNumEmptyCells, header.mNumOccupiedCells, header.mBoardHash);
+        return true;
+    }
+
+    void Snapshot::Close()
+    {
+        mBoard.reset();
+        mFile.Close();
+    }
+
+    bool Snapshot::Restore(Simulation& simulation) const
+    {
+        if (mBoard == nullptr)
+        {
+            return false;
+        }
+
+        const SnapshotHeader& header = GetHeader();
+        return simulation.SetState(header.mState, GetBodyCells(), header.mNumBodyCells, *mBoard);
+    }
+
+} // namespace Snake
@@ -0,0 +1,81 @@
+// Snapshot.h
+
+#pragma once
+
+#include "MappedFile.h"
+#include "Simulation.h"
+#include <memory>
+
+namespace Snake
+{
+    // Camera pose in board space; the application decides what each slot holds, the game itself needs none
+    class SnapshotCamera
+    {
+    public:
+        float mPosition[3];
+        float mForward[3];
+        float mUp[3];
+        float mRight[3];
+    };
+
+    // Start of a snapshot file, stored as is in native byte order; files from another byte order or struct layout are
+    // refused rather than converted. The snake body follows as u32 cells from tail to head, then at mBoardOffset, 64-byte
+    // aligned, the board's storage block exactly as GameBoard::GetStorage holds it, so a mapped snapshot serves as a board
+    // in place.
+    class SnapshotHeader
+    {
+    public:
+        static constexpr uint32_t Version = 1;
+        static constexpr uint32_t ByteOrderMark = 0x01020304;
+        static constexpr int NumCameras = 4;
+
+        char            mMagic[4];
+        uint32_t        mVersion;
+        uint32_t        mByteOrderMark;
+        uint32_t        mHeaderSize;
+        uint32_t        mNumPieces[3];
+        uint32_t        mNumBodyCells;
+        uint64_t        mNumEmptyCells;
+        uint64_t        mNumOccupiedCells;
+        uint64_t        mBoardHash;
+        uint64_t        mBoardOffset;
+        uint64_t        mBoardSize;
+        SimulationState mState;
+        SnapshotCamera  mCameras[NumCameras];
+
+        BoardLayout GetLayout() const { return BoardLayout(mNumPieces[0], mNumPieces[1], mNumPieces[2]); }
+    };
+
+    // Writes the game, and up to NumCameras camera poses, with a handful of writes whatever the board size
+    bool SaveSnapshot(const char* path, const Simulation& simulation, const SnapshotCamera* cameras = nullptr, int numCameras = 0);
+
+    // Read-only view of a mapped snapshot file
+    // Opening checks the header against the file and nothing else, so it takes the same time for any board size; cell
+    // contents are trusted, and Restore only checks that the head and body agree with the board.
+    class Snapshot
+    {
+    public:
+        Snapshot() = default;
+        ~Snapshot() = default;
+
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+
+        bool Open(const char* path);
+        void Close();
+
+        const SnapshotHeader& GetHeader() const { return *reinterpret_cast<const SnapshotHeader*>(mFile.GetData()); }
+        const uint32_t* GetBodyCells() const    { return reinterpret_cast<const uint32_t*>(mFile.GetData() + sizeof(SnapshotHeader)); }
+
+        // Board backed by the mapping itself, valid until the snapshot closes
+        const GameBoard& GetBoard() const       { return *mBoard; }
+
+        // Copies the game into a Simulation with the same board layout
+        bool Restore(Simulation& simulation) const;
+
+    private:
+        Vnm::MappedFile            mFile;
+        std::unique_ptr<GameBoard> mBoard;
+    };
+
+} // namespace Snake
@@ -0,0 +1,942 @@
+// SoftwareRenderer.cpp
+
+#include "SoftwareRenderer.h"
+#include "SceneAssets.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RASTER_SSE2
+#endif
+
+namespace Vnm
+{
+    namespace
+    {
+        constexpr size_t   InstancesPerBatch = 64;
+        constexpr uint32_t NoTriangle = UINT32_MAX;
+        constexpr int      NumAttributes = 6;       // Vertex color, then texture coordinates
+        constexpr int      BlockSize = 8;           // Pixels per side of the blocks tiles are rasterized in
+
+        // Clipping x and y to a band this many half-viewports wide keeps screen coordinates small enough for float edge
+        // functions; anything between the band and the viewport is discarded per pixel like a scissor
+        constexpr float GuardBand = 8.0f;
+
+        // Outcode bits, one per clip-space plane
+        constexpr uint32_t ClipLeft = 1 << 0;
+        constexpr uint32_t ClipRight = 1 << 1;
+        constexpr uint32_t ClipBottom = 1 << 2;
+        constexpr uint32_t ClipTop = 1 << 3;
+        constexpr uint32_t ClipNear = 1 << 4;
+        constexpr uint32_t ClipFar = 1 << 5;
+        constexpr uint32_t ClipGuardLeft = 1 << 6;
+        constexpr uint32_t ClipGuardRight = 1 << 7;
+        constexpr uint32_t ClipGuardBottom = 1 << 8;
+        constexpr uint32_t ClipGuardTop = 1 << 9;
+
+        // Planes triangles are actually cut against; the rest only reject whole triangles, the pixel loop handles any
+        // partial overlap
+        constexpr uint32_t ClippedPlanes = ClipNear | ClipGuardLeft | ClipGuardRight | ClipGuardBottom | ClipGuardTop;
+        constexpr int MaxClipVertices = 3 + 5;      // Each clipped plane adds at most one vertex
+
+        uint32_t CalcOutcode(const float position[4])
+        {
+            float x = position[0];
+            float y = position[1];
+            float z = position[2];
+            float w = position[3];
+            float guardW = GuardBand * w;
+            return (x < -w ? ClipLeft : 0) | (x > w ? ClipRight : 0) | (y < -w ? ClipBottom : 0) | (y > w ? ClipTop : 0) |
+                (z < 0.0f ? ClipNear : 0) | (z > w ? ClipFar : 0) |
+                (x < -guardW ? ClipGuardLeft : 0) | (x > guardW ? ClipGuardRight : 0) |
+                (y < -guardW ? ClipGuardBottom : 0) | (y > guardW ? ClipGuardTop : 0);
+        }
+
+        // Signed distance in clip space, non-negative on the kept side
+        float CalcPlaneDistance(uint32_t plane, const float position[4])
+        {
+            switch (plane)
+            {
+            case ClipNear:          return position[2];
+            case ClipGuardLeft:     return GuardBand * position[3] + position[0];
+            case ClipGuardRight:    return GuardBand * position[3] - position[0];
+            case ClipGuardBottom:   return GuardBand * position[3] + position[1];
+            default:                return GuardBand * position[3] - position[1];
+            }
+        }
+
+        FILE* OpenFile(const char* path, const char* mode)
+        {
+#if defined(_MSC_VER)
+            FILE* file = nullptr;
+            return fopen_s(&file, path, mode) == 0 ? file : nullptr;
+#else
+            return fopen(path, mode);
+#endif
+        }
+
+        // One pixel's RGBA, shaded with the same arithmetic as PsMain
+#if defined(RASTER_SSE2)
+        class Float4
+        {
+        public:
+            explicit Float4(__m128 value) : mValue(value) {}
+            explicit Float4(float value) : mValue(_mm_set1_ps(value)) {}
+
+            static Float4 Load(const float* values)     { return Float4(_mm_loadu_ps(values)); }
+
+            Float4 operator+(Float4 rhs) const          { return Float4(_mm_add_ps(mValue, rhs.mValue)); }
+            Float4 operator-(Float4 rhs) const          { return Float4(_mm_sub_ps(mValue, rhs.mValue)); }
+            Float4 operator*(Float4 rhs) const          { return Float4(_mm_mul_ps(mValue, rhs.mValue)); }
+            Float4 Saturate() const                     { return Float4(_mm_min_ps(_mm_max_ps(mValue, _mm_setzero_ps()), _mm_set1_ps(1.0f))); }
+
+            // Saturated and rounded to UNORM8, lane 0 in the lowest byte
+            uint32_t PackUnorm() const
+            {
+                __m128i bytes = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(Saturate().mValue, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+                bytes = _mm_packs_epi32(bytes, bytes);
+                bytes = _mm_packus_epi16(bytes, bytes);
+                return static_cast<uint32_t>(_mm_cvtsi128_si32(bytes));
+            }
+
+        private:
+            __m128 mValue;
+        };
+#else
+        class Float4
+        {
+        public:
+            explicit Float4(float value) : mValues{ value, value, value, value } {}
+            Float4(float x, float y, float z, float w) : mValues{ x, y, z, w } {}
+
+            static Float4 Load(const float* values)     { return Float4(values[0], values[1], values[2], values[3]); }
+
+            Float4 operator+(Float4 rhs) const
+            {
+                return Float4(mValues[0] + rhs.mValues[0], mValues[1] + rhs.mValues[1], mValues[2] + rhs.mValues[2], mValues[3] + rhs.mValues[3]);
+            }
+            Float4 operator-(Float4 rhs) const
+            {
+                return Float4(mValues[0] - rhs.mValues[0], mValues[1] - rhs.mValues[1], mValues[2] - rhs.mValues[2], mValues[3] - rhs.mValues[3]);
+            }
+            Float4 operator*(Float4 rhs) const
+            {
+                return Float4(mValues[0] * rhs.mValues[0], mValues[1] * rhs.mValues[1], mValues[2] * rhs.mValues[2], mValues[3] * rhs.mValues[3]);
+            }
+            Float4 Saturate() const
+            {
+                return Float4(Saturate(mValues[0]), Saturate(mValues[1]), Saturate(mValues[2]), Saturate(mValues[3]));
+            }
+
+            uint32_t PackUnorm() const
+            {
+                uint32_t packed = 0;
+                for (int i = 0; i < 4; i++)
+                {
+                    packed |= static_cast<uint32_t>(static_cast<int>(Saturate(mValues[i]) * 255.0f + 0.5f)) << (8 * i);
+                }
+                return packed;
+            }
+
+        private:
+            // NaN goes to zero, as with SSE min and max
+            static float Saturate(float value)          { return value > 0.0f ? (value < 1.0f ? value : 1.0f) : 0.0f; }
+
+            float mValues[4];
+        };
+#endif
+
+        Float4 Lerp(Float4 from, Float4 to, float t)
+        {
+            return from + (to - from) * Float4(t);
+        }
+
+        // Texture coordinates stay near [0, 1], so truncation cannot overflow; avoids a library call without SSE4.1
+        int FloorToInt(float value)
+        {
+            int truncated = static_cast<int>(value);
+            return truncated - (value < static_cast<float>(truncated) ? 1 : 0);
+        }
+
+        // The texture is sRGB on the GPU, so the sampler filters decoded values
+        float SrgbToLinear(uint8_t value)
+        {
+            float encoded = static_cast<float>(value) * (1.0f / 255.0f);
+            return encoded <= 0.04045f ? encoded * (1.0f / 12.92f) : std::pow((encoded + 0.055f) * (1.0f / 1.055f), 2.4f);
+        }
+    }
+
+    class SoftwareRenderer::ClipVertex
+    {
+    public:
+        float mPosition[4];
+        float mAttributes[NumAttributes];
+    };
+
+    // Screen-space triangle set up for rasterizing, its vertices ordered so edge functions are positive inside whatever
+    // the original winding
+    // Planes are gradients along x and y plus the value at the first vertex
+    class SoftwareRenderer::Triangle
+    {
+    public:
+        // Edge functions A * (x - x0) + B * (y - y0), positive inside; each edge is anchored at its lexicographically
+        // smaller endpoint, so a shared edge evaluates to exactly the negated value in the neighboring triangle
+        float mEdgeA[3];
+        float mEdgeB[3];
+        float mEdgeOrigin[3][2];
+        float mEdgeThreshold[3];    // -FLT_MIN on top and left edges, so pixel centers exactly on them count as inside
+
+        float mOrigin[2];
+        float mDepth[3];            // z / w
+        float mInvW[3];
+        float mTexcoord[2][3];      // u / w, v / w
+        float mColor[3][4];         // Vertex color / w, gradients first
+        float mInstanceColor[4];
+
+        int   mMinX;                // Pixel bounds inside the image, max exclusive
+        int   mMinY;
+        int   mMaxX;
+        int   mMaxY;
+    };
+
+    class SoftwareRenderer::Batch
+    {
+    public:
+        std::vector<Triangle>              mTriangles;
+        std::vector<std::vector<uint32_t>> mTileBins;   // Indices into mTriangles per tile, in submission order
+    };
+
+    class SoftwareRenderer::TileScratch
+    {
+    public:
+        alignas(16) float    mDepth[TileSize * TileSize];
+        alignas(16) uint32_t mTriangleIds[TileSize * TileSize];     // Nearest triangle per pixel, indexing mTriangles
+        float                mBlockMaxDepth[(TileSize / BlockSize) * (TileSize / BlockSize)];  // Farthest depth per block
+        std::vector<const Triangle*> mTriangles;
+    };
+
+    SoftwareRenderer::SoftwareRenderer(WorkStealingPool& pool, int width, int height)
+        : mPool(pool)
+        , mWidth(width)
+        , mHeight(height)
+        , mNumTilesX((width + TileSize - 1) / TileSize)
+        , mNumTilesY((height + TileSize - 1) / TileSize)
+        , mPixels(static_cast<size_t>(width) * static_cast<size_t>(height), 0)
+        , mTexture(CheckerTextureWidth * CheckerTextureHeight * 4)
+    {
+        assert(width > 0 && height > 0);
+        static_assert(TileSize % BlockSize == 0 && BlockSize == 8, "Blocks are rasterized as two groups of four pixels per row");
+        static_assert((CheckerTextureWidth & (CheckerTextureWidth - 1)) == 0 && (CheckerTextureHeight & (CheckerTextureHeight - 1)) == 0,
+            "Texture wrapping masks coordinates");
+
+        std::vector<char> texels(CheckerTextureWidth * CheckerTextureHeight * CheckerTextureBpp);
+        InitCheckerTexture(texels.data(), CheckerTextureWidth, CheckerTextureHeight, CheckerTextureBpp);
+        for (size_t i = 0; i < mTexture.size(); i++)
+        {
+            uint8_t texel = static_cast<uint8_t>(texels[i]);
+            mTexture[i] = i % 4 == 3 ? static_cast<float>(texel) * (1.0f / 255.0f) : SrgbToLinear(texel);
+        }
+
+        for (size_t i = 0; i < pool.GetNumThreads(); i++)
+        {
+            mScratch.push_back(std::make_unique<TileScratch>());
+        }
+
+        float view[16] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+        BeginFrame(view);
+    }
+
+    SoftwareRenderer::~SoftwareRenderer() = default;
+
+    void SoftwareRenderer::BeginFrame(const float view[16])
+    {
+        float aspectRatio = static_cast<float>(mWidth) / static_cast<float>(mHeight);
+        float projection[16];
+        CalcProjection(aspectRatio, projection);
+        MultiplyMatrices(view, projection, mViewProj);
+
+        // The view is a rotation and a translation, so the camera sits at minus the translation rotated back
+        for (int axis = 0; axis < 3; axis++)
+        {
+            mCameraPosition[axis] = -(view[12] * view[axis * 4 + 0] + view[13] * view[axis * 4 + 1] + view[14] * view[axis * 4 + 2]);
+        }
+
+        // Back faces of a closed box are hidden behind its front faces unless the near plane cuts the front ones away,
+        // which needs part of the box within the distance of the near plane's corners
+        float tanY = std::tan(0.5f * FieldOfViewY);
+        float tanX = tanY * aspectRatio;
+        mNearCullDistanceSq = 1.01f * NearZ * NearZ * (1.0f + tanX * tanX + tanY * tanY);
+
+        mInstances.clear();
+    }
+
+    void SoftwareRenderer::SubmitInstances(const Snake::RenderInstance* instances, size_t numInstances)
+    {
+        mInstances.insert(mInstances.end(), instances, instances + numInstances);
+    }
+
+    void SoftwareRenderer::EndFrame()
+    {
+        mNumBatches = (mInstances.size() + InstancesPerBatch - 1) / InstancesPerBatch;
+        if (mBatches.size() < mNumBatches)
+        {
+            mBatches.resize(mNumBatches);
+        }
+
+        mPool.ParallelFor(mNumBatches, [this](size_t, size_t batchIndex) { ProcessBatch(batchIndex); });
+        mPool.ParallelFor(static_cast<size_t>(mNumTilesX) * static_cast<size_t>(mNumTilesY),
+            [this](size_t workerIndex, size_t tileIndex) { RenderTile(tileIndex, *mScratch[workerIndex]); });
+
+        mNumTriangles = 0;
+        mNumBinnedTriangles = 0;
+        for (size_t i = 0; i < mNumBatches; i++)
+        {
+            mNumTriangles += mBatches[i].mTriangles.size();
+            for (const std::vector<uint32_t>& bin : mBatches[i].mTileBins)
+            {
+                mNumBinnedTriangles += bin.size();
+            }
+        }
+    }
+
+    bool SoftwareRenderer::SaveImage(const char* path) const
+    {
+        FILE* file = OpenFile(path, "wb");
+        if (file == nullptr)
+        {
+            return false;
+        }
+
+        bool written = fprintf(file, "P6\n%d %d\n255\n", mWidth, mHeight) > 0;
+        std::vector<uint8_t> row(static_cast<size_t>(mWidth) * 3);
+        for (int y = 0; written && y < mHeight; y++)
+        {
+            const uint32_t* pixels = &mPixels[static_cast<size_t>(y) * static_cast<size_t>(mWidth)];
+            for (int x = 0; x < mWidth; x++)
+            {
+                row[x * 3 + 0] = static_cast<uint8_t>(pixels[x]);
+                row[x * 3 + 1] = static_cast<uint8_t>(pixels[x] >> 8);
+                row[x * 3 + 2] = static_cast<uint8_t>(pixels[x] >> 16);
+            }
+            written = fwrite(row.data(), 1, row.size(), file) == row.size();
+        }
+        return (fclose(file) == 0) && written;
+    }
+
+    void SoftwareRenderer::ProcessBatch(size_t batchIndex)
+    {
+        Batch& batch = mBatches[batchIndex];
+        batch.mTriangles.clear();
+        batch.mTileBins.resize(static_cast<size_t>(mNumTilesX) * static_cast<size_t>(mNumTilesY));
+        for (std::vector<uint32_t>& bin : batch.mTileBins)
+        {
+            bin.clear();
+        }
+
+        size_t end = std::min(mInstances.size(), (batchIndex + 1) * InstancesPerBatch);
+        for (size_t i = batchIndex * InstancesPerBatch; i < end; i++)
+        {
+            AddInstance(mInstances[i], batch);
+        }
+    }
+
+    void SoftwareRenderer::AddInstance(const Snake::RenderInstance& instance, Batch& batch) const
+    {
+        // Clip position is p * Scale(extent) * Translate(center) * viewProj, as in D3d12Renderer
+        float center[4];
+        for (int i = 0; i < 4; i++)
+        {
+            center[i] = instance.mCenter[0] * mViewProj[i] + instance.mCenter[1] * mViewProj[4 + i] +
+                instance.mCenter[2] * mViewProj[8 + i] + mViewProj[12 + i];
+        }
+
+        ClipVertex vertices[NumCubeVertices];
+        uint32_t outcodes[NumCubeVertices];
+        uint32_t allOutside = ~0u;
+        for (int v = 0; v < NumCubeVertices; v++)
+        {
+            const CubeVertex& cubeVertex = CubeVertices[v];
+            for (int i = 0; i < 4; i++)
+            {
+                vertices[v].mPosition[i] = center[i] +
+                    cubeVertex.mPosition[0] * instance.mExtent[0] * mViewProj[i] +
+                    cubeVertex.mPosition[1] * instance.mExtent[1] * mViewProj[4 + i] +
+                    cubeVertex.mPosition[2] * instance.mExtent[2] * mViewProj[8 + i];
+                vertices[v].mAttributes[i] = cubeVertex.mColor[i];
+            }
+            vertices[v].mAttributes[4] = cubeVertex.mTexcoord[0];
+            vertices[v].mAttributes[5] = cubeVertex.mTexcoord[1];
+
+            outcodes[v] = CalcOutcode(vertices[v].mPosition);
+            allOutside &= outcodes[v];
+        }
+        if ((allOutside & (ClipLeft | ClipRight | ClipBottom | ClipTop | ClipNear | ClipFar)) != 0)
+        {
+            return;
+        }
+
+        float distanceSq = 0.0f;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            float outside = std::fabs(mCameraPosition[axis] - instance.mCenter[axis]) - 0.5f * instance.mExtent[axis];
+            distanceSq += outside > 0.0f ? outside * outside : 0.0f;
+        }
+        bool drawBackFaces = distanceSq < mNearCullDistanceSq;
+
+        const float* color = Snake::GetPaletteColor(instance.mColor);
+        for (int face = 0; face < NumCubeFaces; face++)
+        {
+            if (!drawBackFaces)
+            {
+                const float* normal = CubeFaceNormals[face];
+                float facing = 0.0f;
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    float faceCenter = instance.mCenter[axis] + 0.5f * normal[axis] * instance.mExtent[axis];
+                    facing += (mCameraPosition[axis] - faceCenter) * normal[axis];
+                }
+                if (facing <= 0.0f)
+                {
+                    continue;
+                }
+            }
+
+            for (int i = face * 6; i < face * 6 + 6; i += 3)
+            {
+                uint32_t index0 = CubeIndices[i];
+                uint32_t index1 = CubeIndices[i + 1];
+                uint32_t index2 = CubeIndices[i + 2];
+                if ((outcodes[index0] & outcodes[index1] & outcodes[index2] & ~ClippedPlanes) != 0)
+                {
+                    continue;
+                }
+
+                const ClipVertex* triangle[3] = { &vertices[index0], &vertices[index1], &vertices[index2] };
+                uint32_t clipPlanes = (outcodes[index0] | outcodes[index1] | outcodes[index2]) & ClippedPlanes;
+                if (clipPlanes != 0)
+                {
+                    AddClippedTriangle(triangle, clipPlanes, color, batch);
+                }
+                else
+                {
+                    AddTriangle(triangle, color, batch);
+                }
+            }
+        }
+    }
+
+    void SoftwareRenderer::AddClippedTriangle(const ClipVertex* vertices[3], uint32_t clipPlanes, const float color[4], Batch& batch) const
+    {
+        ClipVertex polygons[2][MaxClipVertices];
+        int numVertices = 3;
+        for (int i = 0; i < 3; i++)
+        {
+            polygons[0][i] = *vertices[i];
+        }
+
+        int current = 0;
+        for (uint32_t plane = ClipNear; plane <= ClipGuardTop && numVertices >= 3; plane <<= 1)
+        {
+            if ((clipPlanes & plane) == 0)
+            {
+                continue;
+            }
+
+            const ClipVertex* in = polygons[current];
+            ClipVertex* out = polygons[current ^ 1];
+            int numOut = 0;
+            for (int i = 0; i < numVertices; i++)
+            {
+                const ClipVertex& vertex = in[i];
+                const ClipVertex& next = in[i + 1 < numVertices ? i + 1 : 0];
+                float distance = CalcPlaneDistance(plane, vertex.mPosition);
+                float nextDistance = CalcPlaneDistance(plane, next.mPosition);
+                if (distance >= 0.0f)
+                {
+                    out[numOut++] = vertex;
+                }
+                if ((distance >= 0.0f) != (nextDistance >= 0.0f))
+                {
+                    // Always interpolate from the inside vertex, so an edge shared by two triangles is cut at one point
+                    const ClipVertex& inside = distance >= 0.0f ? vertex : next;
+                    const ClipVertex& outside = distance >= 0.0f ? next : vertex;
+                    float insideDistance = distance >= 0.0f ? distance : nextDistance;
+                    float outsideDistance = distance >= 0.0f ? nextDistance : distance;
+                    float t = insideDistance / (insideDistance - outsideDistance);
+
+                    ClipVertex& cut = out[numOut++];
+                    for (int c = 0; c < 4; c++)
+                    {
+                        cut.mPosition[c] = inside.mPosition[c] + (outside.mPosition[c] - inside.mPosition[c]) * t;
+                    }
+                    for (int a = 0; a < NumAttributes; a++)
+                    {
+                        cut.mAttributes[a] = inside.mAttributes[a] + (outside.mAttributes[a] - inside.mAttributes[a]) * t;
+                    }
+                }
+            }
+            numVertices = numOut;
+            current ^= 1;
+        }
+
+        for (int i = 1; i + 1 < numVertices; i++)
+        {
+            const ClipVertex* triangle[3] = { &polygons[current][0], &polygons[current][i], &polygons[current][i + 1] };
+            AddTriangle(triangle, color, batch);
+        }
+    }
+
+    void SoftwareRenderer::AddTriangle(const ClipVertex* vertices[3], const float color[4], Batch& batch) const
+    {
+        // Viewport transform, y down, as D3D12 maps clip space to the render target
+        float screen[3][2];
+        float invW[3];
+        for (int i = 0; i < 3; i++)
+        {
+            const float* position = vertices[i]->mPosition;
+            invW[i] = 1.0f / position[3];
+            screen[i][0] = (position[0] * invW[i] * 0.5f + 0.5f) * static_cast<float>(mWidth);
+            screen[i][1] = (0.5f - position[1] * invW[i] * 0.5f) * static_cast<float>(mHeight);
+        }
+
+        double area = (static_cast<double>(screen[1][0]) - screen[0][0]) * (static_cast<double>(screen[2][1]) - screen[0][1]) -
+            (static_cast<double>(screen[2][0]) - screen[0][0]) * (static_cast<double>(screen[1][1]) - screen[0][1]);
+        if (area == 0.0)
+        {
+            return;
+        }
+
+        // Culling is off in D3d12Renderer, so either winding is drawn
+        int order[3] = { 0, 1, 2 };
+        if (area < 0.0)
+        {
+            std::swap(order[1], order[2]);
+            area = -area;
+        }
+
+        float minX = std::min(std::min(screen[0][0], screen[1][0]), screen[2][0]);
+        float maxX = std::max(std::max(screen[0][0], screen[1][0]), screen[2][0]);
+        float minY = std::min(std::min(screen[0][1], screen[1][1]), screen[2][1]);
+        float maxY = std::max(std::max(screen[0][1], screen[1][1]), screen[2][1]);
+
+        // Pixels whose centers fall inside the bounds
+        Triangle triangle;
+        triangle.mMinX = std::max(0, static_cast<int>(std::ceil(minX - 0.5f)));
+        triangle.mMinY = std::max(0, static_cast<int>(std::ceil(minY - 0.5f)));
+        triangle.mMaxX = std::min(mWidth, static_cast<int>(std::floor(maxX - 0.5f)) + 1);
+        triangle.mMaxY = std::min(mHeight, static_cast<int>(std::floor(maxY - 0.5f)) + 1);
+        if (triangle.mMinX >= triangle.mMaxX || triangle.mMinY >= triangle.mMaxY)
+        {
+            return;
+        }
+
+        const float* p[3] = { screen[order[0]], screen[order[1]], screen[order[2]] };
+        for (int edge = 0; edge < 3; edge++)
+        {
+            const float* from = p[edge];
+            const float* to = p[edge < 2 ? edge + 1 : 0];
+            bool fromFirst = from[0] < to[0] || (from[0] == to[0] && from[1] < to[1]);
+            const float* origin = fromFirst ? from : to;
+
+            float a = from[1] - to[1];
+            float b = to[0] - from[0];
+            triangle.mEdgeA[edge] = a;
+            triangle.mEdgeB[edge] = b;
+            triangle.mEdgeOrigin[edge][0] = origin[0];
+            triangle.mEdgeOrigin[edge][1] = origin[1];
+            triangle.mEdgeThreshold[edge] = (a > 0.0f || (a == 0.0f && b > 0.0f)) ? -FLT_MIN : 0.0f;
+        }
+
+        // Gradients of a value given at the three vertices, in double since screen coordinates can be large
+        double dx1 = static_cast<double>(p[1][0]) - p[0][0];
+        double dy1 = static_cast<double>(p[1][1]) - p[0][1];
+        double dx2 = static_cast<double>(p[2][0]) - p[0][0];
+        double dy2 = static_cast<double>(p[2][1]) - p[0][1];
+        auto setPlane = [&](double value0, double value1, double value2, float& gradientX, float& gradientY, float& value)
+        {
+            gradientX = static_cast<float>(((value1 - value0) * dy2 - (value2 - value0) * dy1) / area);
+            gradientY = static_cast<float>(((value2 - value0) * dx1 - (value1 - value0) * dx2) / area);
+            value = static_cast<float>(value0);
+        };
+
+        const ClipVertex* v[3] = { vertices[order[0]], vertices[order[1]], vertices[order[2]] };
+        const float w[3] = { invW[order[0]], invW[order[1]], invW[order[2]] };
+        triangle.mOrigin[0] = p[0][0];
+        triangle.mOrigin[1] = p[0][1];
+        setPlane(v[0]->mPosition[2] * w[0], v[1]->mPosition[2] * w[1], v[2]->mPosition[2] * w[2],
+            triangle.mDepth[0], triangle.mDepth[1], triangle.mDepth[2]);
+        setPlane(w[0], w[1], w[2], triangle.mInvW[0], triangle.mInvW[1], triangle.mInvW[2]);
+        for (int i = 0; i < 2; i++)
+        {
+            setPlane(v[0]->mAttributes[4 + i] * w[0], v[1]->mAttributes[4 + i] * w[1], v[2]->mAttributes[4 + i] * w[2],
+                triangle.mTexcoord[i][0], triangle.mTexcoord[i][1], triangle.mTexcoord[i][2]);
+        }
+        for (int i = 0; i < 4; i++)
+        {
+            setPlane(v[0]->mAttributes[i] * w[0], v[1]->mAttributes[i] * w[1], v[2]->mAttributes[i] * w[2],
+                triangle.mColor[0][i], triangle.mColor[1][i], triangle.mColor[2][i]);
+            triangle.mInstanceColor[i] = color[i];
+        }
+
+        // Bin into every tile the bounds touch, skipping tiles wholly outside one of the edges
+        uint32_t triangleIndex = static_cast<uint32_t>(batch.mTriangles.size());
+        int firstTileX = triangle.mMinX / TileSize;
+        int lastTileX = (triangle.mMaxX - 1) / TileSize;
+        int firstTileY = triangle.mMinY / TileSize;
+        int lastTileY = (triangle.mMaxY - 1) / TileSize;
+        bool singleTile = firstTileX == lastTileX && firstTileY == lastTileY;
+        for (int tileY = firstTileY; tileY <= lastTileY; tileY++)
+        {
+            for (int tileX = firstTileX; tileX <= lastTileX; tileX++)
+            {
+                bool overlaps = true;
+                for (int edge = 0; !singleTile && overlaps && edge < 3; edge++)
+                {
+                    // Largest edge value over the tile's pixel centers
+                    float a = triangle.mEdgeA[edge];
+                    float b = triangle.mEdgeB[edge];
+                    double x = tileX * TileSize + (a > 0.0f ? TileSize - 0.5 : 0.5);
+                    double y = tileY * TileSize + (b > 0.0f ? TileSize - 0.5 : 0.5);
+                    overlaps = a * (x - triangle.mEdgeOrigin[edge][0]) + b * (y - triangle.mEdgeOrigin[edge][1]) >= 0.0;
+                }
+                if (overlaps)
+                {
+                    batch.mTileBins[static_cast<size_t>(tileY) * static_cast<size_t>(mNumTilesX) + static_cast<size_t>(tileX)].push_back(triangleIndex);
+                }
+            }
+        }
+        batch.mTriangles.push_back(triangle);
+    }
+
+    void SoftwareRenderer::RenderTile(size_t tileIndex, TileScratch& scratch)
+    {
+        int tileX = static_cast<int>(tileIndex % static_cast<size_t>(mNumTilesX)) * TileSize;
+        int tileY = static_cast<int>(tileIndex / static_cast<size_t>(mNumTilesX)) * TileSize;
+
+        std::fill(std::begin(scratch.mDepth), std::end(scratch.mDepth), 1.0f);
+        std::fill(std::begin(scratch.mTriangleIds), std::end(scratch.mTriangleIds), NoTriangle);
+        std::fill(std::begin(scratch.mBlockMaxDepth), std::end(scratch.mBlockMaxDepth), 1.0f);
+        scratch.mTriangles.clear();
+
+        // Batches in order and bins in order keep submission order, so depth ties resolve as on the GPU
+        for (size_t b = 0; b < mNumBatches; b++)
+        {
+            const Batch& batch = mBatches[b];
+            for (uint32_t triangleIndex : batch.mTileBins[tileIndex])
+            {
+                const Triangle& triangle = batch.mTriangles[triangleIndex];
+                uint32_t id = static_cast<uint32_t>(scratch.mTriangles.size());
+                scratch.mTriangles.push_back(&triangle);
+                RasterTriangle(triangle, id, tileX, tileY, scratch);
+            }
+        }
+
+        ShadeTile(tileX, tileY, scratch);
+    }
+
+    void SoftwareRenderer::RasterTriangle(const Triangle& triangle, uint32_t id, int tileX, int tileY, TileScratch& scratch) const
+    {
+        // Tile-relative pixel range
+        int beginX = std::max(triangle.mMinX, tileX) - tileX;
+        int endX = std::min(triangle.mMaxX, tileX + TileSize) - tileX;
+        int beginY = std::max(triangle.mMinY, tileY) - tileY;
+        int endY = std::min(triangle.mMaxY, tileY + TileSize) - tileY;
+
+        // Values at the tile's first pixel center, so the per-pixel terms stay small
+        float edgeA[3];
+        float edgeB[3];
+        float edgeC[3];
+        for (int edge = 0; edge < 3; edge++)
+        {
+            edgeA[edge] = triangle.mEdgeA[edge];
+            edgeB[edge] = triangle.mEdgeB[edge];
+            edgeC[edge] = static_cast<float>(static_cast<double>(edgeA[edge]) * (tileX + 0.5 - triangle.mEdgeOrigin[edge][0]) +
+                static_cast<double>(edgeB[edge]) * (tileY + 0.5 - triangle.mEdgeOrigin[edge][1]));
+        }
+        float depthA = triangle.mDepth[0];
+        float depthB = triangle.mDepth[1];
+        float depthC = static_cast<float>(triangle.mDepth[2] + static_cast<double>(depthA) * (tileX + 0.5 - triangle.mOrigin[0]) +
+            static_cast<double>(depthB) * (tileY + 0.5 - triangle.mOrigin[1]));
+
+        // Pixels evaluate A * x + (B * y + C); rounding is monotonic, so the values computed the same way at a block's
+        // corners bound every pixel's exactly, and whole blocks can be skipped or accepted without changing any result
+        for (int blockY = beginY & ~(BlockSize - 1); blockY < endY; blockY += BlockSize)
+        {
+            float firstY = static_cast<float>(blockY);
+            float lastY = static_cast<float>(blockY + BlockSize - 1);
+            float rowMin[3];
+            float rowMax[3];
+            for (int edge = 0; edge < 3; edge++)
+            {
+                float first = edgeB[edge] * firstY + edgeC[edge];
+                float last = edgeB[edge] * lastY + edgeC[edge];
+                rowMin[edge] = std::min(first, last);
+                rowMax[edge] = std::max(first, last);
+            }
+            float rowMinDepth = std::min(depthB * firstY + depthC, depthB * lastY + depthC);
+
+            for (int blockX = beginX & ~(BlockSize - 1); blockX < endX; blockX += BlockSize)
+            {
+                float firstX = static_cast<float>(blockX);
+                float lastX = static_cast<float>(blockX + BlockSize - 1);
+                bool outside = false;
+                bool covered = true;
+                for (int edge = 0; edge < 3; edge++)
+                {
+                    float first = edgeA[edge] * firstX;
+                    float last = edgeA[edge] * lastX;
+                    outside |= !(std::max(first, last) + rowMax[edge] > triangle.mEdgeThreshold[edge]);
+                    covered &= std::min(first, last) + rowMin[edge] > triangle.mEdgeThreshold[edge];
+                }
+
+                // Nothing passes if the nearest point is no nearer than the farthest depth already in the block
+                float& blockMaxDepth = scratch.mBlockMaxDepth[(blockY / BlockSize) * (TileSize / BlockSize) + blockX / BlockSize];
+                if (outside || !(std::min(depthA * firstX, depthA * lastX) + rowMinDepth < blockMaxDepth))
+                {
+                    continue;
+                }
+
+#if defined(RASTER_SSE2)
+                const __m128 laneOffsets = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+                const __m128 fx[2] = { _mm_add_ps(_mm_set1_ps(firstX), laneOffsets), _mm_add_ps(_mm_set1_ps(firstX + 4.0f), laneOffsets) };
+                __m128 columns[3][2];
+                __m128 thresholds[3];
+                for (int edge = 0; edge < 3; edge++)
+                {
+                    columns[edge][0] = _mm_mul_ps(_mm_set1_ps(edgeA[edge]), fx[0]);
+                    columns[edge][1] = _mm_mul_ps(_mm_set1_ps(edgeA[edge]), fx[1]);
+                    thresholds[edge] = _mm_set1_ps(triangle.mEdgeThreshold[edge]);
+                }
+                const __m128 depthColumns[2] = { _mm_mul_ps(_mm_set1_ps(depthA), fx[0]), _mm_mul_ps(_mm_set1_ps(depthA), fx[1]) };
+                const __m128i ids = _mm_set1_epi32(static_cast<int>(id));
+                const __m128 all = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+                __m128 written = _mm_setzero_ps();
+                __m128 maxDepth = _mm_setzero_ps();
+                for (int y = blockY; y < blockY + BlockSize; y++)
+                {
+                    float fy = static_cast<float>(y);
+                    __m128 rows[3];
+                    for (int edge = 0; edge < 3; edge++)
+                    {
+                        rows[edge] = _mm_set1_ps(edgeB[edge] * fy + edgeC[edge]);
+                    }
+                    __m128 rowDepth = _mm_set1_ps(depthB * fy + depthC);
+                    float* depthRow = &scratch.mDepth[y * TileSize + blockX];
+                    uint32_t* idRow = &scratch.mTriangleIds[y * TileSize + blockX];
+
+                    for (int group = 0; group < 2; group++)
+                    {
+                        __m128 inside = all;
+                        if (!covered)
+                        {
+                            inside = _mm_and_ps(
+                                _mm_and_ps(
+                                    _mm_cmpgt_ps(_mm_add_ps(columns[0][group], rows[0]), thresholds[0]),
+                                    _mm_cmpgt_ps(_mm_add_ps(columns[1][group], rows[1]), thresholds[1])),
+                                _mm_cmpgt_ps(_mm_add_ps(columns[2][group], rows[2]), thresholds[2]));
+                        }
+
+                        __m128 depth = _mm_add_ps(depthColumns[group], rowDepth);
+                        __m128 stored = _mm_load_ps(depthRow + group * 4);
+                        __m128 pass = _mm_and_ps(inside, _mm_cmplt_ps(depth, stored));
+                        stored = _mm_or_ps(_mm_and_ps(pass, depth), _mm_andnot_ps(pass, stored));
+                        maxDepth = _mm_max_ps(maxDepth, stored);
+                        if (_mm_movemask_ps(pass) == 0)
+                        {
+                            continue;
+                        }
+
+                        written = _mm_or_ps(written, pass);
+                        _mm_store_ps(depthRow + group * 4, stored);
+                        __m128i passBits = _mm_castps_si128(pass);
+                        __m128i storedIds = _mm_load_si128(reinterpret_cast<const __m128i*>(idRow + group * 4));
+                        _mm_store_si128(reinterpret_cast<__m128i*>(idRow + group * 4),
+                            _mm_or_si128(_mm_and_si128(passBits, ids), _mm_andnot_si128(passBits, storedIds)));
+                    }
+                }
+
+                if (_mm_movemask_ps(written) != 0)
+                {
+                    maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(1, 0, 3, 2)));
+                    maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(2, 3, 0, 1)));
+                    blockMaxDepth = _mm_cvtss_f32(maxDepth);
+                }
+#else
+                bool written = false;
+                float maxDepth = 0.0f;
+                for (int y = blockY; y < blockY + BlockSize; y++)
+                {
+                    float fy = static_cast<float>(y);
+                    float rows[3];
+                    for (int edge = 0; edge < 3; edge++)
+                    {
+                        rows[edge] = edgeB[edge] * fy + edgeC[edge];
+                    }
+                    float rowDepth = depthB * fy + depthC;
+                    float* depthRow = &scratch.mDepth[y * TileSize];
+                    uint32_t* idRow = &scratch.mTriangleIds[y * TileSize];
+
+                    for (int x = blockX; x < blockX + BlockSize; x++)
+                    {
+                        float fx = static_cast<float>(x);
+                        bool inside = covered || (
+                            edgeA[0] * fx + rows[0] > triangle.mEdgeThreshold[0] &&
+                            edgeA[1] * fx + rows[1] > triangle.mEdgeThreshold[1] &&
+                            edgeA[2] * fx + rows[2] > triangle.mEdgeThreshold[2]);
+                        float depth = depthA * fx + rowDepth;
+                        if (inside && depth < depthRow[x])
+                        {
+                            depthRow[x] = depth;
+                            idRow[x] = id;
+                            written = true;
+                        }
+                        maxDepth = std::max(maxDepth, depthRow[x]);
+                    }
+                }
+
+                if (written)
+                {
+                    blockMaxDepth = maxDepth;
+                }
+#endif
+            }
+        }
+    }
+
+    void SoftwareRenderer::ShadeTile(int tileX, int tileY, const TileScratch& scratch)
+    {
+        const uint32_t clearPixel = Float4::Load(ClearColor).PackUnorm();
+
+        int endX = std::min(TileSize, mWidth - tileX);
+        int endY = std::min(TileSize, mHeight - tileY);
+        for (int y = 0; y < endY; y++)
+        {
+            uint32_t* pixels = &mPixels[static_cast<size_t>(tileY + y) * static_cast<size_t>(mWidth) + static_cast<size_t>(tileX)];
+            const uint32_t* idRow = &scratch.mTriangleIds[y * TileSize];
+            for (int x = 0; x < endX; x += 4)
+            {
+                // Most groups of four lie on one triangle
+                uint32_t id = idRow[x];
+                if (x + 4 <= endX && id != NoTriangle && idRow[x + 1] == id && idRow[x + 2] == id && idRow[x + 3] == id)
+                {
+                    ShadeQuad(*scratch.mTriangles[id], tileX + x, tileY + y, pixels + x);
+                    continue;
+                }
+
+                for (int i = x; i < std::min(x + 4, endX); i++)
+                {
+                    pixels[i] = idRow[i] == NoTriangle ? clearPixel : ShadePixel(*scratch.mTriangles[idRow[i]], tileX + i, tileY + y);
+                }
+            }
+        }
+    }
+
+    uint32_t SoftwareRenderer::ShadePixel(const Triangle& triangle, int x, int y) const
+    {
+        // Attributes over w interpolate linearly on screen; dividing by the interpolated 1 / w undoes it
+        float fx = static_cast<float>(x) + 0.5f - triangle.mOrigin[0];
+        float fy = static_cast<float>(y) + 0.5f - triangle.mOrigin[1];
+        float w = 1.0f / (triangle.mInvW[0] * fx + triangle.mInvW[1] * fy + triangle.mInvW[2]);
+        float u = (triangle.mTexcoord[0][0] * fx + triangle.mTexcoord[0][1] * fy + triangle.mTexcoord[0][2]) * w;
+        float v = (triangle.mTexcoord[1][0] * fx + triangle.mTexcoord[1][1] * fy + triangle.mTexcoord[1][2]) * w;
+        Float4 vertexColor = (Float4::Load(triangle.mColor[0]) * Float4(fx) + Float4::Load(triangle.mColor[1]) * Float4(fy) +
+            Float4::Load(triangle.mColor[2])) * Float4(w);
+
+        // Bilinear with wrapping, as the static sampler
+        float texelX = u * static_cast<float>(CheckerTextureWidth) - 0.5f;
+        float texelY = v * static_cast<float>(CheckerTextureHeight) - 0.5f;
+        int floorX = FloorToInt(texelX);
+        int floorY = FloorToInt(texelY);
+        uint32_t x0 = static_cast<uint32_t>(floorX) & (CheckerTextureWidth - 1);
+        uint32_t y0 = static_cast<uint32_t>(floorY) & (CheckerTextureHeight - 1);
+        uint32_t x1 = (x0 + 1) & (CheckerTextureWidth - 1);
+        uint32_t y1 = (y0 + 1) & (CheckerTextureHeight - 1);
+        const float* row0 = &mTexture[y0 * CheckerTextureWidth * 4];
+        const float* row1 = &mTexture[y1 * CheckerTextureWidth * 4];
+        float blendX = texelX - static_cast<float>(floorX);
+        Float4 texel = Lerp(Lerp(Float4::Load(row0 + x0 * 4), Float4::Load(row0 + x1 * 4), blendX),
+            Lerp(Float4::Load(row1 + x0 * 4), Float4::Load(row1 + x1 * 4), blendX), texelY - static_cast<float>(floorY));
+
+        // PsMain
+        Float4 instanceColor = Float4::Load(triangle.mInstanceColor);
+        Float4 instanceAlpha(triangle.mInstanceColor[3]);
+        Float4 color = (vertexColor + instanceAlpha).Saturate() * (texel + Float4(0.95f) * instanceAlpha).Saturate() * instanceColor;
+        return color.PackUnorm();
+    }
+
+    void SoftwareRenderer::ShadeQuad(const Triangle& triangle, int x, int y, uint32_t* pixelsOut) const
+    {
+#if defined(RASTER_SSE2)
+        // ShadePixel's operations in the same order, one pixel per lane, so results match it bit for bit
+        const __m128 fx = _mm_sub_ps(_mm_add_ps(_mm_add_ps(_mm_set1_ps(static_cast<float>(x)), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f)),
+            _mm_set1_ps(0.5f)), _mm_set1_ps(triangle.mOrigin[0]));
+        const __m128 fy = _mm_set1_ps(static_cast<float>(y) + 0.5f - triangle.mOrigin[1]);
+        auto evaluate = [&](float gradientX, float gradientY, float value)
+        {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(gradientX), fx), _mm_mul_ps(_mm_set1_ps(gradientY), fy)), _mm_set1_ps(value));
+        };
+        auto saturate = [](__m128 value) { return _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.0f)); };
+        auto lerp = [](__m128 from, __m128 to, __m128 t) { return _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(to, from), t)); };
+
+        __m128 w = _mm_div_ps(_mm_set1_ps(1.0f), evaluate(triangle.mInvW[0], triangle.mInvW[1], triangle.mInvW[2]));
+        __m128 u = _mm_mul_ps(evaluate(triangle.mTexcoord[0][0], triangle.mTexcoord[0][1], triangle.mTexcoord[0][2]), w);
+        __m128 v = _mm_mul_ps(evaluate(triangle.mTexcoord[1][0], triangle.mTexcoord[1][1], triangle.mTexcoord[1][2]), w);
+
+        __m128 texelX = _mm_sub_ps(_mm_mul_ps(u, _mm_set1_ps(static_cast<float>(CheckerTextureWidth))), _mm_set1_ps(0.5f));
+        __m128 texelY = _mm_sub_ps(_mm_mul_ps(v, _mm_set1_ps(static_cast<float>(CheckerTextureHeight))), _mm_set1_ps(0.5f));
+        __m128i floorX = _mm_cvttps_epi32(texelX);
+        __m128i floorY = _mm_cvttps_epi32(texelY);
+        floorX = _mm_add_epi32(floorX, _mm_castps_si128(_mm_cmplt_ps(texelX, _mm_cvtepi32_ps(floorX))));
+        floorY = _mm_add_epi32(floorY, _mm_castps_si128(_mm_cmplt_ps(texelY, _mm_cvtepi32_ps(floorY))));
+
+        alignas(16) float blendX[4];
+        alignas(16) float blendY[4];
+        alignas(16) int32_t texelXs[4];
+        alignas(16) int32_t texelYs[4];
+        _mm_store_ps(blendX, _mm_sub_ps(texelX, _mm_cvtepi32_ps(floorX)));
+        _mm_store_ps(blendY, _mm_sub_ps(texelY, _mm_cvtepi32_ps(floorY)));
+        _mm_store_si128(reinterpret_cast<__m128i*>(texelXs), floorX);
+        _mm_store_si128(reinterpret_cast<__m128i*>(texelYs), floorY);
+
+        // Filter each pixel's texels as RGBA, then transpose to one channel per register
+        __m128 texels[4];
+        for (int i = 0; i < 4; i++)
+        {
+            uint32_t x0 = static_cast<uint32_t>(texelXs[i]) & (CheckerTextureWidth - 1);
+            uint32_t y0 = static_cast<uint32_t>(texelYs[i]) & (CheckerTextureHeight - 1);
+            uint32_t x1 = (x0 + 1) & (CheckerTextureWidth - 1);
+            uint32_t y1 = (y0 + 1) & (CheckerTextureHeight - 1);
+            const float* row0 = &mTexture[y0 * CheckerTextureWidth * 4];
+            const float* row1 = &mTexture[y1 * CheckerTextureWidth * 4];
+            __m128 blend = _mm_set1_ps(blendX[i]);
+            texels[i] = lerp(lerp(_mm_loadu_ps(row0 + x0 * 4), _mm_loadu_ps(row0 + x1 * 4), blend),
+                lerp(_mm_loadu_ps(row1 + x0 * 4), _mm_loadu_ps(row1 + x1 * 4), blend), _mm_set1_ps(blendY[i]));
+        }
+        _MM_TRANSPOSE4_PS(texels[0], texels[1], texels[2], texels[3]);
+
+        __m128 instanceAlpha = _mm_set1_ps(triangle.mInstanceColor[3]);
+        __m128 textureBias = _mm_mul_ps(_mm_set1_ps(0.95f), instanceAlpha);
+        __m128i packed = _mm_setzero_si128();
+        for (int channel = 0; channel < 4; channel++)
+        {
+            __m128 vertexColor = _mm_mul_ps(evaluate(triangle.mColor[0][channel], triangle.mColor[1][channel], triangle.mColor[2][channel]), w);
+            __m128 color = _mm_mul_ps(_mm_mul_ps(saturate(_mm_add_ps(vertexColor, instanceAlpha)), saturate(_mm_add_ps(texels[channel], textureBias))),
+                _mm_set1_ps(triangle.mInstanceColor[channel]));
+            __m128i bytes = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(saturate(color), _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+            packed = _mm_or_si128(packed, _mm_slli_epi32(bytes, 8 * channel));
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(pixelsOut), packed);
+#else
+        for (int i = 0; i < 4; i++)
+        {
+            pixelsOut[i] = ShadePixel(triangle, x + i, y);
+        }
+#endif
+    }
+
+} // namespace Vnm
@@ -0,0 +1,81 @@
+// SoftwareRenderer.h
+
+#pragma once
+
+#include "Renderer.h"
+#include "WorkStealingPool.h"
+#include <memory>
+#include <vector>
+
+namespace Vnm
+{
+    // CPU backend drawing the same scene as D3d12Renderer, textured and vertex-colored cubes with depth testing, into an
+    // RGBA8 image
+    // EndFrame transforms, culls and clips instances in parallel batches, binning the resulting triangles into screen
+    // tiles in submission order, then renders the tiles in parallel. Each tile first finds the nearest triangle for
+    // every pixel, four pixels at a time where SSE2 is available, then shades each pixel once.
+    class SoftwareRenderer : public IRenderer
+    {
+    public:
+        static constexpr int TileSize = 64;
+
+        SoftwareRenderer(WorkStealingPool& pool, int width, int height);
+        ~SoftwareRenderer() override;
+
+        SoftwareRenderer(const SoftwareRenderer&) = delete;
+        SoftwareRenderer& operator=(const SoftwareRenderer&) = delete;
+
+        void BeginFrame(const float view[16]) override;
+        void SubmitInstances(const Snake::RenderInstance* instances, size_t numInstances) override;
+        // Renders the frame; the image stays valid until the next EndFrame
+        void EndFrame() override;
+
+        int GetWidth() const                { return mWidth; }
+        int GetHeight() const               { return mHeight; }
+        // Rows top to bottom, each pixel R, G, B, A bytes in memory order, as the D3D12 back buffer holds them
+        const uint32_t* GetPixels() const   { return mPixels.data(); }
+
+        // Triangles left after culling and clipping, and how many tiles they were binned to, for the last frame
+        uint64_t GetNumTriangles() const    { return mNumTriangles; }
+        uint64_t GetNumBinnedTriangles() const { return mNumBinnedTriangles; }
+
+        // Writes the last frame as a binary PPM, dropping alpha
+        bool SaveImage(const char* path) const;
+
+    private:
+        class ClipVertex;
+        class Triangle;
+        class Batch;
+        class TileScratch;
+
+        void ProcessBatch(size_t batchIndex);
+        void AddInstance(const Snake::RenderInstance& instance, Batch& batch) const;
+        void AddClippedTriangle(const ClipVertex* vertices[3], uint32_t clipPlanes, const float color[4], Batch& batch) const;
+        void AddTriangle(const ClipVertex* vertices[3], const float color[4], Batch& batch) const;
+        void RenderTile(size_t tileIndex, TileScratch& scratch);
+        void RasterTriangle(const Triangle& triangle, uint32_t id, int tileX, int tileY, TileScratch& scratch) const;
+        void ShadeTile(int tileX, int tileY, const TileScratch& scratch);
+        uint32_t ShadePixel(const Triangle& triangle, int x, int y) const;
+        void ShadeQuad(const Triangle& triangle, int x, int y, uint32_t* pixelsOut) const;     // Four pixels along a row
+
+        WorkStealingPool&                        mPool;
+        int                                      mWidth;
+        int                                      mHeight;
+        int                                      mNumTilesX;
+        int                                      mNumTilesY;
+        std::vector<uint32_t>                    mPixels;
+        std::vector<float>                       mTexture;      // Checker texture as float RGBA, sampled without conversion
+
+        float                                    mViewProj[16];
+        float                                    mCameraPosition[3];
+        float                                    mNearCullDistanceSq;   // Instances at least this close draw back faces too
+        std::vector<Snake::RenderInstance>       mInstances;
+
+        std::vector<Batch>                       mBatches;
+        size_t                                   mNumBatches = 0;
+        std::vector<std::unique_ptr<TileScratch>> mScratch;     // One per pool worker
+        uint64_t                                 mNumTriangles = 0;
+        uint64_t                                 mNumBinnedTriangles = 0;
+    };
+
+} // namespace Vnm
@@ -0,0 +1,196 @@
+// SparseGameBoard.cpp
+
+#include "SparseGameBoard.h"
+#include <cassert>
+#include <cstring>
+
+namespace Snake
+{
+    SparseGameBoard::SparseGameBoard(const BoardLayout& layout)
+        : mLayout(layout)
+    {
+        size_t numBricks = 1;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            mNumBricks[axis] = static_cast<int>((mLayout.GetNumPieces(axis) + BrickSize - 1) >> BrickShift);
+            numBricks *= mNumBricks[axis];
+        }
+
+        mBrickIndex.reset(new uint32_t[numBricks]);
+        for (size_t i = 0; i < numBricks; i++)
+        {
+            mBrickIndex[i] = InvalidBrick;
+        }
+    }
+
+    void SparseGameBoard::Reset()
+    {
+        // Return every brick to the pool but keep the memory for reuse
+        for (Brick& brick : mBricks)
+        {
+            if (brick.mNumOccupied != 0)
+            {
+                mBrickIndex[brick.mBrickIndex] = InvalidBrick;
+                brick.mNumOccupied = 0;
+                mFreeBricks.push_back(static_cast<uint32_t>(&brick - mBricks.data()));
+            }
+        }
+
+        mNumOccupiedCells = 0;
+    }
+
+    size_t SparseGameBoard::GetMemoryUsage() const
+    {
+        size_t numBricks = static_cast<size_t>(mNumBricks[0]) * mNumBricks[1] * mNumBricks[2];
+        return sizeof(*this) +
+            numBricks * sizeof(uint32_t) +
+            mBricks.capacity() * sizeof(Brick) +
+            mFreeBricks.capacity() * sizeof(uint32_t);
+    }
+
+    size_t SparseGameBoard::CalcBrickIndex(int xBlock, int yBlock, int zBlock) const
+    {
+        return static_cast<size_t>(xBlock >> BrickShift) +
+            static_cast<size_t>(yBlock >> BrickShift) * mNumBricks[0] +
+            static_cast<size_t>(zBlock >> BrickShift) * mNumBricks[0] * mNumBricks[1];
+    }
+
+    size_t SparseGameBoard::CalcLocalIndex(int xBlock, int yBlock, int zBlock)
+    {
+        return static_cast<size_t>(xBlock & (BrickSize - 1)) |
+            (static_cast<size_t>(yBlock & (BrickSize - 1)) << BrickShift) |
+            (static_cast<size_t>(zBlock & (BrickSize - 1)) << (2 * BrickShift));
+    }
+
+    const SparseGameBoard::Brick* SparseGameBoard::FindBrick(int xBlock, int yBlock, int zBlock) const
+    {
+        uint32_t brickIndex = mBrickIndex[CalcBrickIndex(xBlock, yBlock, zBlock)];
+        return brickIndex != InvalidBrick ? &mBricks[brickIndex] : nullptr;
+    }
+
+    GamePieceType SparseGameBoard::GetGamePieceType(int xBlock, int yBlock, int zBlock) const
+    {
+        if (mLayout.IsWall(xBlock, yBlock, zBlock))
+        {
+            return GamePieceType::Wall;
+        }
+
+        const Brick* brick = FindBrick(xBlock, yBlock, zBlock);
+        return brick != nullptr ? brick->mTypes[CalcLocalIndex(xBlock, yBlock, zBlock)] : GamePieceType::Empty;
+    }
+
+    PieceColor SparseGameBoard::GetGamePieceColor(int xBlock, int yBlock, int zBlock) const
+    {
+        const Brick* brick = FindBrick(xBlock, yBlock, zBlock);
+        assert(brick != nullptr);
+        return brick->mColors[CalcLocalIndex(xBlock, yBlock, zBlock)];
+    }
+
+    void SparseGameBoard::PlaceGamePiece(int xBlock, int yBlock, int zBlock, PieceColor color, GamePieceType gamePieceType)
+    {
+        assert(gamePieceType != GamePieceType::Empty && gamePieceType != GamePieceType::Wall);
+        assert(!mLayout.IsWall(xBlock, yBlock, zBlock));
+
+        size_t brickIndex = CalcBrickIndex(xBlock, yBlock, zBlock);
+        uint32_t poolIndex = mBrickIndex[brickIndex];
+        if (poolIndex == InvalidBrick)
+        {
+            // First piece in this brick, take one from the pool
+            if (!mFreeBricks.empty())
+            {
+                poolIndex = mFreeBricks.back();
+                mFreeBricks.pop_back();
+            }
+            else
+            {
+                poolIndex = static_cast<uint32_t>(mBricks.size());
+                mBricks.emplace_back();
+            }
+
+            Brick& brick = mBricks[poolIndex];
+            memset(brick.mOccupancy, 0, sizeof(brick.mOccupancy));
+            memset(brick.mTypes, static_cast<int>(GamePieceType::Empty), sizeof(brick.mTypes));
+            brick.mBrickIndex = static_cast<uint32_t>(brickIndex);
+            brick.mNumOccupied = 0;
+            mBrickIndex[brickIndex] = poolIndex;
+        }
+
+        Brick& brick = mBricks[poolIndex];
+        size_t localIndex = CalcLocalIndex(xBlock, yBlock, zBlock);
+        assert(brick.mTypes[localIndex] == GamePieceType::Empty);
+
+        brick.mOccupancy[localIndex >> 6] |= uint64_t(1) << (localIndex & 63);
+        brick.mTypes[localIndex] = gamePieceType;
+        brick.mColors[localIndex] = color;
+        brick.mNumOccupied++;
+        mNumOccupiedCells++;
+    }
+
+    void SparseGameBoard::RemoveGamePiece(int xBlock, int yBlock, int zBlock)
+    {
+        size_t brickIndex = CalcBrickIndex(xBlock, yBlock, zBlock);
+        uint32_t poolIndex = mBrickIndex[brickIndex];
+        assert(poolIndex != InvalidBrick);
+
+        Brick& brick = mBricks[poolIndex];
+        size_t localIndex = CalcLocalIndex(xBlock, yBlock, zBlock);
+        assert(brick.mTypes[localIndex] != GamePieceType::Empty);
+
+        brick.mOccupancy[localIndex >> 6] &= ~(uint64_t(1) << (localIndex & 63));
+        brick.mTypes[localIndex] = GamePieceType::Empty;
+        brick.mNumOccupied--;
+        mNumOccupiedCells--;
+
+        // Last piece gone, give the brick back
+        if (brick.mNumOccupied == 0)
+        {
+            mBrickIndex[brickIndex] = InvalidBrick;
+            mFreeBricks.push_back(poolIndex);
+        }
+    }
+
+    int SparseGameBoard::CastRay(int xBlock, int yBlock, int zBlock, int xStep, int yStep, int zStep, int maxSteps) const
+    {
+        assert((xStep != 0) + (yStep != 0) + (zStep != 0) == 1);
+
+        if (mLayout.IsWall(xBlock, yBlock, zBlock))
+        {
+            return 0;
+        }
+
+        int coords[3] = { xBlock, yBlock, zBlock };
+        const int steps[3] = { xStep, yStep, zStep };
+        const int axis = xStep != 0 ? 0 : (yStep != 0 ? 1 : 2);
+        const int step = steps[axis];
+
+        // Walls are implicit, so the ray is guaranteed to stop at the boundary layer
+        const int wallDistance = step > 0 ? static_cast<int>(mLayout.GetNumPieces(axis)) - 1 - coords[axis] : coords[axis];
+        const int lastStep = maxSteps < wallDistance - 1 ? maxSteps : wallDistance - 1;
+
+        int distance = 0;
+        while (distance <= lastStep)
+        {
+            const Brick* brick = FindBrick(coords[0], coords[1], coords[2]);
+            if (brick == nullptr)
+            {
+                // Jump to the first cell past this brick along the ray
+                int local = coords[axis] & (BrickSize - 1);
+                int skip = step > 0 ? BrickSize - local : local + 1;
+                coords[axis] += skip * step;
+                distance += skip;
+                continue;
+            }
+
+            if (brick->mTypes[CalcLocalIndex(coords[0], coords[1], coords[2])] != GamePieceType::Empty)
+            {
+                return distance;
+            }
+
+            coords[axis] += step;
+            distance++;
+        }
+
+        return wallDistance <= maxSteps ? wallDistance : -1;
+    }
+
+} // namespace Snake
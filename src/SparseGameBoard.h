@@ -0,0 +1,118 @@
+// SparseGameBoard.h
+
+#pragma once
+
+#include "Snake3D.h"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace Snake
+{
+    // Board for very large arenas; cells live in 8x8x8 bricks that are only allocated once something is placed in them
+    // Offers the same piece queries as GameBoard, with memory proportional to the occupied volume plus a small brick index
+    // Boundary walls are implicit, as on GameBoard, so they never allocate bricks
+    class SparseGameBoard
+    {
+    public:
+        static constexpr int BrickSize = 8;
+        static constexpr int BrickShift = 3;
+        static constexpr size_t CellsPerBrick = BrickSize * BrickSize * BrickSize;
+
+        explicit SparseGameBoard(const BoardLayout& layout);
+        ~SparseGameBoard() = default;
+
+        void Reset();
+
+        const BoardLayout& GetLayout() const { return mLayout; }
+        size_t GetNumOccupiedCells() const   { return mNumOccupiedCells; }
+        size_t GetNumBricks() const          { return mBricks.size() - mFreeBricks.size(); }
+        size_t GetMemoryUsage() const;
+
+        GamePieceType GetGamePieceType(int xBlock, int yBlock, int zBlock) const;
+        PieceColor GetGamePieceColor(int xBlock, int yBlock, int zBlock) const;
+        void PlaceGamePiece(int xBlock, int yBlock, int zBlock, PieceColor color, GamePieceType gamePieceType);
+        void RemoveGamePiece(int xBlock, int yBlock, int zBlock);
+
+        // Visits every occupied cell as visitor(xBlock, yBlock, zBlock, type, color), skipping unallocated bricks entirely
+        template<typename Visitor> void ForEachOccupiedCell(Visitor&& visitor) const;
+
+        // Walks from a block along one of the six axis directions (step components in -1..1, exactly one non-zero),
+        // skipping whole empty bricks. Returns the number of steps to the first occupied or wall cell, or -1 if none within maxSteps.
+        int CastRay(int xBlock, int yBlock, int zBlock, int xStep, int yStep, int zStep, int maxSteps) const;
+
+    private:
+        static constexpr uint32_t InvalidBrick = UINT32_MAX;
+
+        class Brick
+        {
+        public:
+            uint64_t      mOccupancy[BrickSize];        // One word per z slice, one bit per cell in the slice
+            GamePieceType mTypes[CellsPerBrick];
+            PieceColor    mColors[CellsPerBrick];
+            uint32_t      mBrickIndex;                  // Position in the top-level brick index
+            uint32_t      mNumOccupied;
+        };
+
+        BoardLayout                 mLayout;
+        int                         mNumBricks[3];
+        std::unique_ptr<uint32_t[]> mBrickIndex;        // Brick coordinates to position in mBricks, InvalidBrick if unallocated
+        std::vector<Brick>          mBricks;            // Brick pool; grows on demand and recycles through mFreeBricks
+        std::vector<uint32_t>       mFreeBricks;
+        size_t                      mNumOccupiedCells = 0;
+
+        size_t CalcBrickIndex(int xBlock, int yBlock, int zBlock) const;
+        const Brick* FindBrick(int xBlock, int yBlock, int zBlock) const;
+        static size_t CalcLocalIndex(int xBlock, int yBlock, int zBlock);
+    };
+
+    inline int CountTrailingZeros(uint64_t value)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, value);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(value);
+#endif
+    }
+
+    template<typename Visitor> void SparseGameBoard::ForEachOccupiedCell(Visitor&& visitor) const
+    {
+        for (const Brick& brick : mBricks)
+        {
+            if (brick.mNumOccupied == 0)
+            {
+                continue;
+            }
+
+            int xBrick = static_cast<int>(brick.mBrickIndex % mNumBricks[0]);
+            int yBrick = static_cast<int>((brick.mBrickIndex / mNumBricks[0]) % mNumBricks[1]);
+            int zBrick = static_cast<int>(brick.mBrickIndex / (mNumBricks[0] * mNumBricks[1]));
+
+            for (int z = 0; z < BrickSize; z++)
+            {
+                // Pull set bits out of the slice mask so empty cells cost nothing
+                uint64_t occupancy = brick.mOccupancy[z];
+                while (occupancy != 0)
+                {
+                    int bit = CountTrailingZeros(occupancy);
+                    occupancy &= occupancy - 1;
+
+                    size_t localIndex = static_cast<size_t>(z * BrickSize * BrickSize + bit);
+                    visitor(
+                        (xBrick << BrickShift) + (bit & (BrickSize - 1)),
+                        (yBrick << BrickShift) + (bit >> BrickShift),
+                        (zBrick << BrickShift) + z,
+                        brick.mTypes[localIndex],
+                        brick.mColors[localIndex]);
+                }
+            }
+        }
+    }
+
+} // namespace Snake
@@ -0,0 +1,80 @@
+// TranspositionTable.cpp
+
+#include "TranspositionTable.h"
+
+namespace Snake
+{
+    TranspositionTable::TranspositionTable(size_t capacity)
+    {
+        size_t numBuckets = 1;
+        while (numBuckets * EntriesPerBucket < capacity)
+        {
+            numBuckets *= 2;
+        }
+
+        mBuckets.reset(new Bucket[numBuckets]);
+        mBucketMask = numBuckets - 1;
+        Clear();
+    }
+
+    TranspositionTable::~TranspositionTable() = default;
+
+    void TranspositionTable::Clear()
+    {
+        for (size_t bucket = 0; bucket <= mBucketMask; bucket++)
+        {
+            for (Entry& entry : mBuckets[bucket].mEntries)
+            {
+                entry.mCheck.store(0, std::memory_order_relaxed);
+                entry.mValue.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void TranspositionTable::Store(uint64_t hash, uint64_t value)
+    {
+        if (hash == 0)
+        {
+            return;
+        }
+
+        Bucket& bucket = GetBucket(hash);
+
+        // The low bits pick the bucket, so the high bits pick the victim
+        Entry* target = &bucket.mEntries[hash >> 62];
+        for (Entry& entry : bucket.mEntries)
+        {
+            uint64_t entryValue = entry.mValue.load(std::memory_order_relaxed);
+            uint64_t entryHash = entry.mCheck.load(std::memory_order_relaxed) ^ entryValue;
+            if (entryHash == hash || (entryHash == 0 && entryValue == 0))
+            {
+                target = &entry;
+                break;
+            }
+        }
+
+        target->mCheck.store(hash ^ value, std::memory_order_relaxed);
+        target->mValue.store(value, std::memory_order_relaxed);
+    }
+
+    bool TranspositionTable::Probe(uint64_t hash, uint64_t& valueOut) const
+    {
+        if (hash == 0)
+        {
+            return false;
+        }
+
+        const Bucket& bucket = GetBucket(hash);
+        for (const Entry& entry : bucket.mEntries)
+        {
+            uint64_t value = entry.mValue.load(std::memory_order_relaxed);
+            if ((entry.mCheck.load(std::memory_order_relaxed) ^ value) == hash)
+            {
+                valueOut = value;
+                return true;
+            }
+        }
+        return false;
+    }
+
+} // namespace Snake
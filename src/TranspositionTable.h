@@ -0,0 +1,57 @@
+// TranspositionTable.h
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace Snake
+{
+    // Fixed-capacity hash table from 64-bit state hashes to 64-bit values, shared by searches on any number of threads
+    // Lock-free: an entry stores hash ^ value next to value, so a probe that races with a store sees a mismatched
+    // hash and misses instead of returning a torn entry. Entries sit in four-way buckets of one cache line; a store
+    // overwrites a matching or empty entry in its bucket, otherwise one picked by the hash.
+    // Hash zero marks empty entries, so it is never stored or found.
+    class TranspositionTable
+    {
+    public:
+        // Capacity in entries, rounded up to a whole number of buckets with a power of two bucket count
+        explicit TranspositionTable(size_t capacity);
+        ~TranspositionTable();
+
+        TranspositionTable(const TranspositionTable&) = delete;
+        TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+        void Store(uint64_t hash, uint64_t value);
+        bool Probe(uint64_t hash, uint64_t& valueOut) const;
+
+        // Not safe to call while other threads use the table
+        void Clear();
+
+        size_t GetCapacity() const { return (mBucketMask + 1) * EntriesPerBucket; }
+
+    private:
+        static constexpr size_t EntriesPerBucket = 4;
+
+        class Entry
+        {
+        public:
+            std::atomic<uint64_t> mCheck;   // hash ^ value
+            std::atomic<uint64_t> mValue;
+        };
+
+        class alignas(64) Bucket
+        {
+        public:
+            Entry mEntries[EntriesPerBucket];
+        };
+
+        Bucket& GetBucket(uint64_t hash) const { return mBuckets[hash & mBucketMask]; }
+
+        std::unique_ptr<Bucket[]> mBuckets;
+        size_t                    mBucketMask;
+    };
+
+} // namespace Snake
@@ -0,0 +1,65 @@
+// TripleBuffer.h
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace Vnm
+{
+    // Lock-free handoff of the latest value from one producer thread to one consumer thread
+    // The producer fills its own slot and swaps it with the shared middle one; the consumer swaps the middle slot for its
+    // own only when something new was published. Neither side ever waits for the other, the producer may publish any
+    // number of values between reads, and the consumer always gets the newest complete one.
+    template<typename T> class TripleBuffer
+    {
+    public:
+        // Every slot is constructed from the same arguments, so slots that reserve capacity up front never allocate later
+        template<typename... Args> explicit TripleBuffer(const Args&... args)
+            : mSlots{ Slot(args...), Slot(args...), Slot(args...) }
+        {}
+
+        TripleBuffer(const TripleBuffer&) = delete;
+        TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+        // Producer side: the slot to fill next, then hands it over
+        T& GetWriteBuffer()                 { return mSlots[mWriteIndex].mValue; }
+        void Publish()
+        {
+            uint32_t previous = mShared.exchange(mWriteIndex | FreshBit, std::memory_order_acq_rel);
+            mWriteIndex = previous & IndexMask;
+        }
+
+        // Consumer side: takes the newest published value if there is one; false keeps the current read buffer
+        bool Acquire()
+        {
+            if ((mShared.load(std::memory_order_relaxed) & FreshBit) == 0)
+            {
+                return false;
+            }
+
+            uint32_t previous = mShared.exchange(mReadIndex, std::memory_order_acq_rel);
+            mReadIndex = previous & IndexMask;
+            return true;
+        }
+        const T& GetReadBuffer() const      { return mSlots[mReadIndex].mValue; }
+
+    private:
+        static constexpr uint32_t IndexMask = 3;
+        static constexpr uint32_t FreshBit = 4;
+
+        // Slots sit on separate cache lines, so filling one never slows reads of another
+        class alignas(64) Slot
+        {
+        public:
+            template<typename... Args> explicit Slot(const Args&... args) : mValue(args...) {}
+
+            T mValue;
+        };
+
+        Slot                  mSlots[3];
+        alignas(64) uint32_t  mWriteIndex = 0;      // Producer only
+        alignas(64) std::atomic<uint32_t> mShared{ 1 };
+        alignas(64) uint32_t  mReadIndex = 2;       // Consumer only
+    };
+}
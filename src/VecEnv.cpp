@@ -0,0 +1,124 @@
+// VecEnv.cpp
+
+#include "VecEnv.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <cstring>
+
+namespace Snake
+{
+    VecEnv::VecEnv(size_t numEnvs, uint64_t seed, size_t numThreads, uint64_t maxEpisodeActions)
+        : mEpisodeActions(numEnvs, 0)
+        , mMaxEpisodeActions(maxEpisodeActions)
+    {
+        assert(numEnvs > 0);
+
+        mSimulations.reserve(numEnvs);
+        for (size_t env = 0; env < numEnvs; env++)
+        {
+            mSimulations.emplace_back(seed + env);
+        }
+
+        if (numThreads > 1)
+        {
+            mPool = std::make_unique<Vnm::WorkStealingPool>(numThreads);
+        }
+    }
+
+    VecEnv::~VecEnv() = default;
+
+    size_t VecEnv::GetObservationSize() const
+    {
+        const BoardLayout& layout = mSimulations[0].GetBoard().GetLayout();
+        switch (mObservationConfig.mType)
+        {
+        case ObservationType::Grid:
+            return GetGridObservationSize(layout, mObservationConfig.mFormat);
+        case ObservationType::Egocentric:
+            return GetEgocentricObservationSize(mObservationConfig.mRadius, mObservationConfig.mFormat);
+        default:
+            return layout.GetNumCells();
+        }
+    }
+
+    void VecEnv::WriteObservation(size_t env, uint8_t* observation) const
+    {
+        const Simulation& simulation = mSimulations[env];
+        switch (mObservationConfig.mType)
+        {
+        case ObservationType::Grid:
+            EncodeGridObservation(simulation, mObservationConfig.mFormat, observation);
+            break;
+        case ObservationType::Egocentric:
+            EncodeEgocentricObservation(simulation, mObservationConfig.mRadius, mObservationConfig.mFormat, observation);
+            break;
+        default:
+            memcpy(observation, simulation.GetBoard().GetGamePieceTypes(), simulation.GetBoard().GetNumCells());
+            break;
+        }
+    }
+
+    void VecEnv::Reset(uint8_t* observations)
+    {
+        size_t observationSize = GetObservationSize();
+        for (size_t env = 0; env < GetNumEnvs(); env++)
+        {
+            mSimulations[env].Reset();
+            mEpisodeActions[env] = 0;
+            WriteObservation(env, observations + env * observationSize);
+        }
+    }
+
+    void VecEnv::StepEnv(size_t env, uint8_t action, float& rewardOut, uint8_t& doneOut, uint8_t* observation)
+    {
+        Simulation& simulation = mSimulations[env];
+
+        // The action applies on the first step; the head then carries on until it reaches the next cell
+        StepResult result = simulation.Step(action);
+        while (result == StepResult::Moved)
+        {
+            result = simulation.Step(0);
+        }
+
+        mEpisodeActions[env]++;
+        rewardOut = result == StepResult::AtePowerUp || result == StepResult::Won ? PowerUpReward :
+            result == StepResult::Died ? DeathReward : 0.0f;
+
+        bool truncated = mMaxEpisodeActions != 0 && mEpisodeActions[env] >= mMaxEpisodeActions;
+        doneOut = simulation.IsOver() || truncated ? 1 : 0;
+        if (doneOut)
+        {
+            // Fast reset from the board's baked initial state
+            simulation.Reset();
+            mEpisodeActions[env] = 0;
+        }
+
+        WriteObservation(env, observation);
+    }
+
+    void VecEnv::Step(const uint8_t* actions, float* rewards, uint8_t* dones, uint8_t* observations)
+    {
+        size_t numEnvs = GetNumEnvs();
+        size_t observationSize = GetObservationSize();
+        auto stepEnvs = [&](size_t firstEnv, size_t lastEnv)
+        {
+            for (size_t env = firstEnv; env < lastEnv; env++)
+            {
+                StepEnv(env, actions[env], rewards[env], dones[env], observations + env * observationSize);
+            }
+        };
+
+        if (mPool == nullptr)
+        {
+            stepEnvs(0, numEnvs);
+            return;
+        }
+
+        // Environments are independent and each task writes only its own slice of the output arrays
+        mPool->ParallelFor((numEnvs + EnvsPerTask - 1) / EnvsPerTask, [&](size_t, size_t taskIndex)
+        {
+            stepEnvs(taskIndex * EnvsPerTask, std::min((taskIndex + 1) * EnvsPerTask, numEnvs));
+        });
+    }
+
+} // namespace Snake
@@ -0,0 +1,79 @@
+// VecEnv.h
+
+#pragma once
+
+#include "ObservationEncoder.h"
+#include "Simulation.h"
+#include <memory>
+#include <vector>
+
+namespace Vnm
+{
+    class WorkStealingPool;
+}
+
+namespace Snake
+{
+    enum class ObservationType : uint8_t
+    {
+        CellTypes,      // GamePieceType of every cell in board index order, one byte each
+        Grid,           // Multi-channel voxel grid of the whole board
+        Egocentric,     // Multi-channel crop around the head in the snake's basis
+    };
+
+    class ObservationConfig
+    {
+    public:
+        ObservationType   mType = ObservationType::CellTypes;
+        ObservationFormat mFormat = ObservationFormat::UInt8;   // Grid and Egocentric only
+        int               mRadius = 4;                          // Egocentric only
+    };
+
+    // K independent games stepped together, for training agents against the rules
+    // An action is a set of Input* bits and advances its game until the head enters the next cell or the game ends.
+    // Results are written into caller-provided contiguous arrays indexed by environment. A finished game reports its
+    // final reward and done flag, then resets immediately and its observation is the first one of the new game.
+    class VecEnv
+    {
+    public:
+        static constexpr float PowerUpReward = 1.0f;
+        static constexpr float DeathReward = -1.0f;
+
+        // numThreads above one steps environments in parallel; maxEpisodeActions of zero means no limit
+        VecEnv(size_t numEnvs, uint64_t seed, size_t numThreads = 1, uint64_t maxEpisodeActions = 0);
+        ~VecEnv();
+
+        VecEnv(const VecEnv&) = delete;
+        VecEnv& operator=(const VecEnv&) = delete;
+
+        size_t GetNumEnvs() const           { return mSimulations.size(); }
+
+        // Changes what observations contain from the next Reset or Step on
+        void SetObservationConfig(const ObservationConfig& config) { mObservationConfig = config; }
+        const ObservationConfig& GetObservationConfig() const      { return mObservationConfig; }
+
+        // Bytes per environment observation
+        size_t GetObservationSize() const;
+
+        const Simulation& GetSimulation(size_t env) const { return mSimulations[env]; }
+
+        // Starts new games in every environment; observations holds GetNumEnvs() * GetObservationSize() bytes
+        void Reset(uint8_t* observations);
+
+        // actions, rewards and dones hold GetNumEnvs() entries, observations as for Reset
+        void Step(const uint8_t* actions, float* rewards, uint8_t* dones, uint8_t* observations);
+
+    private:
+        void StepEnv(size_t env, uint8_t action, float& rewardOut, uint8_t& doneOut, uint8_t* observation);
+        void WriteObservation(size_t env, uint8_t* observation) const;
+
+        static constexpr size_t EnvsPerTask = 64;
+
+        std::vector<Simulation>                 mSimulations;
+        std::vector<uint64_t>                   mEpisodeActions;
+        ObservationConfig                       mObservationConfig;
+        uint64_t                                mMaxEpisodeActions;
+        std::unique_ptr<Vnm::WorkStealingPool>  mPool;
+    };
+
+} // namespace Snake
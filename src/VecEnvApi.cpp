@@ -0,0 +1,85 @@
+// VecEnvApi.cpp
+
+#include "VecEnvApi.h"
+#include "VecEnv.h"
+#include <new>
+
+static_assert(SNAKE3D_ACTION_TURN_LEFT == Snake::InputTurnLeft, "Action bits must match simulation inputs");
+static_assert(SNAKE3D_ACTION_TURN_RIGHT == Snake::InputTurnRight, "Action bits must match simulation inputs");
+static_assert(SNAKE3D_ACTION_TILT_UP == Snake::InputTiltUp, "Action bits must match simulation inputs");
+static_assert(SNAKE3D_ACTION_TILT_DOWN == Snake::InputTiltDown, "Action bits must match simulation inputs");
+
+static_assert(SNAKE3D_OBSERVATION_CELL_TYPES == static_cast<uint32_t>(Snake::ObservationType::CellTypes), "Observation types must match");
+static_assert(SNAKE3D_OBSERVATION_GRID == static_cast<uint32_t>(Snake::ObservationType::Grid), "Observation types must match");
+static_assert(SNAKE3D_OBSERVATION_EGOCENTRIC == static_cast<uint32_t>(Snake::ObservationType::Egocentric), "Observation types must match");
+static_assert(SNAKE3D_FORMAT_UINT8 == static_cast<uint32_t>(Snake::ObservationFormat::UInt8), "Observation formats must match");
+static_assert(SNAKE3D_FORMAT_FLOAT16 == static_cast<uint32_t>(Snake::ObservationFormat::Float16), "Observation formats must match");
+
+struct Snake3D_VecEnv
+{
+    Snake3D_VecEnv(uint32_t numEnvs, uint64_t seed, uint32_t numThreads, uint64_t maxEpisodeActions)
+        : mVecEnv(numEnvs, seed, numThreads, maxEpisodeActions)
+    {}
+
+    Snake::VecEnv mVecEnv;
+};
+
+Snake3D_VecEnv* Snake3D_CreateVecEnv(uint32_t numEnvs, uint64_t seed, uint32_t numThreads, uint64_t maxEpisodeActions)
+{
+    if (numEnvs == 0)
+    {
+        return nullptr;
+    }
+
+    // Exceptions must not cross the C boundary
+    try
+    {
+        return new Snake3D_VecEnv(numEnvs, seed, numThreads, maxEpisodeActions);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void Snake3D_DestroyVecEnv(Snake3D_VecEnv* vecEnv)
+{
+    delete vecEnv;
+}
+
+uint32_t Snake3D_GetNumEnvs(const Snake3D_VecEnv* vecEnv)
+{
+    return static_cast<uint32_t>(vecEnv->mVecEnv.GetNumEnvs());
+}
+
+int Snake3D_SetObservation(Snake3D_VecEnv* vecEnv, uint32_t type, uint32_t format, int32_t radius)
+{
+    const Snake::BoardLayout& layout = vecEnv->mVecEnv.GetSimulation(0).GetBoard().GetLayout();
+    if (type > SNAKE3D_OBSERVATION_EGOCENTRIC || format > SNAKE3D_FORMAT_FLOAT16 || radius < 0 ||
+        radius > Snake::GetMaxEgocentricRadius(layout))
+    {
+        return 0;
+    }
+
+    Snake::ObservationConfig config;
+    config.mType = static_cast<Snake::ObservationType>(type);
+    config.mFormat = static_cast<Snake::ObservationFormat>(format);
+    config.mRadius = radius;
+    vecEnv->mVecEnv.SetObservationConfig(config);
+    return 1;
+}
+
+size_t Snake3D_GetObservationSize(const Snake3D_VecEnv* vecEnv)
+{
+    return vecEnv->mVecEnv.GetObservationSize();
+}
+
+void Snake3D_ResetVecEnv(Snake3D_VecEnv* vecEnv, uint8_t* observations)
+{
+    vecEnv->mVecEnv.Reset(observations);
+}
+
+void Snake3D_StepVecEnv(Snake3D_VecEnv* vecEnv, const uint8_t* actions, float* rewards, uint8_t* dones, uint8_t* observations)
+{
+    vecEnv->mVecEnv.Step(actions, rewards, dones, observations);
+}
@@ -0,0 +1,65 @@
+// VecEnvApi.h
+
+// Plain C interface to Snake::VecEnv, for trainers loading the library through an FFI
+// Every buffer is caller owned and contiguous, so it can be a view of a tensor or numpy array with no copies
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32) && defined(SNAKE3D_BUILD_SHARED)
+#define SNAKE3D_API __declspec(dllexport)
+#elif defined(_WIN32) && defined(SNAKE3D_USE_SHARED)
+#define SNAKE3D_API __declspec(dllimport)
+#elif defined(__GNUC__)
+#define SNAKE3D_API __attribute__((visibility("default")))
+#else
+#define SNAKE3D_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Action bits, matching Snake::Input*
+#define SNAKE3D_ACTION_TURN_LEFT  1u
+#define SNAKE3D_ACTION_TURN_RIGHT 2u
+#define SNAKE3D_ACTION_TILT_UP    4u
+#define SNAKE3D_ACTION_TILT_DOWN  8u
+
+// Observation types and formats, matching Snake::ObservationType and Snake::ObservationFormat
+#define SNAKE3D_OBSERVATION_CELL_TYPES 0u
+#define SNAKE3D_OBSERVATION_GRID       1u
+#define SNAKE3D_OBSERVATION_EGOCENTRIC 2u
+
+#define SNAKE3D_FORMAT_UINT8   0u
+#define SNAKE3D_FORMAT_FLOAT16 1u
+
+typedef struct Snake3D_VecEnv Snake3D_VecEnv;
+
+// Environment i is seeded with seed + i; numThreads of 0 or 1 steps on the calling thread
+// maxEpisodeActions of 0 means episodes only end on death or a full board. Returns NULL on failure.
+SNAKE3D_API Snake3D_VecEnv* Snake3D_CreateVecEnv(uint32_t numEnvs, uint64_t seed, uint32_t numThreads, uint64_t maxEpisodeActions);
+SNAKE3D_API void Snake3D_DestroyVecEnv(Snake3D_VecEnv* vecEnv);
+
+SNAKE3D_API uint32_t Snake3D_GetNumEnvs(const Snake3D_VecEnv* vecEnv);
+
+// Selects the observation written from the next reset or step on; defaults to cell types
+// Cell types are one byte per cell (0 empty, 1 body, 2 power-up, 3 wall), x fastest. Grid and egocentric observations
+// are channel planes of wall, body age, power-up and head, the egocentric crop being 2 * radius + 1 cells on each side.
+// Returns 0 on invalid arguments, including a radius above the largest board dimension less one.
+SNAKE3D_API int Snake3D_SetObservation(Snake3D_VecEnv* vecEnv, uint32_t type, uint32_t format, int32_t radius);
+
+// Bytes per environment observation
+SNAKE3D_API size_t Snake3D_GetObservationSize(const Snake3D_VecEnv* vecEnv);
+
+// observations: numEnvs * observation size bytes
+SNAKE3D_API void Snake3D_ResetVecEnv(Snake3D_VecEnv* vecEnv, uint8_t* observations);
+
+// actions, rewards, dones: numEnvs entries each; finished environments reset automatically
+SNAKE3D_API void Snake3D_StepVecEnv(Snake3D_VecEnv* vecEnv, const uint8_t* actions, float* rewards, uint8_t* dones, uint8_t* observations);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,149 @@
+// WorkStealingPool.cpp
+
+#include "WorkStealingPool.h"
+
+namespace Vnm
+{
+    WorkStealingPool::WorkStealingPool(size_t numThreads)
+        : mNumThreads(numThreads > 0 ? numThreads : 1)
+        , mRanges(new WorkRange[mNumThreads])
+    {
+        for (size_t i = 1; i < mNumThreads; i++)
+        {
+            mThreads.emplace_back(&WorkStealingPool::WorkerMain, this, i);
+        }
+    }
+
+    WorkStealingPool::~WorkStealingPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mJobMutex);
+            mShutdown = true;
+        }
+        mJobStarted.notify_all();
+
+        for (std::thread& thread : mThreads)
+        {
+            thread.join();
+        }
+    }
+
+    void WorkStealingPool::ParallelFor(size_t numTasks, const Task& task)
+    {
+        if (numTasks == 0)
+        {
+            return;
+        }
+
+        // Hand each worker a contiguous share up front; stealing only has to fix up the imbalance
+        for (size_t i = 0; i < mNumThreads; i++)
+        {
+            std::lock_guard<std::mutex> lock(mRanges[i].mMutex);
+            mRanges[i].mBegin = numTasks * i / mNumThreads;
+            mRanges[i].mEnd = numTasks * (i + 1) / mNumThreads;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mJobMutex);
+            mTask = &task;
+            mJobId++;
+            mNumBusyWorkers = mNumThreads - 1;
+        }
+        mJobStarted.notify_all();
+
+        RunTasks(0);
+
+        std::unique_lock<std::mutex> lock(mJobMutex);
+        mJobFinished.wait(lock, [this] { return mNumBusyWorkers == 0; });
+        mTask = nullptr;
+    }
+
+    void WorkStealingPool::WorkerMain(size_t workerIndex)
+    {
+        uint64_t lastJobId = 0;
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mJobMutex);
+                mJobStarted.wait(lock, [this, lastJobId] { return mShutdown || mJobId != lastJobId; });
+                if (mShutdown)
+                {
+                    return;
+                }
+                lastJobId = mJobId;
+            }
+
+            RunTasks(workerIndex);
+
+            bool lastWorker;
+            {
+                std::lock_guard<std::mutex> lock(mJobMutex);
+                lastWorker = --mNumBusyWorkers == 0;
+            }
+            if (lastWorker)
+            {
+                mJobFinished.notify_one();
+            }
+        }
+    }
+
+    void WorkStealingPool::RunTasks(size_t workerIndex)
+    {
+        // No task ever creates more tasks, so once nothing is left to steal this worker is done
+        do
+        {
+            size_t taskIndex;
+            while (PopTask(workerIndex, taskIndex))
+            {
+                (*mTask)(workerIndex, taskIndex);
+            }
+        } while (StealTasks(workerIndex));
+    }
+
+    bool WorkStealingPool::PopTask(size_t workerIndex, size_t& taskOut)
+    {
+        WorkRange& range = mRanges[workerIndex];
+        std::lock_guard<std::mutex> lock(range.mMutex);
+        if (range.mBegin == range.mEnd)
+        {
+            return false;
+        }
+
+        taskOut = range.mBegin++;
+        return true;
+    }
+
+    // Moves the back half of the first non-empty range found into this worker's own, which is empty
+    bool WorkStealingPool::StealTasks(size_t workerIndex)
+    {
+        for (size_t i = 1; i < mNumThreads; i++)
+        {
+            WorkRange& victim = mRanges[(workerIndex + i) % mNumThreads];
+
+            size_t stolenBegin;
+            size_t stolenEnd;
+            {
+                std::lock_guard<std::mutex> lock(victim.mMutex);
+                size_t remaining = victim.mEnd - victim.mBegin;
+                if (remaining == 0)
+                {
+                    continue;
+                }
+
+                stolenEnd = victim.mEnd;
+                stolenBegin = stolenEnd - (remaining + 1) / 2;
+                victim.mEnd = stolenBegin;
+            }
+
+            // Nobody steals from an empty range, so this worker's own range can't have changed meanwhile
+            WorkRange& range = mRanges[workerIndex];
+            std::lock_guard<std::mutex> lock(range.mMutex);
+            range.mBegin = stolenBegin;
+            range.mEnd = stolenEnd;
+            return true;
+        }
+
+        return false;
+    }
+
+} // namespace Vnm
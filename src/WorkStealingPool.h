@@ -0,0 +1,63 @@
+// WorkStealingPool.h
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Vnm
+{
+    // Persistent worker threads running fork-join parallel loops
+    // Each worker starts with a contiguous share of the task indices and takes tasks from the front of it; a worker that
+    // runs dry steals the back half of another worker's remaining range, so uneven task costs still balance out.
+    // The calling thread joins in as worker 0.
+    class WorkStealingPool
+    {
+    public:
+        using Task = std::function<void(size_t workerIndex, size_t taskIndex)>;
+
+        explicit WorkStealingPool(size_t numThreads = std::thread::hardware_concurrency());
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool&) = delete;
+        WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+        // Runs task for every index in [0, numTasks) and returns once all of them have finished
+        void ParallelFor(size_t numTasks, const Task& task);
+
+        size_t GetNumThreads() const { return mNumThreads; }
+
+    private:
+        // Remaining task range of one worker, padded so workers never share a cache line
+        class alignas(64) WorkRange
+        {
+        public:
+            std::mutex mMutex;
+            size_t     mBegin = 0;
+            size_t     mEnd = 0;
+        };
+
+        void WorkerMain(size_t workerIndex);
+        void RunTasks(size_t workerIndex);
+        bool PopTask(size_t workerIndex, size_t& taskOut);
+        bool StealTasks(size_t workerIndex);
+
+        size_t                       mNumThreads;
+        std::unique_ptr<WorkRange[]> mRanges;
+        std::vector<std::thread>     mThreads;
+
+        std::mutex              mJobMutex;
+        std::condition_variable mJobStarted;
+        std::condition_variable mJobFinished;
+        const Task*             mTask = nullptr;
+        uint64_t                mJobId = 0;
+        size_t                  mNumBusyWorkers = 0;
+        bool                    mShutdown = false;
+    };
+
+} // namespace Vnm
@@ -0,0 +1,50 @@
+// Zobrist.h
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Snake
+{
+    // Zobrist keys for hashing game state
+    // Keys come from a fixed mixing function of the feature rather than a random table, so they take no memory and
+    // are identical on every platform, board size and run. Each kind of feature has its own tag in the low bits.
+    inline uint64_t ZobristKey(uint64_t feature)
+    {
+        feature += 0x9e3779b97f4a7c15ull;
+        feature = (feature ^ (feature >> 30)) * 0xbf58476d1ce4e5b9ull;
+        feature = (feature ^ (feature >> 27)) * 0x94d049bb133111ebull;
+        return feature ^ (feature >> 31);
+    }
+
+    // Piece of the given type, as its underlying value, in a cell
+    inline uint64_t ZobristCellKey(size_t cellIndex, uint8_t gamePieceType)
+    {
+        return ZobristKey((static_cast<uint64_t>(cellIndex) << 10) | (static_cast<uint64_t>(gamePieceType) << 2) | 0);
+    }
+
+    // Head position in simulation units
+    inline uint64_t ZobristHeadKey(const int position[3])
+    {
+        uint64_t packed = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            packed |= (static_cast<uint64_t>(position[axis]) & 0xfffff) << (20 * axis);
+        }
+        return ZobristKey((packed << 2) | 1);
+    }
+
+    // Head orientation from its axis-aligned forward and up vectors
+    inline uint64_t ZobristBasisKey(const int forward[3], const int up[3])
+    {
+        uint64_t packed = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            packed |= static_cast<uint64_t>(forward[axis] + 1) << (2 * axis);
+            packed |= static_cast<uint64_t>(up[axis] + 1) << (2 * axis + 6);
+        }
+        return ZobristKey((packed << 2) | 2);
+    }
+
+} // namespace Snake